@@ -0,0 +1,289 @@
+// AccuracyMain.cpp
+//
+// Entry point of the accuracy harness, a console application built from
+// this file plus ReferenceExtractors, TestSignals, FeatureExtractors,
+// AnalysisProfiler and TraceRecorder. It is not part of the plugin target.
+//
+// Each production extractor is run next to its frozen reference over the
+// golden signals (the standard test set plus edge cases) and a number of
+// randomised ones: random sample rate, length, channel count, material,
+// window and hop. Per output it reports the largest and mean absolute
+// deviation against a tolerance, alongside the speedup of the production raw
+// analysis over the reference. A different number of points or any shifted
+// breakpoint time fails outright.
+
+#include <JuceHeader.h>
+#include "FeatureExtractors.h"
+#include "ReferenceExtractors.h"
+#include "TestSignals.h"
+#include <iostream>
+
+namespace {
+
+struct Deviation {
+    double maxError = 0.0;
+    double sumError = 0.0;
+    juce::int64 numPoints = 0;
+    juce::String worstCase;
+    bool structureMismatch = false;
+
+    double getMeanError() const { return numPoints > 0 ? sumError / numPoints : 0.0; }
+};
+
+struct FeatureReport {
+    std::vector<Deviation> outputs;
+    double referenceSeconds = 0.0;
+    double productionSeconds = 0.0;
+};
+
+struct Tolerances {
+    double defaultTolerance = 1.0e-5;
+    std::map<juce::String, double> overrides; // "Feature" or "Feature/Output"
+
+    double get(const juce::String& feature, const juce::String& output) const {
+        auto it = overrides.find(feature + "/" + output);
+        if (it != overrides.end()) return it->second;
+        it = overrides.find(feature);
+        return it != overrides.end() ? it->second : defaultTolerance;
+    }
+};
+
+template <typename Function>
+double timeBestOf(int repeats, Function&& fn) {
+    double best = std::numeric_limits<double>::max();
+    for (int run = 0; run < repeats; ++run) {
+        auto start = juce::Time::getHighResolutionTicks();
+        fn();
+        best = juce::jmin(best, juce::Time::highResolutionTicksToSeconds(
+            juce::Time::getHighResolutionTicks() - start));
+    }
+    return best;
+}
+
+void compareOutputs(const std::vector<BreakpointList>& expected, const std::vector<BreakpointList>& actual,
+    const juce::String& caseName, FeatureReport& report) {
+
+    report.outputs.resize(juce::jmax(report.outputs.size(), expected.size()));
+
+    for (size_t output = 0; output < expected.size(); ++output) {
+        auto& deviation = report.outputs[output];
+
+        if (output >= actual.size() || actual[output].size() != expected[output].size()) {
+            deviation.structureMismatch = true;
+            deviation.worstCase = caseName + " (point count)";
+            continue;
+        }
+
+        for (size_t i = 0; i < expected[output].size(); ++i) {
+            const auto& e = expected[output][i];
+            const auto& a = actual[output][i];
+
+            if (std::abs(e.first - a.first) > 1.0e-9) {
+                deviation.structureMismatch = true;
+                deviation.worstCase = caseName + " (time at point " + juce::String(static_cast<int>(i)) + ")";
+                break;
+            }
+
+            // NaN on either side counts as an unbounded deviation unless both agree.
+            double error = std::isnan(e.second) || std::isnan(a.second)
+                ? (std::isnan(e.second) && std::isnan(a.second) ? 0.0 : std::numeric_limits<double>::infinity())
+                : std::abs(e.second - a.second);
+
+            if (error > deviation.maxError) {
+                deviation.maxError = error;
+                deviation.worstCase = caseName + " @ " + juce::String(e.first, 4) + " s";
+            }
+            deviation.sumError += std::isfinite(error) ? error : 0.0;
+            ++deviation.numPoints;
+        }
+    }
+}
+
+void runCase(const juce::String& featureName, const TestSignal& signal, const FeatureExtractor::Settings& settings,
+    int repeats, FeatureReport& report) {
+
+    auto reference = ReferenceExtractors::create(featureName);
+    auto production = FeatureExtractorFactory::createExtractor(featureName);
+    if (reference == nullptr || production == nullptr) return;
+
+    reference->settings = settings;
+    production->settings = settings;
+
+    std::vector<BreakpointList> expected, actual;
+    report.referenceSeconds += timeBestOf(repeats, [&] {
+        expected = reference->extractRaw(signal.audio, signal.sampleRate, 0);
+    });
+    report.productionSeconds += timeBestOf(repeats, [&] {
+        actual = production->extractRaw(signal.audio, signal.sampleRate, 0);
+    });
+
+    // Post-processing is shared code, so it is compared through it too.
+    reference->postProcess(expected);
+    production->postProcess(actual);
+
+    auto caseName = signal.name + " " + juce::String(signal.sampleRate, 0) + " Hz "
+        + juce::String(settings.windowSizeMs, 1) + " ms/" + juce::String(settings.hopSizePct, 0) + "%";
+    compareOutputs(expected, actual, caseName, report);
+}
+
+std::vector<TestSignal> makeGoldenSignals(juce::int64 seed) {
+    std::vector<TestSignal> signals;
+    for (double sampleRate : { 44100.0, 48000.0 }) {
+        for (auto& signal : TestSignals::makeStandardSet(sampleRate, 3.0, seed))
+            signals.push_back(std::move(signal));
+    }
+
+    // Edge cases: silence, a file shorter than any analysis frame, mono
+    // input to the stereo features and a full-scale square wave.
+    auto silence = TestSignals::whiteNoise(44100.0, 1.0, 2, seed);
+    silence.name = "silence";
+    silence.audio.clear();
+    signals.push_back(std::move(silence));
+
+    auto tiny = TestSignals::whiteNoise(44100.0, 0.002, 2, seed);
+    tiny.name = "tiny";
+    signals.push_back(std::move(tiny));
+
+    auto mono = TestSignals::sineSweep(96000.0, 2.0, 1);
+    mono.name = "mono";
+    signals.push_back(std::move(mono));
+
+    auto square = TestSignals::sineSweep(44100.0, 2.0, 2, 50.0, 5000.0);
+    square.name = "square";
+    for (int ch = 0; ch < square.audio.getNumChannels(); ++ch) {
+        float* data = square.audio.getWritePointer(ch);
+        for (int i = 0; i < square.audio.getNumSamples(); ++i)
+            data[i] = data[i] >= 0.0f ? 1.0f : -1.0f;
+    }
+    signals.push_back(std::move(square));
+    return signals;
+}
+
+TestSignal makeRandomSignal(juce::Random& random, int index) {
+    const double sampleRates[] = { 22050.0, 44100.0, 48000.0, 88200.0, 96000.0 };
+    double sampleRate = sampleRates[random.nextInt(5)];
+    double seconds = 0.05 + random.nextDouble() * 2.0;
+    int numChannels = 1 + random.nextInt(2);
+
+    TestSignal signal;
+    switch (random.nextInt(4)) {
+    case 0:
+        signal = TestSignals::sineSweep(sampleRate, seconds, numChannels,
+            20.0 + random.nextDouble() * 500.0, 1000.0 + random.nextDouble() * 20000.0);
+        break;
+    case 1:
+        signal = TestSignals::whiteNoise(sampleRate, seconds, numChannels, random.nextInt64());
+        break;
+    case 2:
+        signal = TestSignals::impulseTrain(sampleRate, seconds, numChannels, 1.0 + random.nextDouble() * 40.0);
+        break;
+    default:
+        signal = TestSignals::decorrelatedStereo(sampleRate, seconds, random.nextInt64());
+        break;
+    }
+
+    // Random gain, occasionally far below or above nominal level.
+    signal.audio.applyGain(static_cast<float>(std::pow(10.0, random.nextDouble() * 6.0 - 4.0)));
+    signal.name = "random#" + juce::String(index) + " " + signal.name;
+    return signal;
+}
+
+void printUsage() {
+    std::cout <<
+        "Usage: AudioDeconstructorAccuracy [options]\n"
+        "\n"
+        "  --features=Amplitude,Pitch      extractors to check (default: all)\n"
+        "  --trials=20                     randomised signals per feature\n"
+        "  --seed=1                        seed for the randomised signals\n"
+        "  --repeats=1                     timing runs per case, the fastest is kept\n"
+        "  --tolerance=1e-5                default absolute tolerance\n"
+        "  --tolerances=Pitch:0.5,Spectral/Flatness:1e-4\n"
+        "                                  per feature or feature/output tolerances\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    juce::ArgumentList args(argc, argv);
+
+    if (args.containsOption("--help|-h")) {
+        printUsage();
+        return 0;
+    }
+
+    int trials = args.containsOption("--trials") ? juce::jmax(0, args.getValueForOption("--trials").getIntValue()) : 20;
+    int repeats = juce::jmax(1, args.getValueForOption("--repeats").getIntValue());
+    juce::int64 seed = args.containsOption("--seed") ? args.getValueForOption("--seed").getLargeIntValue() : 1;
+
+    Tolerances tolerances;
+    if (args.containsOption("--tolerance"))
+        tolerances.defaultTolerance = args.getValueForOption("--tolerance").getDoubleValue();
+
+    juce::StringArray entries;
+    entries.addTokens(args.getValueForOption("--tolerances"), ",", {});
+    for (const auto& entry : entries) {
+        auto key = entry.upToLastOccurrenceOf(":", false, false).trim();
+        if (key.isNotEmpty())
+            tolerances.overrides[key] = entry.fromLastOccurrenceOf(":", false, false).getDoubleValue();
+    }
+
+    auto features = FeatureExtractorFactory::getAvailableFeatures();
+    if (args.containsOption("--features")) {
+        features.clear();
+        features.addTokens(args.getValueForOption("--features"), ",", {});
+        features.trim();
+        features.removeEmptyStrings();
+    }
+
+    auto golden = makeGoldenSignals(seed);
+    bool allPassed = true;
+
+    for (const auto& featureName : features) {
+        auto extractor = FeatureExtractorFactory::createExtractor(featureName);
+        if (extractor == nullptr || ReferenceExtractors::create(featureName) == nullptr) {
+            std::cerr << "No reference for " << featureName << "\n";
+            return 1;
+        }
+
+        FeatureReport report;
+        FeatureExtractor::Settings defaults;
+
+        for (const auto& signal : golden)
+            runCase(featureName, signal, defaults, repeats, report);
+
+        juce::Random random(seed);
+        for (int trial = 0; trial < trials; ++trial) {
+            auto signal = makeRandomSignal(random, trial);
+
+            FeatureExtractor::Settings settings;
+            settings.windowSizeMs = static_cast<float>(1.0 + random.nextDouble() * 99.0);
+            settings.hopSizePct = static_cast<float>(10.0 + random.nextDouble() * 80.0);
+            settings.normalizeOutput = random.nextBool();
+            settings.smoothOutput = random.nextBool();
+            settings.smoothTimeMs = static_cast<float>(1.0 + random.nextDouble() * 49.0);
+
+            runCase(featureName, signal, settings, repeats, report);
+        }
+
+        double speedup = report.productionSeconds > 0.0 ? report.referenceSeconds / report.productionSeconds : 0.0;
+        std::cout << featureName << "  speedup x" << juce::String(speedup, 2) << "\n";
+
+        for (size_t output = 0; output < report.outputs.size(); ++output) {
+            const auto& deviation = report.outputs[output];
+            auto outputName = extractor->getOutputName(static_cast<int>(output));
+            double tolerance = tolerances.get(featureName, outputName);
+            bool passed = !deviation.structureMismatch && deviation.maxError <= tolerance;
+            allPassed = allPassed && passed;
+
+            std::cout << "  " << (passed ? "PASS " : "FAIL ") << outputName.paddedRight(' ', 16)
+                << " max " << juce::String(deviation.maxError, 9)
+                << "  mean " << juce::String(deviation.getMeanError(), 9)
+                << "  tolerance " << juce::String(tolerance, 9) << "\n";
+
+            if (!passed && deviation.worstCase.isNotEmpty())
+                std::cout << "       worst: " << deviation.worstCase << "\n";
+        }
+    }
+
+    return allPassed ? 0 : 1;
+}
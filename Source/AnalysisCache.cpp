@@ -0,0 +1,259 @@
+// AnalysisCache.cpp
+
+#include "AnalysisCache.h"
+#include <cstring>
+
+namespace {
+
+constexpr juce::uint64 prime1 = 0x9E3779B185EBCA87ULL;
+constexpr juce::uint64 prime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr juce::uint64 prime3 = 0x165667B19E3779F9ULL;
+
+inline juce::uint64 rotl(juce::uint64 x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline juce::uint64 round64(juce::uint64 acc, juce::uint64 input) {
+    acc += input * prime2;
+    return rotl(acc, 31) * prime1;
+}
+
+inline juce::uint64 avalanche(juce::uint64 h) {
+    h ^= h >> 33;
+    h *= prime2;
+    h ^= h >> 29;
+    h *= prime3;
+    h ^= h >> 32;
+    return h;
+}
+
+// xxHash64-style hash with four independent lanes, so hashing a decoded file
+// runs at memory bandwidth rather than at one multiply chain per word.
+juce::uint64 hashBytes(const void* data, size_t size, juce::uint64 seed) {
+    auto* p = static_cast<const juce::uint8*>(data);
+    auto* end = p + size;
+
+    juce::uint64 lanes[4] = { seed + prime1 + prime2, seed + prime2, seed, seed - prime1 };
+
+    while (end - p >= 32) {
+        for (auto& lane : lanes) {
+            juce::uint64 word;
+            std::memcpy(&word, p, sizeof(word));
+            lane = round64(lane, word);
+            p += sizeof(word);
+        }
+    }
+
+    juce::uint64 h = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+    h += static_cast<juce::uint64>(size);
+
+    while (end - p >= 8) {
+        juce::uint64 word;
+        std::memcpy(&word, p, sizeof(word));
+        h = rotl(h ^ round64(0, word), 27) * prime1 + prime3;
+        p += 8;
+    }
+    while (p < end)
+        h = rotl(h ^ (*p++ * prime3), 11) * prime1;
+
+    return avalanche(h);
+}
+
+template <typename T>
+juce::uint64 hashValue(juce::uint64 seed, T value) {
+    return hashBytes(&value, sizeof(value), seed);
+}
+
+} // namespace
+
+juce::uint64 AnalysisCache::Key::getHash() const {
+    juce::uint64 h = hashBytes(extractorName.toRawUTF8(), extractorName.getNumBytesAsUTF8(), audioHash);
+    h = hashValue(h, extractorVersion);
+    h = hashValue(h, settingsHash);
+    return hashValue(h, channel);
+}
+
+juce::String AnalysisCache::Key::getFileName() const {
+    return juce::String::toHexString(static_cast<juce::int64>(getHash())).paddedLeft('0', 16) + ".adac";
+}
+
+bool AnalysisCache::Key::operator==(const Key& other) const {
+    return audioHash == other.audioHash && extractorName == other.extractorName
+        && extractorVersion == other.extractorVersion && settingsHash == other.settingsHash
+        && channel == other.channel;
+}
+
+AnalysisCache::AnalysisCache(const juce::File& dir, juce::int64 maxSize)
+    : directory(dir), maxSizeBytes(maxSize) {}
+
+juce::File AnalysisCache::getDefaultDirectory() {
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("AudioDeconstructor")
+        .getChildFile("AnalysisCache");
+}
+
+juce::uint64 AnalysisCache::hashAudio(const juce::AudioBuffer<float>& buffer, double sampleRate) {
+    juce::uint64 h = hashValue(0, sampleRate);
+    h = hashValue(h, buffer.getNumChannels());
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch) {
+        h = hashBytes(buffer.getReadPointer(ch),
+            sizeof(float) * static_cast<size_t>(buffer.getNumSamples()), h);
+    }
+    return h;
+}
+
+juce::uint64 AnalysisCache::hashSettings(const FeatureExtractor::Settings& settings) {
+    juce::uint64 h = hashValue(0, settings.windowSizeMs);
+    h = hashValue(h, settings.hopSizePct);
+    h = hashValue(h, settings.normalizeOutput);
+    h = hashValue(h, settings.minValue);
+    h = hashValue(h, settings.maxValue);
+    h = hashValue(h, settings.smoothOutput);
+    h = hashValue(h, settings.smoothTimeMs);
+
+    // Only mixed in when set, so keys stored before it existed still match.
+    if (settings.decimatedAnalysis)
+        h = hashValue(h, settings.decimatedAnalysis);
+    return h;
+}
+
+juce::File AnalysisCache::getEntryFile(const Key& key) const {
+    return directory.getChildFile(key.getFileName());
+}
+
+bool AnalysisCache::lookup(const Key& key, std::vector<BreakpointList>& outputs) {
+    auto file = getEntryFile(key);
+    if (!file.existsAsFile()) return false;
+
+    juce::FileInputStream stream(file);
+    if (!stream.openedOk()) return false;
+
+    if (stream.readInt() != entryMagic || stream.readInt() != entryVersion) return false;
+
+    // The file name is only a hash of the key, so the full key is stored
+    // and compared to rule out collisions.
+    Key stored;
+    stored.audioHash = static_cast<juce::uint64>(stream.readInt64());
+    stored.extractorName = stream.readString();
+    stored.extractorVersion = stream.readInt();
+    stored.settingsHash = static_cast<juce::uint64>(stream.readInt64());
+    stored.channel = stream.readInt();
+    if (!(stored == key)) return false;
+
+    int numOutputs = stream.readInt();
+    if (numOutputs < 0 || numOutputs > 256) return false;
+
+    std::vector<BreakpointList> result(static_cast<size_t>(numOutputs));
+    std::vector<double> column;
+
+    for (auto& output : result) {
+        auto count = stream.readInt64();
+        auto columnBytes = count * static_cast<juce::int64>(sizeof(double));
+        if (count < 0 || columnBytes * 2 > stream.getNumBytesRemaining()) return false;
+
+        output.resize(static_cast<size_t>(count));
+        column.resize(static_cast<size_t>(count));
+
+        if (stream.read(column.data(), static_cast<int>(columnBytes)) != columnBytes)
+            return false;
+        for (size_t i = 0; i < column.size(); ++i) output[i].first = column[i];
+
+        if (stream.read(column.data(), static_cast<int>(columnBytes)) != columnBytes)
+            return false;
+        for (size_t i = 0; i < column.size(); ++i) output[i].second = column[i];
+    }
+
+    outputs = std::move(result);
+    file.setLastAccessTime(juce::Time::getCurrentTime());
+    return true;
+}
+
+void AnalysisCache::store(const Key& key, const std::vector<BreakpointList>& outputs) {
+    if (!directory.isDirectory() && directory.createDirectory().failed()) return;
+
+    auto file = getEntryFile(key);
+    juce::TemporaryFile temp(file);
+
+    {
+        juce::FileOutputStream stream(temp.getFile());
+        if (!stream.openedOk()) return;
+
+        stream.writeInt(entryMagic);
+        stream.writeInt(entryVersion);
+        stream.writeInt64(static_cast<juce::int64>(key.audioHash));
+        stream.writeString(key.extractorName);
+        stream.writeInt(key.extractorVersion);
+        stream.writeInt64(static_cast<juce::int64>(key.settingsHash));
+        stream.writeInt(key.channel);
+        stream.writeInt(static_cast<int>(outputs.size()));
+
+        std::vector<double> column;
+        for (const auto& output : outputs) {
+            stream.writeInt64(static_cast<juce::int64>(output.size()));
+            column.resize(output.size());
+
+            for (size_t i = 0; i < output.size(); ++i) column[i] = output[i].first;
+            stream.write(column.data(), column.size() * sizeof(double));
+            for (size_t i = 0; i < output.size(); ++i) column[i] = output[i].second;
+            stream.write(column.data(), column.size() * sizeof(double));
+        }
+
+        stream.flush();
+        if (stream.getStatus().failed()) return;
+    }
+
+    if (!temp.overwriteTargetFileWithTemporary()) return;
+
+    const juce::ScopedLock sl(lock);
+    if (knownSizeBytes >= 0)
+        knownSizeBytes += file.getSize();
+    evictToFit();
+}
+
+void AnalysisCache::setMaxSize(juce::int64 newMaxSizeBytes) {
+    const juce::ScopedLock sl(lock);
+    maxSizeBytes = newMaxSizeBytes;
+    evictToFit();
+}
+
+void AnalysisCache::clear() {
+    const juce::ScopedLock sl(lock);
+    for (const auto& entry : juce::RangedDirectoryIterator(directory, false, "*.adac"))
+        entry.getFile().deleteFile();
+    knownSizeBytes = 0;
+}
+
+juce::int64 AnalysisCache::scanDirectorySize() const {
+    juce::int64 total = 0;
+    for (const auto& entry : juce::RangedDirectoryIterator(directory, false, "*.adac"))
+        total += entry.getFileSize();
+    return total;
+}
+
+void AnalysisCache::evictToFit() {
+    // The running total is only an estimate when several instances share the
+    // directory, so rescan before deciding anything is actually over budget.
+    if (knownSizeBytes >= 0 && knownSizeBytes <= maxSizeBytes) return;
+
+    knownSizeBytes = scanDirectorySize();
+    if (knownSizeBytes <= maxSizeBytes) return;
+
+    struct Entry {
+        juce::File file;
+        juce::Time lastAccess;
+        juce::int64 size;
+    };
+
+    std::vector<Entry> entries;
+    for (const auto& entry : juce::RangedDirectoryIterator(directory, false, "*.adac"))
+        entries.push_back({ entry.getFile(), entry.getFile().getLastAccessTime(), entry.getFileSize() });
+
+    std::sort(entries.begin(), entries.end(),
+        [](const Entry& a, const Entry& b) { return a.lastAccess < b.lastAccess; });
+
+    for (const auto& entry : entries) {
+        if (knownSizeBytes <= maxSizeBytes) break;
+        if (entry.file.deleteFile())
+            knownSizeBytes -= entry.size;
+    }
+}
@@ -0,0 +1,59 @@
+// AnalysisCache.h
+#pragma once
+
+#include <JuceHeader.h>
+#include "FeatureExtractors.h"
+
+// Persistent cache of extractor results, addressed by what the result depends
+// on: a hash of the decoded audio, the extractor name and version, its
+// settings and the analysed channel. Entries are stored column-wise (all times
+// of an output, then all values) as raw doubles, so a hit reproduces the
+// extraction exactly. The directory is kept under a size budget by evicting
+// the least recently used entries.
+class AnalysisCache {
+public:
+    struct Key {
+        juce::uint64 audioHash = 0;
+        juce::String extractorName;
+        int extractorVersion = 0;
+        juce::uint64 settingsHash = 0;
+        int channel = 0;
+
+        juce::uint64 getHash() const;
+        juce::String getFileName() const;
+        bool operator==(const Key& other) const;
+    };
+
+    explicit AnalysisCache(const juce::File& directory,
+        juce::int64 maxSizeBytes = defaultMaxSizeBytes);
+
+    static juce::File getDefaultDirectory();
+
+    static juce::uint64 hashAudio(const juce::AudioBuffer<float>& buffer, double sampleRate);
+    static juce::uint64 hashSettings(const FeatureExtractor::Settings& settings);
+
+    bool lookup(const Key& key, std::vector<BreakpointList>& outputs);
+    void store(const Key& key, const std::vector<BreakpointList>& outputs);
+
+    void setMaxSize(juce::int64 newMaxSizeBytes);
+    juce::int64 getMaxSize() const { return maxSizeBytes; }
+    void clear();
+
+    static constexpr juce::int64 defaultMaxSizeBytes = 512LL * 1024 * 1024;
+
+private:
+    static constexpr int entryMagic = 0x43414441; // "ADAC"
+    static constexpr int entryVersion = 1;
+
+    juce::File directory;
+    juce::int64 maxSizeBytes;
+
+    juce::CriticalSection lock;
+    juce::int64 knownSizeBytes = -1;
+
+    juce::File getEntryFile(const Key& key) const;
+    juce::int64 scanDirectorySize() const;
+    void evictToFit();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalysisCache)
+};
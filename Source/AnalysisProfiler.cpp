@@ -0,0 +1,87 @@
+// AnalysisProfiler.cpp
+
+#include "AnalysisProfiler.h"
+
+void AnalysisProfiler::reset() {
+    const juce::ScopedLock sl(lock);
+    stages.clear();
+}
+
+std::vector<AnalysisProfiler::Stage> AnalysisProfiler::getStages() const {
+    const juce::ScopedLock sl(lock);
+    return stages;
+}
+
+juce::String AnalysisProfiler::getSummary() const {
+    auto snapshot = getStages();
+    if (snapshot.empty())
+        return isEnabled() ? "No stages recorded yet" : "Profiling is off";
+
+    juce::String text;
+    text << juce::String("Stage").paddedRight(' ', 28) << juce::String("Calls").paddedLeft(' ', 6)
+        << juce::String("ms").paddedLeft(' ', 10) << juce::String("frames/s").paddedLeft(' ', 12)
+        << juce::String("KB").paddedLeft(' ', 10) << juce::String("points").paddedLeft(' ', 10) << "\n";
+
+    for (const auto& stage : snapshot) {
+        text << stage.name.paddedRight(' ', 28)
+            << juce::String(stage.calls).paddedLeft(' ', 6)
+            << juce::String(stage.totalSeconds * 1000.0, 2).paddedLeft(' ', 10)
+            << (stage.frames > 0 ? juce::String(stage.getFramesPerSecond(), 0) : juce::String("-")).paddedLeft(' ', 12)
+            << (stage.bytes > 0 ? juce::String(stage.bytes / 1024) : juce::String("-")).paddedLeft(' ', 10)
+            << (stage.breakpoints > 0 ? juce::String(stage.breakpoints) : juce::String("-")).paddedLeft(' ', 10)
+            << "\n";
+    }
+    return text;
+}
+
+void AnalysisProfiler::record(const char* stage, const juce::String& feature, double seconds,
+    juce::int64 frames, juce::int64 bytes, juce::int64 breakpoints) {
+
+    juce::String name = feature.isEmpty() ? juce::String(stage) : feature + ": " + stage;
+
+    const juce::ScopedLock sl(lock);
+    auto it = std::find_if(stages.begin(), stages.end(),
+        [&](const Stage& s) { return s.name == name; });
+    if (it == stages.end()) {
+        stages.push_back({});
+        it = std::prev(stages.end());
+        it->name = name;
+    }
+
+    ++it->calls;
+    it->totalSeconds += seconds;
+    it->lastSeconds = seconds;
+    it->frames += frames;
+    it->bytes += bytes;
+    it->breakpoints += breakpoints;
+}
+
+AnalysisProfiler::ScopedStage::ScopedStage(AnalysisProfiler* p, const char* s, const juce::String& f)
+    : profiler(p != nullptr && p->isEnabled() ? p : nullptr), stage(s) {
+    if (TraceRecorder::isRecording())
+        traceToken = TraceRecorder::begin(stage, f);
+    if (profiler == nullptr) return;
+
+    feature = f;
+    startTicks = juce::Time::getHighResolutionTicks();
+}
+
+AnalysisProfiler::ScopedStage::~ScopedStage() {
+    TraceRecorder::end(stage, traceToken);
+    if (profiler == nullptr) return;
+
+    auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    profiler->record(stage, feature, seconds, frames, bytes, breakpoints);
+}
+
+AnalysisProfiler::Accumulator::Accumulator(AnalysisProfiler* p, const char* s, const juce::String& f)
+    : profiler(p != nullptr && p->isEnabled() ? p : nullptr), stage(s) {
+    if (profiler != nullptr)
+        feature = f;
+}
+
+AnalysisProfiler::Accumulator::~Accumulator() {
+    if (profiler == nullptr) return;
+
+    profiler->record(stage, feature, juce::Time::highResolutionTicksToSeconds(totalTicks), frames, 0, 0);
+}
@@ -0,0 +1,98 @@
+// AnalysisProfiler.h
+#pragma once
+
+#include <JuceHeader.h>
+#include "TraceRecorder.h"
+
+// Per-stage wall time and counters for the analysis pipeline: decoding,
+// framing, each extractor's stages, post-processing, file I/O and the
+// editor's copy of the displayed track.
+//
+// Stages are timed with ScopedStage, or with an Accumulator when a stage is
+// interleaved with others inside a loop. Both check the enabled flag once on
+// construction; when profiling is off they never read the clock, allocate or
+// lock. Results accumulate per stage name until reset().
+//
+// While a TraceRecorder is recording, each ScopedStage is also emitted as a
+// trace event, whether or not profiling is enabled.
+class AnalysisProfiler {
+public:
+    struct Stage {
+        juce::String name;
+        int calls = 0;
+        double totalSeconds = 0.0;
+        double lastSeconds = 0.0;
+        juce::int64 frames = 0;
+        juce::int64 bytes = 0;
+        juce::int64 breakpoints = 0;
+
+        double getFramesPerSecond() const { return totalSeconds > 0.0 ? frames / totalSeconds : 0.0; }
+    };
+
+    void setEnabled(bool shouldBeEnabled) { enabled.store(shouldBeEnabled, std::memory_order_relaxed); }
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    void reset();
+
+    // In the order each stage was first recorded.
+    std::vector<Stage> getStages() const;
+    juce::String getSummary() const;
+
+    class ScopedStage {
+    public:
+        // The stage is recorded as "feature: stage", or just "stage" when
+        // feature is empty.
+        ScopedStage(AnalysisProfiler* profiler, const char* stage, const juce::String& feature = {});
+        ~ScopedStage();
+
+        void addFrames(juce::int64 n) { frames += n; }
+        void addBytes(juce::int64 n) { bytes += n; }
+        void addBreakpoints(juce::int64 n) { breakpoints += n; }
+
+    private:
+        AnalysisProfiler* profiler;
+        const char* stage;
+        int traceToken = TraceRecorder::notRecorded;
+        juce::String feature; // only copied while profiling
+        juce::int64 startTicks = 0;
+        juce::int64 frames = 0, bytes = 0, breakpoints = 0;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedStage)
+    };
+
+    // Sums the time between each start() and stop() and records it as one
+    // call when destroyed.
+    class Accumulator {
+    public:
+        Accumulator(AnalysisProfiler* profiler, const char* stage, const juce::String& feature = {});
+        ~Accumulator();
+
+        void start() { if (profiler != nullptr) startTicks = juce::Time::getHighResolutionTicks(); }
+        void stop() { if (profiler != nullptr) totalTicks += juce::Time::getHighResolutionTicks() - startTicks; }
+        void addFrames(juce::int64 n) { frames += n; }
+
+    private:
+        AnalysisProfiler* profiler;
+        const char* stage;
+        juce::String feature;
+        juce::int64 startTicks = 0, totalTicks = 0;
+        juce::int64 frames = 0;
+
+        JUCE_DECLARE_NON_COPYABLE(Accumulator)
+    };
+
+    // Approximate bytes held by a container of trivially copyable elements.
+    template <typename Container>
+    static juce::int64 bytesOf(const Container& container) {
+        return static_cast<juce::int64>(container.size() * sizeof(typename Container::value_type));
+    }
+
+private:
+    std::atomic<bool> enabled{ false };
+
+    juce::CriticalSection lock;
+    std::vector<Stage> stages;
+
+    void record(const char* stage, const juce::String& feature, double seconds,
+        juce::int64 frames, juce::int64 bytes, juce::int64 breakpoints);
+};
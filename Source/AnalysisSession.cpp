@@ -0,0 +1,315 @@
+// AnalysisSession.cpp
+#include "AnalysisSession.h"
+#include "BatchAnalyzer.h"
+#include "BreakpointCodec.h"
+#include "MemoryBudget.h"
+
+AnalysisSession::AnalysisSession(AnalysisCache& c, int threads)
+    : cache(c), numThreads(threads),
+      spillDirectory(juce::File::getSpecialLocation(juce::File::tempDirectory)
+          .getChildFile("AudioDeconstructorSpill").getChildFile(juce::Uuid().toString())) {}
+
+AnalysisSession::~AnalysisSession() {
+    // Join the workers before the scheduler goes, as a task that is still
+    // decoding submits to it when it finishes.
+    cancelled = true;
+    if (scheduler != nullptr)
+        scheduler->shutdown();
+    scheduler.reset();
+    spillDirectory.deleteRecursively();
+}
+
+int AnalysisSession::addFiles(const juce::Array<juce::File>& files, const juce::StringArray& featureNames,
+    const FeatureExtractor::Settings& settings, int channel) {
+
+    int numAdded = 0;
+    {
+        const juce::ScopedLock sl(lock);
+        for (const auto& file : files) {
+            if (findSource(file) != nullptr) continue;
+
+            auto source = std::make_unique<Source>();
+            source->file = file;
+            source->featureNames = featureNames;
+            source->settings = settings;
+            source->channel = channel;
+            pending.push_back(source.get());
+            sources.push_back(std::move(source));
+            ++numAdded;
+        }
+    }
+    if (numAdded == 0) return 0;
+
+    ++revision;
+    if (scheduler == nullptr)
+        scheduler = std::make_unique<WorkStealingScheduler>(numThreads);
+    for (int i = 0; i < numAdded; ++i)
+        scheduler->submit([this] { analyseNext(); });
+    return numAdded;
+}
+
+void AnalysisSession::clear() {
+    // Stopping the workers drops the queued tasks once the running ones end.
+    cancelled = true;
+    if (scheduler != nullptr)
+        scheduler->shutdown();
+    scheduler.reset();
+    cancelled = false;
+
+    const juce::ScopedLock sl(lock);
+    if (similarityIndex != nullptr) {
+        for (const auto& source : sources)
+            similarityIndex->removeSource(source->file);
+    }
+    pending.clear();
+    sources.clear();
+    priorityFile = juce::File();
+    spillDirectory.deleteRecursively();
+    ++revision;
+}
+
+void AnalysisSession::setPriorityFile(const juce::File& file) {
+    const juce::ScopedLock sl(lock);
+    priorityFile = file;
+}
+
+int AnalysisSession::getNumFiles() const {
+    const juce::ScopedLock sl(lock);
+    return static_cast<int>(sources.size());
+}
+
+int AnalysisSession::indexOf(const juce::File& file) const {
+    const juce::ScopedLock sl(lock);
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (sources[i]->file == file)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+AnalysisSession::Entry AnalysisSession::getEntry(int index) const {
+    const juce::ScopedLock sl(lock);
+    if (!juce::isPositiveAndBelow(index, static_cast<int>(sources.size()))) return {};
+
+    const auto& source = *sources[static_cast<size_t>(index)];
+    return { source.file, source.status, source.numFeaturesDone, source.featureNames.size() };
+}
+
+bool AnalysisSession::isDone(const juce::File& file) const {
+    const juce::ScopedLock sl(lock);
+    auto* source = findSource(file);
+    return source != nullptr && source->status == Status::done;
+}
+
+AnalysisSession::FeatureMap AnalysisSession::getFeatures(const juce::File& file) {
+    const juce::ScopedLock sl(lock);
+    auto* source = findSource(file);
+    if (source == nullptr) return {};
+
+    // A spill file that can't be read back is analysed again.
+    if (source->spillFile != juce::File() && !readSpillFile(*source)) {
+        requeue(*source);
+        return {};
+    }
+    source->lastUsed = ++useClock;
+    return source->features;
+}
+
+void AnalysisSession::storeFeatures(const juce::File& file, FeatureMap features) {
+    const juce::ScopedLock sl(lock);
+    if (auto* source = findSource(file)) {
+        if (similarityIndex != nullptr)
+            similarityIndex->setSource(file, features);
+        discardSpillFile(*source);
+        source->features = std::move(features);
+        source->lastUsed = ++useClock;
+    }
+}
+
+juce::int64 AnalysisSession::getResidentBytes() const {
+    const juce::ScopedLock sl(lock);
+    juce::int64 bytes = 0;
+    for (const auto& source : sources)
+        bytes += MemoryBudget::bytesOf(source->features);
+    return bytes;
+}
+
+juce::int64 AnalysisSession::getSpilledBytes() const {
+    const juce::ScopedLock sl(lock);
+    juce::int64 bytes = 0;
+    for (const auto& source : sources)
+        bytes += source->spilledBytes;
+    return bytes;
+}
+
+int AnalysisSession::getNumSpilledFiles() const {
+    const juce::ScopedLock sl(lock);
+    return static_cast<int>(std::count_if(sources.begin(), sources.end(),
+        [](const auto& source) { return source->spillFile != juce::File(); }));
+}
+
+juce::int64 AnalysisSession::spill(juce::int64 bytesToFree, const juce::File& keep) {
+    const juce::ScopedLock sl(lock);
+
+    std::vector<Source*> candidates;
+    for (const auto& source : sources) {
+        if (source->status == Status::done && source->file != keep && !source->features.empty())
+            candidates.push_back(source.get());
+    }
+    std::sort(candidates.begin(), candidates.end(),
+        [](const Source* a, const Source* b) { return a->lastUsed < b->lastUsed; });
+
+    juce::int64 freed = 0;
+    for (auto* source : candidates) {
+        if (freed >= bytesToFree) break;
+
+        auto bytes = MemoryBudget::bytesOf(source->features);
+        if (!writeSpillFile(*source)) break;
+
+        source->spilledBytes = bytes;
+        FeatureMap().swap(source->features);
+        freed += bytes;
+    }
+    return freed;
+}
+
+AnalysisSession::Source* AnalysisSession::findSource(const juce::File& file) const {
+    for (const auto& source : sources) {
+        if (source->file == file)
+            return source.get();
+    }
+    return nullptr;
+}
+
+AnalysisSession::Source* AnalysisSession::takeNext() {
+    const juce::ScopedLock sl(lock);
+    if (pending.empty()) return nullptr;
+
+    auto it = std::find_if(pending.begin(), pending.end(),
+        [this](const Source* source) { return source->file == priorityFile; });
+    if (it == pending.end())
+        it = pending.begin();
+
+    auto* source = *it;
+    pending.erase(it);
+    source->status = Status::analysing;
+    ++revision;
+    return source;
+}
+
+void AnalysisSession::analyseNext() {
+    if (cancelled) return;
+
+    auto* source = takeNext();
+    if (source == nullptr) return;
+
+    auto decoded = BatchAnalyzer::decode(source->file, true);
+    if (cancelled) return;
+    if (decoded == nullptr || source->featureNames.isEmpty()) {
+        const juce::ScopedLock sl(lock);
+        source->status = decoded == nullptr ? Status::failed : Status::done;
+        ++revision;
+        return;
+    }
+
+    // The last feature task to finish releases the decoded audio.
+    for (const auto& featureName : source->featureNames) {
+        scheduler->submit([this, source, decoded, featureName] {
+            std::vector<BreakpointList> outputs;
+            if (!cancelled) {
+                if (auto extractor = FeatureExtractorFactory::createExtractor(featureName)) {
+                    extractor->settings = source->settings;
+                    outputs = BatchAnalyzer::extract(*decoded, *extractor, source->channel, &cache);
+                }
+            }
+            finishFeature(*source, featureName, std::move(outputs));
+        });
+    }
+}
+
+void AnalysisSession::finishFeature(Source& source, const juce::String& featureName,
+    std::vector<BreakpointList> outputs) {
+
+    bool finished = false;
+    {
+        const juce::ScopedLock sl(lock);
+        if (!outputs.empty())
+            source.features.emplace(featureName, std::move(outputs));
+
+        if (++source.numFeaturesDone == source.featureNames.size()) {
+            source.status = Status::done;
+            finished = true;
+            // Indexed under the lock, before the tracks can be spilled.
+            if (similarityIndex != nullptr)
+                similarityIndex->setSource(source.file, source.features);
+        }
+        ++revision;
+    }
+
+    if (finished && onFileFinished != nullptr)
+        onFileFinished();
+    if (finished && similarityIndex != nullptr && !cancelled)
+        similarityIndex->trainIfNeeded();
+}
+
+void AnalysisSession::requeue(Source& source) {
+    discardSpillFile(source);
+    FeatureMap().swap(source.features);
+    source.status = Status::queued;
+    source.numFeaturesDone = 0;
+    pending.push_back(&source);
+    ++revision;
+
+    if (scheduler == nullptr)
+        scheduler = std::make_unique<WorkStealingScheduler>(numThreads);
+    scheduler->submit([this] { analyseNext(); });
+}
+
+bool AnalysisSession::writeSpillFile(Source& source) {
+    if (spillDirectory.createDirectory().failed()) return false;
+
+    auto file = spillDirectory.getNonexistentChildFile(source.file.getFileNameWithoutExtension(), ".adbp");
+    {
+        juce::FileOutputStream stream(file);
+        if (!stream.openedOk()) return false;
+
+        stream.writeCompressedInt(static_cast<int>(source.features.size()));
+        for (const auto& [featureName, outputs] : source.features)
+            BreakpointCodec::writeFeature(stream, featureName, outputs, BreakpointCodec::Options::lossless());
+        stream.flush();
+        if (stream.getStatus().failed()) {
+            file.deleteFile();
+            return false;
+        }
+    }
+    source.spillFile = file;
+    return true;
+}
+
+bool AnalysisSession::readSpillFile(Source& source) {
+    juce::FileInputStream stream(source.spillFile);
+    if (!stream.openedOk()) return false;
+
+    FeatureMap features;
+    int numFeatures = stream.readCompressedInt();
+    for (int i = 0; i < numFeatures; ++i) {
+        juce::String featureName;
+        std::vector<BreakpointList> outputs;
+        if (!BreakpointCodec::readFeature(stream, featureName, outputs)) return false;
+        features[featureName] = std::move(outputs);
+    }
+
+    // Anything stored since the spill is newer than the file.
+    for (auto& [featureName, outputs] : features)
+        source.features.emplace(featureName, std::move(outputs));
+    discardSpillFile(source);
+    return true;
+}
+
+void AnalysisSession::discardSpillFile(Source& source) {
+    if (source.spillFile == juce::File()) return;
+
+    source.spillFile.deleteFile();
+    source.spillFile = juce::File();
+    source.spilledBytes = 0;
+}
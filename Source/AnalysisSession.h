@@ -0,0 +1,118 @@
+// AnalysisSession.h
+#pragma once
+
+#include <JuceHeader.h>
+#include "FeatureExtractors.h"
+#include "AnalysisCache.h"
+#include "WorkStealingScheduler.h"
+#include "SimilarityIndex.h"
+#include <deque>
+
+// Every source queued in the plugin, each with its own store of extracted
+// tracks. Files are decoded and analysed in the background on a shared
+// work-stealing pool, the features of a file as tasks spawned by its decode
+// so a worker finishes one file before taking another.
+//
+// Scheduler tasks don't name a file: each one takes the best pending file
+// when it starts, so the priority file (the one being viewed) runs on the
+// next free worker however long the queue is. Raw outputs go through the
+// analysis cache, so extracting a file again once it is viewed is a lookup.
+class AnalysisSession {
+public:
+    enum class Status { queued, analysing, done, failed };
+
+    using FeatureMap = std::map<juce::String, std::vector<BreakpointList>>;
+
+    struct Entry {
+        juce::File file;
+        Status status = Status::queued;
+        int numFeaturesDone = 0;
+        int numFeatures = 0;
+    };
+
+    explicit AnalysisSession(AnalysisCache& cache, int numThreads = 0);
+    ~AnalysisSession();
+
+    // Queues the files that aren't already in the session, to be analysed
+    // with these settings; returns how many were added. Message thread.
+    int addFiles(const juce::Array<juce::File>& files, const juce::StringArray& featureNames,
+        const FeatureExtractor::Settings& settings, int channel);
+    void clear();
+
+    // Files are added to the index as their analysis finishes, and again
+    // when their tracks are stored. Set before queueing anything.
+    void setSimilarityIndex(SimilarityIndex* index) { similarityIndex = index; }
+
+    // Called on a worker thread whenever a file's analysis finishes.
+    std::function<void()> onFileFinished;
+
+    // Moves the file ahead of everything still queued.
+    void setPriorityFile(const juce::File& file);
+
+    int getNumFiles() const;
+    int indexOf(const juce::File& file) const;
+    Entry getEntry(int index) const;
+    // Changes whenever a file is added or changes status.
+    juce::uint32 getRevision() const { return revision.load(); }
+
+    bool isDone(const juce::File& file) const;
+    // The stored tracks of a file, read back first if they were spilled;
+    // features still being analysed are missing. A file whose spill can't
+    // be read back goes back in the queue and has none until it's analysed.
+    FeatureMap getFeatures(const juce::File& file);
+    // Replaces the stored tracks, e.g. with the edited ones when the editor
+    // moves to another file. Background results for features already
+    // stored are dropped rather than overwrite them.
+    void storeFeatures(const juce::File& file, FeatureMap features);
+
+    // Memory held by stored tracks, and written out by spill.
+    juce::int64 getResidentBytes() const;
+    juce::int64 getSpilledBytes() const;
+    int getNumSpilledFiles() const;
+    // Writes the tracks of finished files other than keep to a spill file
+    // each, least recently used first, until bytesToFree have been released.
+    // Returns the bytes released; getFeatures brings them back.
+    juce::int64 spill(juce::int64 bytesToFree, const juce::File& keep);
+
+private:
+    struct Source {
+        juce::File file;
+        Status status = Status::queued;
+        juce::StringArray featureNames;
+        FeatureExtractor::Settings settings;
+        int channel = 0;
+        int numFeaturesDone = 0;
+        FeatureMap features;
+        juce::uint32 lastUsed = 0;
+        juce::File spillFile;    // set while the features are on disk
+        juce::int64 spilledBytes = 0;
+    };
+
+    AnalysisCache& cache;
+    int numThreads;
+    SimilarityIndex* similarityIndex = nullptr;
+
+    mutable juce::CriticalSection lock;
+    std::vector<std::unique_ptr<Source>> sources;
+    std::deque<Source*> pending;
+    juce::File priorityFile;
+    std::atomic<juce::uint32> revision{ 0 };
+    std::atomic<bool> cancelled{ false };
+    juce::uint32 useClock = 0;
+    juce::File spillDirectory;
+
+    // Created with the first file, so an instance that never queues one
+    // doesn't start a thread per core.
+    std::unique_ptr<WorkStealingScheduler> scheduler;
+
+    Source* findSource(const juce::File& file) const;
+    Source* takeNext();
+    void analyseNext();
+    void finishFeature(Source& source, const juce::String& featureName, std::vector<BreakpointList> outputs);
+    void requeue(Source& source);
+    bool writeSpillFile(Source& source);
+    bool readSpillFile(Source& source);
+    void discardSpillFile(Source& source);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalysisSession)
+};
@@ -0,0 +1,255 @@
+// BatchAnalyzer.cpp
+
+#include "BatchAnalyzer.h"
+#include "AnalysisCache.h"
+#include "BreakpointTextIO.h"
+#include "TraceRecorder.h"
+#include "WorkStealingScheduler.h"
+#include <mutex>
+
+namespace {
+
+struct BatchState {
+    const BatchAnalyzer::Options& options;
+    juce::StringArray features;
+    std::unique_ptr<AnalysisCache> cache;
+    WorkStealingScheduler scheduler;
+
+    std::atomic<int> numFailedFiles{ 0 };
+    std::atomic<int> numWritten{ 0 };
+    std::atomic<int> numSkipped{ 0 };
+
+    juce::CriticalSection logLock;
+    juce::StringArray errors;
+    std::function<void(const juce::String&)> log;
+
+    BatchState(const BatchAnalyzer::Options& o, std::function<void(const juce::String&)> l)
+        : options(o), scheduler(o.numThreads), log(std::move(l)) {}
+
+    void message(const juce::String& text) {
+        const juce::ScopedLock sl(logLock);
+        if (log != nullptr) log(text);
+    }
+
+    void error(const juce::String& text) {
+        const juce::ScopedLock sl(logLock);
+        errors.add(text);
+        if (log != nullptr) log("Error: " + text);
+    }
+};
+
+bool writeFeatureFile(const juce::File& file, const FeatureExtractor& extractor,
+    const BatchAnalyzer::DecodedFile& decoded, const std::vector<BreakpointList>& outputs,
+    const BatchAnalyzer::Options& options) {
+
+    juce::StringArray outputNames;
+    for (size_t i = 0; i < outputs.size(); ++i)
+        outputNames.add(extractor.getOutputName(static_cast<int>(i)));
+
+    // Written beside the target and moved into place, so an interrupted run
+    // never leaves a truncated file that skipExisting would trust.
+    juce::TemporaryFile temp(file);
+    {
+        juce::FileOutputStream stream(temp.getFile());
+        if (!stream.openedOk()) return false;
+
+        if (options.controlRate) {
+            ControlRateExport::File exported;
+            exported.featureName = extractor.getName();
+            exported.sourceName = decoded.source.getFileNameWithoutExtension();
+            exported.sampleRate = decoded.sampleRate;
+            exported.outputNames = outputNames;
+
+            double interval = options.controlGrid.getInterval(decoded.sampleRate);
+            double endTime = decoded.audio.getNumSamples() / decoded.sampleRate;
+            for (const auto& points : outputs) {
+                if (!points.empty())
+                    endTime = juce::jmax(endTime, points.back().first);
+            }
+            auto interpolation = extractor.emitsEvents() ? ControlRateExport::Interpolation::impulse
+                : options.interpolation;
+            for (const auto& points : outputs)
+                exported.outputs.push_back(ControlRateExport::resample(points, interval, endTime, interpolation));
+
+            bool written = options.dense ? ControlRateExport::writeDense(stream, exported)
+                : ControlRateExport::writeText(stream, exported);
+            if (!written) return false;
+        }
+        else if (!BreakpointFileFormat::write(stream, extractor.getName(),
+            decoded.source.getFileNameWithoutExtension(), decoded.sampleRate, outputNames, outputs)) {
+            return false;
+        }
+    }
+    return temp.overwriteTargetFileWithTemporary();
+}
+
+void extractFeature(BatchState& state, BatchAnalyzer::DecodedFile& decoded, const juce::String& featureName) {
+    auto extractor = FeatureExtractorFactory::createExtractor(featureName);
+    if (extractor == nullptr) return;
+
+    extractor->settings = state.options.settings;
+    auto outputs = BatchAnalyzer::extract(decoded, *extractor, state.options.channel, state.cache.get());
+
+    auto file = BatchAnalyzer::getOutputFile(decoded.source, featureName, state.options);
+    if (!writeFeatureFile(file, *extractor, decoded, outputs, state.options)) {
+        state.error("can't write " + file.getFullPathName());
+        return;
+    }
+
+    ++state.numWritten;
+    state.message(file.getFullPathName());
+}
+
+void analyseFile(BatchState& state, const juce::File& source) {
+    juce::StringArray pending;
+    for (const auto& featureName : state.features) {
+        if (state.options.skipExisting
+            && BatchAnalyzer::getOutputFile(source, featureName, state.options).existsAsFile())
+            ++state.numSkipped;
+        else
+            pending.add(featureName);
+    }
+    if (pending.isEmpty()) return;
+
+    auto decoded = BatchAnalyzer::decode(source, state.cache != nullptr);
+    if (decoded == nullptr) {
+        ++state.numFailedFiles;
+        state.error("can't read " + source.getFullPathName());
+        return;
+    }
+
+    // The last task to finish releases the decoded audio.
+    for (const auto& featureName : pending) {
+        state.scheduler.submit([&state, decoded, featureName] {
+            extractFeature(state, *decoded, featureName);
+        });
+    }
+}
+
+} // namespace
+
+const FrameStatistics& BatchAnalyzer::DecodedFile::getFrameStatistics(const FeatureExtractor::Settings& settings) {
+    std::call_once(frameStatisticsFlag, [&] {
+        frameStatistics = FrameStatistics::compute(audio, sampleRate, settings.windowSizeMs, settings.hopSizePct);
+    });
+    return frameStatistics;
+}
+
+const AnalysisPyramid& BatchAnalyzer::DecodedFile::getAnalysisPyramid() {
+    std::call_once(analysisPyramidFlag, [&] {
+        analysisPyramid = AnalysisPyramid::compute(audio, sampleRate);
+    });
+    return analysisPyramid;
+}
+
+std::shared_ptr<BatchAnalyzer::DecodedFile> BatchAnalyzer::decode(const juce::File& source, bool hashAudio) {
+    TraceRecorder::Scope trace("decode", source.getFileName());
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(source));
+    if (reader == nullptr || reader->numChannels == 0
+        || reader->lengthInSamples > std::numeric_limits<int>::max())
+        return nullptr;
+
+    auto decoded = std::make_shared<DecodedFile>();
+    decoded->source = source;
+    decoded->sampleRate = reader->sampleRate;
+
+    int numSamples = static_cast<int>(reader->lengthInSamples);
+    decoded->audio.setSize(static_cast<int>(reader->numChannels), numSamples);
+    reader->read(&decoded->audio, 0, numSamples, 0, true, true);
+
+    if (hashAudio)
+        decoded->audioHash = AnalysisCache::hashAudio(decoded->audio, decoded->sampleRate);
+    return decoded;
+}
+
+std::vector<BreakpointList> BatchAnalyzer::extract(DecodedFile& decoded, FeatureExtractor& extractor,
+    int channel, AnalysisCache* cache) {
+
+    TraceRecorder::Scope trace("extract", decoded.source.getFileName() + " " + extractor.getName());
+    channel = juce::jlimit(0, decoded.audio.getNumChannels() - 1, channel);
+
+    std::vector<BreakpointList> outputs;
+    AnalysisCache::Key cacheKey{ decoded.audioHash, extractor.getName(), extractor.getVersion(),
+        AnalysisCache::hashSettings(extractor.getSettingsFor(extractor.getRawSettingsDependencies())),
+        channel };
+
+    if (cache == nullptr || !cache->lookup(cacheKey, outputs)) {
+        if (extractor.usesFrameStatistics())
+            outputs = extractor.extractFromFrames(decoded.getFrameStatistics(extractor.settings), channel);
+        else if (extractor.usesAnalysisPyramid())
+            outputs = extractor.extractFromPyramid(decoded.getAnalysisPyramid(), channel);
+        else
+            outputs = extractor.extractRaw(decoded.audio, decoded.sampleRate, channel);
+        if (cache != nullptr)
+            cache->store(cacheKey, outputs);
+    }
+    extractor.postProcess(outputs);
+    return outputs;
+}
+
+juce::Array<juce::File> BatchAnalyzer::findAudioFiles(const juce::StringArray& paths, bool recursive) {
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    auto isReadable = [&](const juce::File& file) {
+        return formatManager.findFormatForFileExtension(file.getFileExtension()) != nullptr;
+    };
+
+    juce::Array<juce::File> files;
+    for (const auto& path : paths) {
+        juce::File file = juce::File::getCurrentWorkingDirectory().getChildFile(path);
+
+        if (file.isDirectory()) {
+            auto found = file.findChildFiles(juce::File::findFiles, recursive);
+            found.sort();
+            for (const auto& child : found) {
+                if (isReadable(child))
+                    files.add(child);
+            }
+        }
+        else if (file.existsAsFile() && isReadable(file)) {
+            files.add(file);
+        }
+    }
+    return files;
+}
+
+juce::File BatchAnalyzer::getOutputFile(const juce::File& source, const juce::String& featureName,
+    const Options& options) {
+
+    auto directory = options.outputDirectory == juce::File() ? source.getParentDirectory()
+        : options.outputDirectory;
+    auto extension = options.controlRate && options.dense ? ".adcr" : ".txt";
+    return directory.getChildFile(source.getFileNameWithoutExtension() + "_" + featureName + extension);
+}
+
+BatchAnalyzer::Summary BatchAnalyzer::run(const juce::Array<juce::File>& files, const Options& options,
+    std::function<void(const juce::String&)> log) {
+
+    BatchState state(options, std::move(log));
+
+    state.features = options.features.isEmpty()
+        ? FeatureExtractorFactory::getAvailableFeatures() : options.features;
+
+    if (options.useCache)
+        state.cache = std::make_unique<AnalysisCache>(AnalysisCache::getDefaultDirectory());
+
+    if (options.outputDirectory != juce::File())
+        options.outputDirectory.createDirectory();
+
+    for (const auto& file : files) {
+        state.scheduler.submit([&state, file] { analyseFile(state, file); });
+    }
+    state.scheduler.waitUntilIdle();
+
+    Summary summary;
+    summary.numFiles = files.size();
+    summary.numFailedFiles = state.numFailedFiles.load();
+    summary.numWritten = state.numWritten.load();
+    summary.numSkipped = state.numSkipped.load();
+    summary.errors = state.errors;
+    return summary;
+}
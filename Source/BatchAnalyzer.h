@@ -0,0 +1,83 @@
+// BatchAnalyzer.h
+#pragma once
+
+#include <JuceHeader.h>
+#include "FeatureExtractors.h"
+#include "ControlRateExport.h"
+#include <mutex>
+
+class AnalysisCache;
+
+// Extracts features from many files without the plugin and writes one
+// breakpoint file per file and feature, named as saveAllBreakpoints names
+// them.
+//
+// Each file is a task that decodes it and then spawns one task per feature.
+// On the work-stealing scheduler a worker finishes the features of the file
+// it decoded before starting another, so only about one decoded file per
+// thread is held at once, and idle workers steal features or whole files
+// from the rest.
+class BatchAnalyzer {
+public:
+    struct Options {
+        juce::StringArray features; // empty runs every feature
+        FeatureExtractor::Settings settings;
+        int channel = 0;
+        juce::File outputDirectory; // unset writes next to each source
+        int numThreads = 0;         // 0 uses every core
+        bool useCache = false;      // reuse and fill the plugin's analysis cache
+        bool skipExisting = false;
+
+        // Resample every output onto a fixed grid before writing, as dense
+        // .adcr files if asked and text otherwise.
+        bool controlRate = false;
+        ControlRateExport::Grid controlGrid;
+        ControlRateExport::Interpolation interpolation = ControlRateExport::Interpolation::linear;
+        bool dense = false;
+    };
+
+    struct Summary {
+        int numFiles = 0;
+        int numFailedFiles = 0;
+        int numWritten = 0;
+        int numSkipped = 0;
+        juce::StringArray errors;
+    };
+
+    // A decoded source shared by the tasks extracting its features. Amplitude
+    // and Panning share one set of frame sums and low-band extractors one
+    // pyramid, each computed by whichever task needs it first.
+    struct DecodedFile {
+        juce::File source;
+        juce::AudioBuffer<float> audio;
+        double sampleRate = 0.0;
+        juce::uint64 audioHash = 0;
+
+        const FrameStatistics& getFrameStatistics(const FeatureExtractor::Settings& settings);
+        const AnalysisPyramid& getAnalysisPyramid();
+
+    private:
+        std::once_flag frameStatisticsFlag;
+        FrameStatistics frameStatistics;
+        std::once_flag analysisPyramidFlag;
+        AnalysisPyramid analysisPyramid;
+    };
+
+    // Null if the file can't be read. The hash is only needed to use a cache.
+    static std::shared_ptr<DecodedFile> decode(const juce::File& source, bool hashAudio);
+    // Post-processed outputs of one extractor, whose settings are already
+    // set, through the cache if there is one. Any thread.
+    static std::vector<BreakpointList> extract(DecodedFile& decoded, FeatureExtractor& extractor,
+        int channel, AnalysisCache* cache);
+
+    // Audio files the basic formats can read, in a stable order. Directories
+    // are searched, recursively if asked.
+    static juce::Array<juce::File> findAudioFiles(const juce::StringArray& paths, bool recursive);
+
+    // Messages arrive from the worker threads, one at a time.
+    static Summary run(const juce::Array<juce::File>& files, const Options& options,
+        std::function<void(const juce::String&)> log = nullptr);
+
+    static juce::File getOutputFile(const juce::File& source, const juce::String& featureName,
+        const Options& options);
+};
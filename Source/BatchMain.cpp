@@ -0,0 +1,148 @@
+// BatchMain.cpp
+//
+// Entry point of the headless batch analyser, a console application built
+// from this file plus BatchAnalyzer, WorkStealingScheduler,
+// FeatureExtractors, AnalysisProfiler, TraceRecorder, AnalysisCache,
+// BreakpointTextIO and ControlRateExport.
+// It is not part of the plugin target.
+
+#include <JuceHeader.h>
+#include "BatchAnalyzer.h"
+#include "TraceRecorder.h"
+#include <iostream>
+
+namespace {
+
+void printUsage() {
+    std::cout <<
+        "Usage: AudioDeconstructorBatch [options] <file or directory>...\n"
+        "\n"
+        "  --features=Amplitude,Pitch  features to extract (default: all)\n"
+        "  --window=15                 window size in ms\n"
+        "  --hop=50                    hop size in % of the window\n"
+        "  --no-normalize              keep raw output values\n"
+        "  --smooth=10                 smooth the output over this many ms\n"
+        "  --decimate                  analyse low-band features (Pitch) at a reduced rate\n"
+        "  --channel=0                 channel analysed by single-channel features\n"
+        "  --output=<directory>        where to write (default: next to each file)\n"
+        "  --threads=0                 worker threads (default: every core)\n"
+        "  --recursive                 search directories recursively\n"
+        "  --skip-existing             leave files that already have output\n"
+        "  --cache                     share the plugin's analysis cache\n"
+        "  --control-rate=100          resample every output to this many values per second\n"
+        "  --block=512                 or to one value per this many samples\n"
+        "  --interp=linear             hold, linear or cubic between breakpoints\n"
+        "                              (transients are always written as impulses)\n"
+        "  --dense                     write resampled output as binary .adcr files\n"
+        "  --trace=<file>              write a Chrome/Perfetto trace of the run\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    juce::ArgumentList args(argc, argv);
+
+    if (args.containsOption("--help|-h")) {
+        printUsage();
+        return 0;
+    }
+
+    juce::StringArray paths;
+    for (const auto& arg : args.arguments) {
+        if (!arg.isOption())
+            paths.add(arg.text);
+    }
+
+    if (paths.isEmpty()) {
+        printUsage();
+        return 1;
+    }
+
+    BatchAnalyzer::Options options;
+
+    // Ranges match the plugin's parameters.
+    if (args.containsOption("--window"))
+        options.settings.windowSizeMs = juce::jlimit(1.0f, 100.0f, args.getValueForOption("--window").getFloatValue());
+    if (args.containsOption("--hop"))
+        options.settings.hopSizePct = juce::jlimit(10.0f, 90.0f, args.getValueForOption("--hop").getFloatValue());
+    if (args.containsOption("--no-normalize"))
+        options.settings.normalizeOutput = false;
+    if (args.containsOption("--smooth")) {
+        options.settings.smoothOutput = true;
+        options.settings.smoothTimeMs = juce::jlimit(1.0f, 50.0f, args.getValueForOption("--smooth").getFloatValue());
+    }
+
+    if (args.containsOption("--decimate"))
+        options.settings.decimatedAnalysis = true;
+
+    options.channel = juce::jmax(0, args.getValueForOption("--channel").getIntValue());
+    options.numThreads = juce::jmax(0, args.getValueForOption("--threads").getIntValue());
+    options.useCache = args.containsOption("--cache");
+    options.skipExisting = args.containsOption("--skip-existing");
+
+    if (args.containsOption("--control-rate")) {
+        options.controlRate = true;
+        options.controlGrid = ControlRateExport::Grid::perSecond(
+            juce::jlimit(1.0, 48000.0, args.getValueForOption("--control-rate").getDoubleValue()));
+    }
+    if (args.containsOption("--block")) {
+        options.controlRate = true;
+        options.controlGrid = ControlRateExport::Grid::perBlock(
+            juce::jlimit(1, 65536, args.getValueForOption("--block").getIntValue()));
+    }
+    if (args.containsOption("--interp"))
+        options.interpolation = ControlRateExport::parseInterpolation(args.getValueForOption("--interp"));
+    options.dense = args.containsOption("--dense");
+    if (options.dense || args.containsOption("--interp"))
+        options.controlRate = true;
+
+    if (args.containsOption("--output"))
+        options.outputDirectory = juce::File::getCurrentWorkingDirectory()
+            .getChildFile(args.getValueForOption("--output"));
+
+    auto available = FeatureExtractorFactory::getAvailableFeatures();
+    if (args.containsOption("--features")) {
+        options.features.addTokens(args.getValueForOption("--features"), ",", {});
+        options.features.trim();
+        options.features.removeEmptyStrings();
+
+        for (const auto& feature : options.features) {
+            if (!available.contains(feature)) {
+                std::cerr << "Unknown feature: " << feature << " (available: "
+                    << available.joinIntoString(", ") << ")\n";
+                return 1;
+            }
+        }
+    }
+
+    auto files = BatchAnalyzer::findAudioFiles(paths, args.containsOption("--recursive"));
+    if (files.isEmpty()) {
+        std::cerr << "No audio files found\n";
+        return 1;
+    }
+
+    bool tracing = args.containsOption("--trace");
+    if (tracing)
+        TraceRecorder::start();
+
+    std::cout << "Analysing " << files.size() << " files\n";
+    auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    auto summary = BatchAnalyzer::run(files, options, [](const juce::String& message) {
+        std::cout << message << "\n";
+    });
+
+    auto seconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+    if (tracing) {
+        TraceRecorder::stop();
+        auto traceFile = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--trace"));
+        auto result = TraceRecorder::writeTo(traceFile);
+        if (result.failed())
+            std::cerr << result.getErrorMessage() << "\n";
+    }
+
+    std::cout << summary.numWritten << " written, " << summary.numSkipped << " skipped, "
+        << summary.numFailedFiles << " files failed in " << juce::String(seconds, 1) << " s\n";
+
+    return summary.errors.isEmpty() ? 0 : 1;
+}
@@ -0,0 +1,410 @@
+// BenchmarkMain.cpp
+//
+// Entry point of the extractor benchmark, a console application built from
+// this file plus TestSignals, FeatureExtractors, AnalysisProfiler and
+// TraceRecorder. It is not part of the plugin target.
+//
+// Every extractor runs over generated signals (and any audio files given)
+// at each sample rate, window size and hop it depends on. Each case reports
+// the fastest of several runs as samples per second and ns per frame, with
+// the allocations made by one run and the process's peak resident memory so
+// far. A macro case per signal runs every extractor back to back, as Extract
+// All does. Results can be written as JSON and compared against an earlier
+// run to flag regressions.
+
+#include <JuceHeader.h>
+#include "FeatureExtractors.h"
+#include "TestSignals.h"
+#include <iostream>
+
+#if JUCE_WINDOWS
+ #include <windows.h>
+ #include <psapi.h>
+#else
+ #include <sys/resource.h>
+#endif
+
+// Every allocation in the process is counted, which is what makes the
+// per-case allocation figures possible without instrumenting the extractors.
+namespace {
+std::atomic<juce::int64> allocationCount{ 0 };
+std::atomic<juce::int64> allocatedBytes{ 0 };
+
+void* countedAllocate(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(static_cast<juce::int64>(size), std::memory_order_relaxed);
+    if (auto* p = std::malloc(size > 0 ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+} // namespace
+
+void* operator new(std::size_t size) { return countedAllocate(size); }
+void* operator new[](std::size_t size) { return countedAllocate(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+juce::int64 getPeakResidentBytes() {
+#if JUCE_WINDOWS
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return static_cast<juce::int64>(counters.PeakWorkingSetSize);
+    return 0;
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+   #if JUCE_MAC
+    return static_cast<juce::int64>(usage.ru_maxrss);
+   #else
+    return static_cast<juce::int64>(usage.ru_maxrss) * 1024;
+   #endif
+#endif
+}
+
+struct Options {
+    double seconds = 10.0;
+    int repeats = 3;
+    juce::Array<double> sampleRates{ 44100.0, 48000.0, 96000.0 };
+    juce::Array<float> windowSizes{ 5.0f, 15.0f, 50.0f };
+    juce::Array<float> hopSizes{ 25.0f, 50.0f, 75.0f };
+    juce::StringArray features;
+    juce::int64 seed = 1;
+};
+
+struct CaseResult {
+    juce::String feature;
+    juce::String signal;
+    double sampleRate = 0.0;
+    float windowSizeMs = 0.0f;
+    float hopSizePct = 0.0f;
+
+    juce::int64 numSamples = 0;
+    juce::int64 numFrames = 0;
+    double seconds = 0.0;
+    juce::int64 allocations = 0;
+    juce::int64 allocatedBytes = 0;
+    juce::int64 peakResidentBytes = 0;
+
+    juce::String getKey() const {
+        return feature + "/" + signal + "/" + juce::String(sampleRate, 0) + "/"
+            + juce::String(windowSizeMs, 1) + "/" + juce::String(hopSizePct, 0);
+    }
+
+    double getSamplesPerSecond() const { return seconds > 0.0 ? numSamples / seconds : 0.0; }
+    double getNanosecondsPerFrame() const { return numFrames > 0 ? seconds * 1.0e9 / numFrames : 0.0; }
+};
+
+juce::Array<double> parseNumbers(const juce::String& text) {
+    juce::StringArray tokens;
+    tokens.addTokens(text, ",", {});
+    juce::Array<double> numbers;
+    for (const auto& token : tokens) {
+        if (token.trim().isNotEmpty())
+            numbers.add(token.getDoubleValue());
+    }
+    return numbers;
+}
+
+// Runs fn repeats times and keeps the fastest; allocations are counted on
+// the last run, after the first has warmed up any lazily built state.
+template <typename Function>
+void measure(CaseResult& result, int repeats, Function&& fn) {
+    result.seconds = std::numeric_limits<double>::max();
+
+    for (int run = 0; run < repeats; ++run) {
+        auto countBefore = allocationCount.load();
+        auto bytesBefore = allocatedBytes.load();
+
+        auto start = juce::Time::getHighResolutionTicks();
+        result.numFrames = fn();
+        auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+        result.seconds = juce::jmin(result.seconds, elapsed);
+        result.allocations = allocationCount.load() - countBefore;
+        result.allocatedBytes = allocatedBytes.load() - bytesBefore;
+    }
+    result.peakResidentBytes = getPeakResidentBytes();
+}
+
+juce::int64 countFrames(const std::vector<BreakpointList>& outputs) {
+    size_t frames = 0;
+    for (const auto& output : outputs)
+        frames = juce::jmax(frames, output.size());
+    return static_cast<juce::int64>(frames);
+}
+
+void printResult(const CaseResult& result) {
+    std::cout << result.getKey().paddedRight(' ', 44)
+        << juce::String(result.getSamplesPerSecond() / 1.0e6, 2).paddedLeft(' ', 9) << " MS/s"
+        << juce::String(result.getNanosecondsPerFrame(), 0).paddedLeft(' ', 10) << " ns/frame"
+        << juce::String(result.allocations).paddedLeft(' ', 8) << " allocs"
+        << juce::String(result.peakResidentBytes / (1024 * 1024)).paddedLeft(' ', 6) << " MB peak\n";
+}
+
+void benchmarkSignal(const TestSignal& signal, const Options& options,
+    const juce::StringArray& features, std::vector<CaseResult>& results) {
+
+    for (const auto& featureName : features) {
+        auto extractor = FeatureExtractorFactory::createExtractor(featureName);
+        if (extractor == nullptr) continue;
+
+        // Settings an extractor ignores would only repeat the same case.
+        bool usesWindow = (extractor->getRawSettingsDependencies() & FeatureExtractor::windowSizeSetting) != 0;
+        bool usesHop = (extractor->getRawSettingsDependencies() & FeatureExtractor::hopSizeSetting) != 0;
+        auto windows = usesWindow ? options.windowSizes : juce::Array<float>{ FeatureExtractor::Settings().windowSizeMs };
+        auto hops = usesHop ? options.hopSizes : juce::Array<float>{ FeatureExtractor::Settings().hopSizePct };
+
+        for (float window : windows) {
+            for (float hop : hops) {
+                extractor->settings.windowSizeMs = window;
+                extractor->settings.hopSizePct = hop;
+
+                CaseResult result;
+                result.feature = featureName;
+                result.signal = signal.name;
+                result.sampleRate = signal.sampleRate;
+                result.windowSizeMs = window;
+                result.hopSizePct = hop;
+                result.numSamples = signal.audio.getNumSamples();
+
+                measure(result, options.repeats, [&] {
+                    return countFrames(extractor->extract(signal.audio, signal.sampleRate, 0));
+                });
+
+                printResult(result);
+                results.push_back(result);
+            }
+        }
+
+        // The decimated path, timed together with building the pyramid.
+        if ((extractor->getRawSettingsDependencies() & FeatureExtractor::decimationSetting) != 0) {
+            extractor->settings = {};
+            extractor->settings.decimatedAnalysis = true;
+
+            CaseResult result;
+            result.feature = featureName + " decimated";
+            result.signal = signal.name;
+            result.sampleRate = signal.sampleRate;
+            result.windowSizeMs = extractor->settings.windowSizeMs;
+            result.hopSizePct = extractor->settings.hopSizePct;
+            result.numSamples = signal.audio.getNumSamples();
+
+            measure(result, options.repeats, [&] {
+                auto pyramid = AnalysisPyramid::compute(signal.audio, signal.sampleRate);
+                auto outputs = extractor->extractFromPyramid(pyramid, 0);
+                extractor->postProcess(outputs);
+                return countFrames(outputs);
+            });
+
+            printResult(result);
+            results.push_back(result);
+        }
+    }
+
+    // Macro case: every extractor once at the default settings.
+    CaseResult all;
+    all.feature = "All";
+    all.signal = signal.name;
+    all.sampleRate = signal.sampleRate;
+    all.windowSizeMs = FeatureExtractor::Settings().windowSizeMs;
+    all.hopSizePct = FeatureExtractor::Settings().hopSizePct;
+    all.numSamples = signal.audio.getNumSamples();
+
+    measure(all, options.repeats, [&] {
+        juce::int64 frames = 0;
+        for (const auto& featureName : features) {
+            if (auto extractor = FeatureExtractorFactory::createExtractor(featureName))
+                frames += countFrames(extractor->extract(signal.audio, signal.sampleRate, 0));
+        }
+        return frames;
+    });
+
+    printResult(all);
+    results.push_back(all);
+}
+
+juce::var toJson(const std::vector<CaseResult>& results, const Options& options) {
+    juce::Array<juce::var> cases;
+    for (const auto& result : results) {
+        auto* object = new juce::DynamicObject();
+        object->setProperty("key", result.getKey());
+        object->setProperty("feature", result.feature);
+        object->setProperty("signal", result.signal);
+        object->setProperty("sampleRate", result.sampleRate);
+        object->setProperty("windowSizeMs", result.windowSizeMs);
+        object->setProperty("hopSizePct", result.hopSizePct);
+        object->setProperty("samples", result.numSamples);
+        object->setProperty("frames", result.numFrames);
+        object->setProperty("seconds", result.seconds);
+        object->setProperty("samplesPerSecond", result.getSamplesPerSecond());
+        object->setProperty("nsPerFrame", result.getNanosecondsPerFrame());
+        object->setProperty("allocations", result.allocations);
+        object->setProperty("allocatedBytes", result.allocatedBytes);
+        object->setProperty("peakResidentBytes", result.peakResidentBytes);
+        cases.add(juce::var(object));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("version", 1);
+    root->setProperty("time", juce::Time::getCurrentTime().toISO8601(true));
+    root->setProperty("cpu", juce::SystemStats::getCpuModel());
+    root->setProperty("os", juce::SystemStats::getOperatingSystemName());
+    root->setProperty("seconds", options.seconds);
+    root->setProperty("repeats", options.repeats);
+    root->setProperty("cases", cases);
+    return juce::var(root);
+}
+
+// Compares throughput case by case. Returns the number of regressions.
+int compareRuns(const juce::var& baseline, const juce::var& current, double thresholdPct) {
+    std::map<juce::String, double> baselineRates;
+    if (auto* cases = baseline["cases"].getArray()) {
+        for (const auto& item : *cases)
+            baselineRates[item["key"].toString()] = static_cast<double>(item["samplesPerSecond"]);
+    }
+
+    int numRegressions = 0, numImprovements = 0, numCompared = 0;
+    if (auto* cases = current["cases"].getArray()) {
+        for (const auto& item : *cases) {
+            auto key = item["key"].toString();
+            auto it = baselineRates.find(key);
+            if (it == baselineRates.end() || it->second <= 0.0) continue;
+
+            ++numCompared;
+            double change = (static_cast<double>(item["samplesPerSecond"]) / it->second - 1.0) * 100.0;
+            if (change < -thresholdPct) {
+                ++numRegressions;
+                std::cout << "REGRESSION  " << key << "  " << juce::String(change, 1) << "%\n";
+            }
+            else if (change > thresholdPct) {
+                ++numImprovements;
+                std::cout << "improvement " << key << "  +" << juce::String(change, 1) << "%\n";
+            }
+        }
+    }
+
+    std::cout << numCompared << " cases compared, " << numRegressions << " slower and "
+        << numImprovements << " faster than " << juce::String(thresholdPct, 1) << "% threshold\n";
+    return numRegressions;
+}
+
+void printUsage() {
+    std::cout <<
+        "Usage: AudioDeconstructorBenchmark [options] [audio files...]\n"
+        "\n"
+        "  --features=Amplitude,Pitch      extractors to run (default: all)\n"
+        "  --seconds=10                    length of generated signals\n"
+        "  --repeats=3                     runs per case, the fastest is kept\n"
+        "  --sample-rates=44100,48000,96000\n"
+        "  --windows=5,15,50               window sizes in ms\n"
+        "  --hops=25,50,75                 hop sizes in % of the window\n"
+        "  --quick                         2 s signals, 48 kHz, default window and hop\n"
+        "  --json=<file>                   write the results as JSON\n"
+        "  --compare=<baseline.json>       flag cases slower than the baseline\n"
+        "  --current=<results.json>        compare this file instead of running\n"
+        "  --threshold=5                   % change reported by --compare\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    juce::ArgumentList args(argc, argv);
+
+    if (args.containsOption("--help|-h")) {
+        printUsage();
+        return 0;
+    }
+
+    double threshold = args.containsOption("--threshold")
+        ? args.getValueForOption("--threshold").getDoubleValue() : 5.0;
+
+    if (args.containsOption("--current")) {
+        if (!args.containsOption("--compare")) {
+            printUsage();
+            return 1;
+        }
+        auto baseline = juce::JSON::parse(juce::File::getCurrentWorkingDirectory()
+            .getChildFile(args.getValueForOption("--compare")));
+        auto current = juce::JSON::parse(juce::File::getCurrentWorkingDirectory()
+            .getChildFile(args.getValueForOption("--current")));
+        return compareRuns(baseline, current, threshold) > 0 ? 1 : 0;
+    }
+
+    Options options;
+    if (args.containsOption("--quick")) {
+        options.seconds = 2.0;
+        options.sampleRates = { 48000.0 };
+        options.windowSizes = { FeatureExtractor::Settings().windowSizeMs };
+        options.hopSizes = { FeatureExtractor::Settings().hopSizePct };
+    }
+    if (args.containsOption("--seconds"))
+        options.seconds = juce::jmax(0.1, args.getValueForOption("--seconds").getDoubleValue());
+    if (args.containsOption("--repeats"))
+        options.repeats = juce::jmax(1, args.getValueForOption("--repeats").getIntValue());
+    if (args.containsOption("--sample-rates"))
+        options.sampleRates = parseNumbers(args.getValueForOption("--sample-rates"));
+    if (args.containsOption("--windows")) {
+        options.windowSizes.clear();
+        for (double value : parseNumbers(args.getValueForOption("--windows")))
+            options.windowSizes.add(juce::jlimit(1.0f, 100.0f, static_cast<float>(value)));
+    }
+    if (args.containsOption("--hops")) {
+        options.hopSizes.clear();
+        for (double value : parseNumbers(args.getValueForOption("--hops")))
+            options.hopSizes.add(juce::jlimit(10.0f, 90.0f, static_cast<float>(value)));
+    }
+
+    auto features = FeatureExtractorFactory::getAvailableFeatures();
+    if (args.containsOption("--features")) {
+        juce::StringArray requested;
+        requested.addTokens(args.getValueForOption("--features"), ",", {});
+        requested.trim();
+        requested.removeEmptyStrings();
+        for (const auto& feature : requested) {
+            if (!features.contains(feature)) {
+                std::cerr << "Unknown feature: " << feature << "\n";
+                return 1;
+            }
+        }
+        features = requested;
+    }
+
+    std::vector<CaseResult> results;
+
+    for (double sampleRate : options.sampleRates) {
+        for (const auto& signal : TestSignals::makeStandardSet(sampleRate, options.seconds, options.seed))
+            benchmarkSignal(signal, options, features, results);
+    }
+
+    for (const auto& arg : args.arguments) {
+        if (arg.isOption()) continue;
+
+        TestSignal signal;
+        if (!TestSignals::loadFile(arg.resolveAsFile(), signal)) {
+            std::cerr << "Can't read " << arg.text << "\n";
+            return 1;
+        }
+        benchmarkSignal(signal, options, features, results);
+    }
+
+    auto json = toJson(results, options);
+
+    if (args.containsOption("--json")) {
+        auto file = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--json"));
+        if (!file.replaceWithText(juce::JSON::toString(json))) {
+            std::cerr << "Can't write " << file.getFullPathName() << "\n";
+            return 1;
+        }
+    }
+
+    if (args.containsOption("--compare")) {
+        auto baseline = juce::JSON::parse(juce::File::getCurrentWorkingDirectory()
+            .getChildFile(args.getValueForOption("--compare")));
+        return compareRuns(baseline, json, threshold) > 0 ? 1 : 0;
+    }
+    return 0;
+}
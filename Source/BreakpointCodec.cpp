@@ -0,0 +1,289 @@
+// BreakpointCodec.cpp
+
+#include "BreakpointCodec.h"
+#include <cstring>
+
+namespace {
+
+class ByteWriter {
+public:
+    explicit ByteWriter(size_t expectedSize) { bytes.reserve(expectedSize); }
+
+    void writeVarint(juce::uint64 v) {
+        while (v >= 0x80) {
+            bytes.push_back(static_cast<juce::uint8>(v | 0x80));
+            v >>= 7;
+        }
+        bytes.push_back(static_cast<juce::uint8>(v));
+    }
+
+    void writeSigned(juce::int64 v) {
+        writeVarint((static_cast<juce::uint64>(v) << 1) ^ static_cast<juce::uint64>(v >> 63));
+    }
+
+    void writeDouble(double v) {
+        juce::uint8 raw[sizeof(double)];
+        std::memcpy(raw, &v, sizeof(double));
+        bytes.insert(bytes.end(), raw, raw + sizeof(double));
+    }
+
+    void writeByte(juce::uint8 v) { bytes.push_back(v); }
+
+    std::vector<juce::uint8> bytes;
+};
+
+class ByteReader {
+public:
+    ByteReader(const void* data, size_t size)
+        : p(static_cast<const juce::uint8*>(data)), end(p + size) {}
+
+    bool readVarint(juce::uint64& v) {
+        v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p == end) return false;
+            juce::uint8 b = *p++;
+            v |= static_cast<juce::uint64>(b & 0x7f) << shift;
+            if ((b & 0x80) == 0) return true;
+        }
+        return false;
+    }
+
+    bool readSigned(juce::int64& v) {
+        juce::uint64 u;
+        if (!readVarint(u)) return false;
+        v = static_cast<juce::int64>(u >> 1) ^ -static_cast<juce::int64>(u & 1);
+        return true;
+    }
+
+    bool readDouble(double& v) {
+        if (static_cast<size_t>(end - p) < sizeof(double)) return false;
+        std::memcpy(&v, p, sizeof(double));
+        p += sizeof(double);
+        return true;
+    }
+
+    bool readByte(juce::uint8& v) {
+        if (p == end) return false;
+        v = *p++;
+        return true;
+    }
+
+private:
+    const juce::uint8* p;
+    const juce::uint8* end;
+};
+
+// Quantized values must fit comfortably in an int64 and survive the
+// round trip through double without losing the unit step.
+constexpr double maxQuantized = 9.0e15;
+
+bool canQuantize(const BreakpointList& points, bool useTimes, double step) {
+    if (step <= 0.0) return false;
+    for (const auto& p : points) {
+        double v = useTimes ? p.first : p.second;
+        if (!std::isfinite(v) || std::abs(v / step) > maxQuantized)
+            return false;
+    }
+    return true;
+}
+
+bool isUniformGrid(const BreakpointList& points, double tolerance, double& start, double& hop) {
+    size_t n = points.size();
+    start = points.front().first;
+    hop = n > 1 ? (points.back().first - start) / static_cast<double>(n - 1) : 0.0;
+
+    if (!std::isfinite(start) || !std::isfinite(hop) || hop < 0.0) return false;
+
+    for (size_t i = 0; i < n; ++i) {
+        if (std::abs(points[i].first - (start + hop * static_cast<double>(i))) > tolerance)
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+void BreakpointCodec::encodeTrack(const BreakpointList& points, juce::MemoryBlock& dest,
+    const Options& options) {
+
+    ByteWriter out(32 + points.size() * 3);
+    size_t n = points.size();
+
+    double start = 0.0, hop = 0.0;
+    juce::uint8 flags = 0;
+
+    if (n > 0 && isUniformGrid(points, options.timeStep * 0.5, start, hop))
+        flags |= gridTimes;
+    else if (!canQuantize(points, true, options.timeStep))
+        flags |= rawTimes;
+
+    if (!canQuantize(points, false, options.valueStep))
+        flags |= rawValues;
+
+    out.writeByte(flags);
+    out.writeVarint(n);
+    if (n == 0) {
+        dest.replaceAll(out.bytes.data(), out.bytes.size());
+        return;
+    }
+
+    if (flags & gridTimes) {
+        out.writeDouble(start);
+        out.writeDouble(hop);
+    }
+    else if (flags & rawTimes) {
+        for (const auto& p : points)
+            out.writeDouble(p.first);
+    }
+    else {
+        // Near-regular tracks are mostly zero second differences, so those
+        // are stored as run lengths between the non-zero ones.
+        out.writeDouble(options.timeStep);
+        double inverseStep = 1.0 / options.timeStep;
+        juce::int64 previous = 0, previousDelta = 0;
+        juce::uint64 zeroRun = 0;
+        for (const auto& p : points) {
+            auto q = static_cast<juce::int64>(std::llround(p.first * inverseStep));
+            juce::int64 delta = q - previous;
+            juce::int64 deltaOfDelta = delta - previousDelta;
+            previous = q;
+            previousDelta = delta;
+
+            if (deltaOfDelta == 0) {
+                ++zeroRun;
+                continue;
+            }
+            out.writeVarint(zeroRun);
+            out.writeSigned(deltaOfDelta);
+            zeroRun = 0;
+        }
+        if (zeroRun > 0)
+            out.writeVarint(zeroRun);
+    }
+
+    if (flags & rawValues) {
+        for (const auto& p : points)
+            out.writeDouble(p.second);
+    }
+    else {
+        out.writeDouble(options.valueStep);
+        double inverseStep = 1.0 / options.valueStep;
+        juce::int64 previous = 0;
+        for (const auto& p : points) {
+            auto q = static_cast<juce::int64>(std::llround(p.second * inverseStep));
+            out.writeSigned(q - previous);
+            previous = q;
+        }
+    }
+
+    dest.replaceAll(out.bytes.data(), out.bytes.size());
+}
+
+bool BreakpointCodec::decodeTrack(const void* data, size_t size, BreakpointList& points) {
+    ByteReader in(data, size);
+
+    juce::uint8 flags = 0;
+    juce::uint64 count = 0;
+    if (!in.readByte(flags) || !in.readVarint(count)) return false;
+
+    // Values always take at least a byte per point, so a count larger than
+    // the payload means the data is corrupt.
+    if (count > size) return false;
+
+    points.clear();
+    points.resize(static_cast<size_t>(count));
+    if (count == 0) return true;
+
+    if (flags & gridTimes) {
+        double start, hop;
+        if (!in.readDouble(start) || !in.readDouble(hop)) return false;
+        for (size_t i = 0; i < points.size(); ++i)
+            points[i].first = start + hop * static_cast<double>(i);
+    }
+    else if (flags & rawTimes) {
+        for (auto& p : points)
+            if (!in.readDouble(p.first)) return false;
+    }
+    else {
+        double step;
+        if (!in.readDouble(step)) return false;
+        juce::int64 previous = 0, previousDelta = 0;
+        size_t i = 0;
+        while (i < points.size()) {
+            juce::uint64 zeroRun;
+            if (!in.readVarint(zeroRun) || zeroRun > points.size() - i) return false;
+
+            for (juce::uint64 z = 0; z < zeroRun; ++z, ++i) {
+                previous += previousDelta;
+                points[i].first = static_cast<double>(previous) * step;
+            }
+            if (i == points.size()) break;
+
+            juce::int64 deltaOfDelta;
+            if (!in.readSigned(deltaOfDelta)) return false;
+            previousDelta += deltaOfDelta;
+            previous += previousDelta;
+            points[i++].first = static_cast<double>(previous) * step;
+        }
+    }
+
+    if (flags & rawValues) {
+        for (auto& p : points)
+            if (!in.readDouble(p.second)) return false;
+    }
+    else {
+        double step;
+        if (!in.readDouble(step)) return false;
+        juce::int64 previous = 0;
+        for (auto& p : points) {
+            juce::int64 delta;
+            if (!in.readSigned(delta)) return false;
+            previous += delta;
+            p.second = static_cast<double>(previous) * step;
+        }
+    }
+
+    return true;
+}
+
+void BreakpointCodec::writeFeature(juce::OutputStream& stream, const juce::String& featureName,
+    const std::vector<BreakpointList>& outputs, const Options& options) {
+
+    stream.writeInt(static_cast<int>(featureMagic));
+    stream.writeByte(static_cast<char>(formatVersion));
+    stream.writeString(featureName);
+    stream.writeCompressedInt(static_cast<int>(outputs.size()));
+
+    juce::MemoryBlock encoded;
+    for (const auto& output : outputs) {
+        encodeTrack(output, encoded, options);
+        stream.writeInt64(static_cast<juce::int64>(encoded.getSize()));
+        stream.write(encoded.getData(), encoded.getSize());
+    }
+}
+
+bool BreakpointCodec::readFeature(juce::InputStream& stream, juce::String& featureName,
+    std::vector<BreakpointList>& outputs) {
+
+    if (static_cast<juce::uint32>(stream.readInt()) != featureMagic) return false;
+    if (stream.readByte() > formatVersion) return false;
+
+    featureName = stream.readString();
+    int numOutputs = stream.readCompressedInt();
+    if (numOutputs < 0 || numOutputs > 256) return false;
+
+    outputs.assign(static_cast<size_t>(numOutputs), {});
+
+    juce::MemoryBlock encoded;
+    for (auto& output : outputs) {
+        auto size = stream.readInt64();
+        if (size < 0 || size > stream.getNumBytesRemaining()) return false;
+
+        encoded.setSize(static_cast<size_t>(size));
+        if (stream.read(encoded.getData(), static_cast<int>(size)) != static_cast<int>(size))
+            return false;
+        if (!decodeTrack(encoded.getData(), encoded.getSize(), output))
+            return false;
+    }
+    return true;
+}
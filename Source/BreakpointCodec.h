@@ -0,0 +1,50 @@
+// BreakpointCodec.h
+#pragma once
+
+#include <JuceHeader.h>
+#include "FeatureExtractors.h"
+
+// Compact binary encoding for breakpoint tracks, used for compressed files and
+// the plugin state.
+//
+// Times on a uniform hop are stored as just a start and a step. Anything else
+// (hand-edited tracks, sparse events) is quantized to timeStep and stored as
+// run-length packed delta-of-delta varints. Values are quantized to valueStep and stored as
+// zigzag varint deltas, so every decoded time and value is within half a step
+// of the original. A step of zero keeps that column exact: times only use the
+// grid form if it reproduces every one bit for bit, and are otherwise stored
+// as raw doubles, as values are.
+class BreakpointCodec {
+public:
+    struct Options {
+        double timeStep = 1.0e-6;
+        double valueStep = 1.0e-6;
+
+        // Same resolution as the six decimal places of the .txt format.
+        static Options matchTextFormat() { return {}; }
+        static Options lossless() { return { 0.0, 0.0 }; }
+        // Enough for envelopes and automation; roughly 1.5 bytes per point.
+        static Options compact() { return { 1.0e-6, 1.0e-4 }; }
+    };
+
+    static void encodeTrack(const BreakpointList& points, juce::MemoryBlock& dest,
+        const Options& options);
+    static bool decodeTrack(const void* data, size_t size, BreakpointList& points);
+
+    // A whole feature: a small header followed by one length-prefixed track
+    // per output.
+    static void writeFeature(juce::OutputStream& stream, const juce::String& featureName,
+        const std::vector<BreakpointList>& outputs, const Options& options);
+    static bool readFeature(juce::InputStream& stream, juce::String& featureName,
+        std::vector<BreakpointList>& outputs);
+
+private:
+    static constexpr juce::uint32 featureMagic = 0x43424441; // "ADBC"
+    static constexpr int formatVersion = 1;
+
+    enum TrackFlags : juce::uint8 {
+        gridTimes = 1 << 0,
+        rawTimes = 1 << 1,
+        rawValues = 1 << 2
+    };
+};
@@ -0,0 +1,133 @@
+// BreakpointIndex.cpp
+#include "BreakpointIndex.h"
+
+void BreakpointIndex::Summary::add(const Summary& other) {
+    if (other.isEmpty()) return;
+
+    if (isEmpty()) {
+        *this = other;
+        return;
+    }
+    last = other.last;
+    minValue = juce::jmin(minValue, other.minValue);
+    maxValue = juce::jmax(maxValue, other.maxValue);
+}
+
+void BreakpointIndex::build(const BreakpointList& track) {
+    points = &track;
+    blockStartTimes.clear();
+    levels.clear();
+    if (track.empty()) return;
+
+    size_t numBlocks = (track.size() + blockSize - 1) / blockSize;
+    blockStartTimes.reserve(numBlocks);
+
+    std::vector<Summary> level;
+    level.reserve(numBlocks);
+    for (size_t start = 0; start < track.size(); start += blockSize) {
+        size_t end = juce::jmin(track.size(), start + static_cast<size_t>(blockSize));
+        blockStartTimes.push_back(track[start].first);
+
+        auto value = static_cast<float>(track[start].second);
+        Summary block{ value, static_cast<float>(track[end - 1].second), value, value };
+        for (size_t i = start + 1; i < end; ++i) {
+            value = static_cast<float>(track[i].second);
+            block.minValue = juce::jmin(block.minValue, value);
+            block.maxValue = juce::jmax(block.maxValue, value);
+        }
+        level.push_back(block);
+    }
+    levels.push_back(std::move(level));
+
+    while (levels.back().size() > 1) {
+        const auto& previous = levels.back();
+        std::vector<Summary> next;
+        next.reserve((previous.size() + blockSize - 1) / blockSize);
+        for (size_t start = 0; start < previous.size(); start += blockSize) {
+            size_t end = juce::jmin(previous.size(), start + static_cast<size_t>(blockSize));
+            Summary block = previous[start];
+            for (size_t i = start + 1; i < end; ++i)
+                block.add(previous[i]);
+            next.push_back(block);
+        }
+        levels.push_back(std::move(next));
+    }
+}
+
+size_t BreakpointIndex::getPointsPerEntry(int level) const {
+    size_t count = blockSize;
+    for (int i = 0; i < level; ++i)
+        count *= blockSize;
+    return count;
+}
+
+size_t BreakpointIndex::lowerBound(double time) const {
+    if (points == nullptr || points->empty()) return 0;
+
+    // The last block starting before time holds the answer, unless that is
+    // the start of the next block.
+    auto block = std::lower_bound(blockStartTimes.begin(), blockStartTimes.end(), time);
+    if (block == blockStartTimes.begin()) return 0;
+
+    size_t first = static_cast<size_t>(block - blockStartTimes.begin() - 1) * blockSize;
+    size_t last = juce::jmin(points->size(), first + static_cast<size_t>(blockSize));
+    auto it = std::lower_bound(points->begin() + static_cast<std::ptrdiff_t>(first),
+        points->begin() + static_cast<std::ptrdiff_t>(last), time,
+        [](const std::pair<double, double>& point, double t) { return point.first < t; });
+    return static_cast<size_t>(it - points->begin());
+}
+
+std::pair<size_t, size_t> BreakpointIndex::findRange(double startTime, double endTime) const {
+    if (points == nullptr || endTime < startTime) return { 0, 0 };
+
+    size_t first = lowerBound(startTime);
+    size_t last = lowerBound(std::nextafter(endTime, std::numeric_limits<double>::infinity()));
+    return { first, juce::jmax(first, last) };
+}
+
+BreakpointSpan BreakpointIndex::getSpan(size_t first, size_t last) const {
+    last = juce::jmin(last, size());
+    if (first >= last) return {};
+    return { points->data() + first, last - first };
+}
+
+BreakpointSpan BreakpointIndex::getSpan(double startTime, double endTime) const {
+    auto range = findRange(startTime, endTime);
+    return getSpan(range.first, range.second);
+}
+
+BreakpointIndex::Summary BreakpointIndex::summarise(size_t first, size_t last) const {
+    Summary result;
+    last = juce::jmin(last, size());
+
+    // Walk left to right, each step taking the coarsest entry that starts at
+    // the current point and ends inside the range.
+    size_t i = first;
+    while (i < last) {
+        int level = -1;
+        size_t step = 1;
+        while (level + 1 < getNumLevels()) {
+            size_t entry = step * blockSize;
+            if (i % entry != 0 || i + entry > last) break;
+            ++level;
+            step = entry;
+        }
+
+        if (level < 0) {
+            auto value = static_cast<float>((*points)[i].second);
+            result.add({ value, value, value, value });
+        }
+        else {
+            result.add(levels[static_cast<size_t>(level)][i / step]);
+        }
+        i += step;
+    }
+    return result;
+}
+
+juce::int64 BreakpointIndex::getMemoryBytes() const {
+    auto bytes = static_cast<juce::int64>(blockStartTimes.capacity() * sizeof(double));
+    for (const auto& level : levels)
+        bytes += static_cast<juce::int64>(level.capacity() * sizeof(Summary));
+    return bytes;
+}
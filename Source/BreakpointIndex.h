@@ -0,0 +1,71 @@
+// BreakpointIndex.h
+#pragma once
+
+#include <JuceHeader.h>
+#include "FeatureExtractors.h"
+
+// A run of consecutive breakpoints inside a stored track; nothing is copied.
+struct BreakpointSpan {
+    const std::pair<double, double>* data = nullptr;
+    size_t count = 0;
+
+    const std::pair<double, double>* begin() const { return data; }
+    const std::pair<double, double>* end() const { return data + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const std::pair<double, double>& operator[](size_t index) const { return data[index]; }
+};
+
+// Time index over one track, which must be sorted by time. The start time of
+// every block of blockSize points is kept in a column of its own, so a time
+// lookup binary searches that short column and then a single block. Each
+// block also has a min/max summary, and the summaries are grouped again by
+// blockSize into coarser levels until one block covers the track.
+//
+// The index points at the track and has to be rebuilt after it changes.
+class BreakpointIndex {
+public:
+    static constexpr int blockSize = 16;
+
+    struct Summary {
+        float first = 0.0f;
+        float last = 0.0f;
+        float minValue = 1.0f;  // inverted while empty
+        float maxValue = 0.0f;
+
+        bool isEmpty() const { return minValue > maxValue; }
+        void add(const Summary& other);
+    };
+
+    BreakpointIndex() = default;
+    explicit BreakpointIndex(const BreakpointList& points) { build(points); }
+
+    void build(const BreakpointList& points);
+
+    const BreakpointList* getPoints() const { return points; }
+    size_t size() const { return points != nullptr ? points->size() : 0; }
+
+    // Index of the first point at or after time.
+    size_t lowerBound(double time) const;
+    // Index range of the points with startTime <= time <= endTime.
+    std::pair<size_t, size_t> findRange(double startTime, double endTime) const;
+    BreakpointSpan getSpan(size_t first, size_t last) const;
+    BreakpointSpan getSpan(double startTime, double endTime) const;
+
+    // Values of the points in [first, last), from whole blocks where possible.
+    Summary summarise(size_t first, size_t last) const;
+    Summary getOverallSummary() const { return levels.empty() ? Summary{} : levels.back().front(); }
+
+    // Level 0 summarises blockSize points per entry, level n blockSize^(n+1).
+    int getNumLevels() const { return static_cast<int>(levels.size()); }
+    size_t getPointsPerEntry(int level) const;
+    const std::vector<Summary>& getLevel(int level) const { return levels[static_cast<size_t>(level)]; }
+
+    // What the index holds on top of the track it points at.
+    juce::int64 getMemoryBytes() const;
+
+private:
+    const BreakpointList* points = nullptr;
+    std::vector<double> blockStartTimes;
+    std::vector<std::vector<Summary>> levels;
+};
@@ -0,0 +1,128 @@
+// BreakpointOperations.cpp
+#include "BreakpointOperations.h"
+
+using FVO = juce::FloatVectorOperations;
+
+BreakpointOperations::Columns BreakpointOperations::Columns::fromPoints(BreakpointSpan points) {
+    Columns columns;
+    columns.times.resize(points.size());
+    columns.values.resize(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        columns.times[i] = points[i].first;
+        columns.values[i] = points[i].second;
+    }
+    return columns;
+}
+
+BreakpointList BreakpointOperations::Columns::toPoints() const {
+    BreakpointList points(times.size());
+    for (size_t i = 0; i < times.size(); ++i)
+        points[i] = { times[i], values[i] };
+    return points;
+}
+
+void BreakpointOperations::scale(Columns& columns, double factor, double pivot) {
+    auto* values = columns.values.data();
+    FVO::add(values, -pivot, columns.size());
+    FVO::multiply(values, factor, columns.size());
+    FVO::add(values, pivot, columns.size());
+}
+
+void BreakpointOperations::offset(Columns& columns, double amount) {
+    FVO::add(columns.values.data(), amount, columns.size());
+}
+
+void BreakpointOperations::clamp(Columns& columns, double low, double high) {
+    FVO::clip(columns.values.data(), columns.values.data(), juce::jmin(low, high), juce::jmax(low, high),
+        columns.size());
+}
+
+void BreakpointOperations::invert(Columns& columns) {
+    if (columns.size() == 0) return;
+
+    auto range = FVO::findMinAndMax(columns.values.data(), columns.size());
+    FVO::negate(columns.values.data(), columns.values.data(), columns.size());
+    FVO::add(columns.values.data(), range.getStart() + range.getEnd(), columns.size());
+}
+
+void BreakpointOperations::quantize(Columns& columns, double step) {
+    if (step <= 0.0) return;
+
+    // No vector op for rounding; this loop vectorizes as it stands.
+    auto* values = columns.values.data();
+    double inverse = 1.0 / step;
+    for (int i = 0; i < columns.size(); ++i)
+        values[i] = std::nearbyint(values[i] * inverse) * step;
+}
+
+void BreakpointOperations::stretch(Columns& columns, double origin, double factor) {
+    auto* times = columns.times.data();
+    FVO::add(times, -origin, columns.size());
+    FVO::multiply(times, factor, columns.size());
+    FVO::add(times, origin, columns.size());
+}
+
+void BreakpointOperations::crossfade(Columns& columns, const BreakpointList& other, double startTime, double endTime) {
+    int n = columns.size();
+    if (n == 0 || other.empty()) return;
+
+    // values += weight * (other - values), the weight rising 0 -> 1 over the range.
+    std::vector<double> difference(static_cast<size_t>(n));
+    std::vector<double> weight(static_cast<size_t>(n));
+    sample(other, columns.times.data(), difference.data(), n);
+    FVO::subtract(difference.data(), columns.values.data(), n);
+
+    double length = juce::jmax(endTime - startTime, 1.0e-12);
+    FVO::copy(weight.data(), columns.times.data(), n);
+    FVO::add(weight.data(), -startTime, n);
+    FVO::multiply(weight.data(), 1.0 / length, n);
+    FVO::clip(weight.data(), weight.data(), 0.0, 1.0, n);
+
+    FVO::multiply(difference.data(), weight.data(), n);
+    FVO::add(columns.values.data(), difference.data(), n);
+}
+
+BreakpointOperations::Columns BreakpointOperations::resample(const BreakpointList& track,
+    double startTime, double endTime, int numPoints) {
+
+    Columns columns;
+    if (numPoints <= 0 || track.empty()) return columns;
+
+    columns.times.resize(static_cast<size_t>(numPoints));
+    columns.values.resize(static_cast<size_t>(numPoints));
+
+    double step = numPoints > 1 ? (endTime - startTime) / (numPoints - 1) : 0.0;
+    for (int i = 0; i < numPoints; ++i)
+        columns.times[static_cast<size_t>(i)] = startTime + step * i;
+
+    sample(track, columns.times.data(), columns.values.data(), numPoints);
+    return columns;
+}
+
+void BreakpointOperations::sample(const BreakpointList& track, const double* times, double* dest, int numTimes) {
+    if (track.empty()) {
+        FVO::clear(dest, numTimes);
+        return;
+    }
+
+    // The times ascend, so one cursor walks the track once.
+    size_t next = 0;
+    for (int i = 0; i < numTimes; ++i) {
+        double time = times[i];
+        while (next < track.size() && track[next].first <= time)
+            ++next;
+
+        if (next == 0) {
+            dest[i] = track.front().second;
+        }
+        else if (next == track.size()) {
+            dest[i] = track.back().second;
+        }
+        else {
+            const auto& a = track[next - 1];
+            const auto& b = track[next];
+            double span = b.first - a.first;
+            dest[i] = span > 0.0 ? a.second + (b.second - a.second) * (time - a.first) / span : b.second;
+        }
+    }
+}
@@ -0,0 +1,44 @@
+// BreakpointOperations.h
+#pragma once
+
+#include <JuceHeader.h>
+#include "FeatureExtractors.h"
+#include "BreakpointIndex.h"
+
+// Bulk edits over a run of breakpoints. The run is split into a column of
+// times and a column of values so each edit is a few FloatVectorOperations
+// passes over contiguous doubles rather than a loop over pairs.
+class BreakpointOperations {
+public:
+    struct Columns {
+        std::vector<double> times;
+        std::vector<double> values;
+
+        int size() const { return static_cast<int>(times.size()); }
+
+        static Columns fromPoints(BreakpointSpan points);
+        BreakpointList toPoints() const;
+    };
+
+    // value = pivot + (value - pivot) * factor
+    static void scale(Columns& columns, double factor, double pivot = 0.0);
+    static void offset(Columns& columns, double amount);
+    static void clamp(Columns& columns, double low, double high);
+    // Mirrors the values about the middle of their own range.
+    static void invert(Columns& columns);
+    // Rounds every value to the nearest multiple of step.
+    static void quantize(Columns& columns, double step);
+    // time = origin + (time - origin) * factor
+    static void stretch(Columns& columns, double origin, double factor);
+    // Moves from the track's own value at startTime to other's at endTime,
+    // with a linear crossfade in between.
+    static void crossfade(Columns& columns, const BreakpointList& other, double startTime, double endTime);
+
+    // numPoints evenly spaced points from startTime to endTime following the
+    // track's linear interpolation.
+    static Columns resample(const BreakpointList& track, double startTime, double endTime, int numPoints);
+
+    // The track's linearly interpolated value at each of the ascending times,
+    // holding the first and last values outside it.
+    static void sample(const BreakpointList& track, const double* times, double* dest, int numTimes);
+};
@@ -0,0 +1,238 @@
+// BreakpointPlayer.cpp
+
+#include "BreakpointPlayer.h"
+
+std::unique_ptr<EnvelopeTrack> EnvelopeTrack::fromBreakpoints(const BreakpointList& points) {
+    auto track = std::make_unique<EnvelopeTrack>();
+    track->times.reserve(points.size());
+    track->values.reserve(points.size());
+
+    for (const auto& [time, value] : points) {
+        if (!std::isfinite(time) || !std::isfinite(value)) continue;
+        track->times.push_back(time);
+        track->values.push_back(static_cast<float>(value));
+    }
+    return track;
+}
+
+juce::int64 EnvelopeTrack::getMemoryBytes() const {
+    return static_cast<juce::int64>(times.capacity() * sizeof(double) + values.capacity() * sizeof(float));
+}
+
+std::unique_ptr<EnvelopeTrack> EnvelopeTrack::fromEvents(const BreakpointList& events,
+    double holdSeconds, double rampSeconds) {
+
+    auto track = std::make_unique<EnvelopeTrack>();
+    auto add = [&track](double time, double value) {
+        track->times.push_back(time);
+        track->values.push_back(static_cast<float>(value));
+    };
+
+    for (size_t i = 0; i < events.size(); ++i) {
+        auto [time, value] = events[i];
+        if (!std::isfinite(time) || !std::isfinite(value)) continue;
+        double next = i + 1 < events.size() ? events[i + 1].first : std::numeric_limits<double>::max();
+
+        if (track->times.empty() || track->times.back() < time - rampSeconds)
+            add(time - rampSeconds, 0.0);
+        add(time, value);
+
+        // Events closer than a pulse run straight into one another.
+        if (next - time > holdSeconds + 2.0 * rampSeconds) {
+            add(time + holdSeconds, value);
+            add(time + holdSeconds + rampSeconds, 0.0);
+        }
+        else if (next - rampSeconds > time) {
+            add(next - rampSeconds, value);
+        }
+    }
+    return track;
+}
+
+void BreakpointPlayer::fillRamp(float* dest, float start, float step, int numSamples) {
+    // No loop-carried dependency, so the compiler can vectorize it.
+    for (int i = 0; i < numSamples; ++i)
+        dest[i] = start + step * static_cast<float>(i);
+}
+
+BreakpointPlayer::~BreakpointPlayer() {
+    delete current;
+    delete incoming.exchange(nullptr);
+    delete retired.exchange(nullptr);
+}
+
+void BreakpointPlayer::setTrack(std::unique_ptr<EnvelopeTrack> track) {
+    trackBytes.store(track != nullptr ? track->getMemoryBytes() : 0, std::memory_order_relaxed);
+    staleFirst = 0;
+    staleLast = SIZE_MAX;
+    incomingPatched = false;
+
+    // A track the audio thread never picked up can go straight away.
+    delete incoming.exchange(track != nullptr ? track.release() : new EnvelopeTrack());
+
+    // The audio thread only retires a track into an empty slot, so whatever
+    // is here is no longer referenced. Emptying it only after the new track
+    // is in place means the audio thread can't fill it with an older track
+    // meanwhile and then refuse the new one.
+    delete retired.exchange(nullptr);
+}
+
+bool BreakpointPlayer::patchTrack(const BreakpointList& points, size_t first, size_t last) {
+    // A track the audio thread hasn't picked up yet is only this edit
+    // behind, once it has been patched at all (fromBreakpoints may skip
+    // points). One it handed back is also behind by the edits since.
+    size_t from = 0, to = SIZE_MAX;
+    auto* track = incoming.exchange(nullptr, std::memory_order_acq_rel);
+    if (track != nullptr) {
+        if (incomingPatched) {
+            from = first;
+            to = last;
+        }
+        staleFirst = juce::jmin(staleFirst, first);
+        staleLast = juce::jmax(staleLast, last);
+    }
+    else if ((track = retired.exchange(nullptr, std::memory_order_acq_rel)) != nullptr) {
+        from = juce::jmin(staleFirst, first);
+        to = juce::jmax(staleLast, last);
+        staleFirst = first;
+        staleLast = last;
+    }
+    else {
+        return false;
+    }
+
+    if (!copyPoints(*track, points, from, to)) {
+        delete track;
+        return false;
+    }
+    trackBytes.store(track->getMemoryBytes(), std::memory_order_relaxed);
+    incomingPatched = true;
+    incoming.store(track, std::memory_order_release);
+    return true;
+}
+
+bool BreakpointPlayer::copyPoints(EnvelopeTrack& track, const BreakpointList& points, size_t first, size_t last) {
+    track.times.resize(points.size());
+    track.values.resize(points.size());
+
+    for (size_t i = first; i < juce::jmin(last, points.size()); ++i) {
+        auto [time, value] = points[i];
+        if (!std::isfinite(time) || !std::isfinite(value)) return false;
+        track.times[i] = time;
+        track.values[i] = static_cast<float>(value);
+    }
+    return true;
+}
+
+void BreakpointPlayer::takeIncomingTrack() {
+    if (retired.load(std::memory_order_acquire) != nullptr) return;
+
+    if (auto* next = incoming.exchange(nullptr, std::memory_order_acq_rel)) {
+        retired.store(current, std::memory_order_release);
+        current = next;
+        cursor = 0;
+        expectedTime = -1.0;
+    }
+}
+
+bool BreakpointPlayer::render(float* dest, int numSamples, double startTime) {
+    takeIncomingTrack();
+
+    if (current == nullptr || current->times.empty() || numSamples <= 0) return false;
+
+    // Anything other than continuing exactly where the last block ended is a
+    // jump.
+    if (std::abs(startTime - expectedTime) * sampleRate > 0.5)
+        seek(startTime);
+
+    int interval = controlInterval.load(std::memory_order_relaxed);
+    if (interval > 1)
+        renderControlRate(dest, numSamples, startTime, interval);
+    else
+        renderSampleAccurate(dest, numSamples, startTime);
+
+    expectedTime = startTime + numSamples / sampleRate;
+    lastValue.store(dest[numSamples - 1], std::memory_order_relaxed);
+    return true;
+}
+
+void BreakpointPlayer::seek(double time) {
+    const auto& times = current->times;
+    auto it = std::upper_bound(times.begin(), times.end(), time);
+    cursor = it == times.begin() ? 0 : static_cast<size_t>(std::distance(times.begin(), it)) - 1;
+}
+
+void BreakpointPlayer::advanceTo(double time) {
+    const auto& times = current->times;
+    int steps = 0;
+    while (cursor + 1 < times.size() && times[cursor + 1] <= time) {
+        if (++steps > maxLinearSteps) {
+            seek(time);
+            return;
+        }
+        ++cursor;
+    }
+}
+
+double BreakpointPlayer::valueAt(double time) {
+    advanceTo(time);
+
+    const auto& times = current->times;
+    const auto& values = current->values;
+
+    if (time <= times[cursor] || cursor + 1 >= times.size())
+        return values[cursor];
+
+    double t0 = times[cursor], t1 = times[cursor + 1];
+    double position = (time - t0) / (t1 - t0);
+    return values[cursor] + position * (values[cursor + 1] - values[cursor]);
+}
+
+void BreakpointPlayer::renderSampleAccurate(float* dest, int numSamples, double startTime) {
+    const auto& times = current->times;
+    const auto& values = current->values;
+    double samplePeriod = 1.0 / sampleRate;
+
+    int i = 0;
+    while (i < numSamples) {
+        double time = startTime + i * samplePeriod;
+        advanceTo(time);
+
+        // Before the first point or after the last, hold the end value.
+        if (time < times.front() || cursor + 1 >= times.size()) {
+            bool beforeStart = time < times.front();
+            int run = numSamples - i;
+            if (beforeStart) {
+                run = juce::jlimit(1, numSamples - i,
+                    static_cast<int>(std::ceil((times.front() - time) * sampleRate)));
+            }
+            juce::FloatVectorOperations::fill(dest + i, values[beforeStart ? 0 : cursor], run);
+            i += run;
+            continue;
+        }
+
+        // One linear ramp for every sample that falls inside this segment.
+        double t0 = times[cursor], t1 = times[cursor + 1];
+        double slope = (values[cursor + 1] - values[cursor]) / (t1 - t0);
+        int run = juce::jlimit(1, numSamples - i,
+            static_cast<int>(std::ceil((t1 - time) * sampleRate)));
+
+        fillRamp(dest + i, static_cast<float>(values[cursor] + slope * (time - t0)),
+            static_cast<float>(slope * samplePeriod), run);
+        i += run;
+    }
+}
+
+void BreakpointPlayer::renderControlRate(float* dest, int numSamples, double startTime, int interval) {
+    double samplePeriod = 1.0 / sampleRate;
+    double previous = valueAt(startTime);
+
+    for (int i = 0; i < numSamples; i += interval) {
+        int run = juce::jmin(interval, numSamples - i);
+        double next = valueAt(startTime + (i + run) * samplePeriod);
+
+        fillRamp(dest + i, static_cast<float>(previous),
+            static_cast<float>((next - previous) / run), run);
+        previous = next;
+    }
+}
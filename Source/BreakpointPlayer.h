@@ -0,0 +1,98 @@
+// BreakpointPlayer.h
+#pragma once
+
+#include <JuceHeader.h>
+#include "FeatureExtractors.h"
+
+// Read-only copy of one breakpoint track for the audio thread. Times and
+// values are kept in separate arrays so the cursor scans only the times.
+struct EnvelopeTrack {
+    std::vector<double> times;
+    std::vector<float> values;
+
+    static std::unique_ptr<EnvelopeTrack> fromBreakpoints(const BreakpointList& points);
+    juce::int64 getMemoryBytes() const;
+    // Event tracks (FeatureExtractor::emitsEvents) as pulses: each event's
+    // strength is held for holdSeconds, or until the next event, and the
+    // track is 0 in between. Edges ramp over rampSeconds so gains don't click.
+    static std::unique_ptr<EnvelopeTrack> fromEvents(const BreakpointList& events,
+        double holdSeconds = eventHoldSeconds, double rampSeconds = eventRampSeconds);
+
+    static constexpr double eventHoldSeconds = 0.05;
+    static constexpr double eventRampSeconds = 0.001;
+};
+
+// Renders a breakpoint track as a linearly interpolated envelope.
+//
+// The message thread hands tracks over through an atomic slot and gets the
+// replaced one back through a second slot, so the audio thread never
+// allocates, frees or locks. A cursor follows the transport: normal playback
+// moves it forward a segment at a time, and any jump (a locate, a loop, a
+// skipped block) falls back to a binary search.
+class BreakpointPlayer {
+public:
+    BreakpointPlayer() = default;
+    ~BreakpointPlayer();
+
+    // Message thread. Passing nullptr clears the track.
+    void setTrack(std::unique_ptr<EnvelopeTrack> track);
+
+    // Message thread. Brings the track in line with points after an edit
+    // that changed only points [first, last), or everything from first on
+    // when the number of points changed (pass SIZE_MAX). The track the audio
+    // thread last handed back is reused and only the points changed since
+    // it was current are converted. Returns false, leaving the player as it
+    // was, when there is no track to reuse or a changed point isn't finite;
+    // call setTrack then.
+    bool patchTrack(const BreakpointList& points, size_t first, size_t last);
+
+    // Samples between evaluated points when rendering at control rate; the
+    // envelope is ramped linearly between them. 0 renders every sample.
+    void setControlInterval(int numSamples) { controlInterval = juce::jmax(0, numSamples); }
+
+    void prepare(double newSampleRate) { sampleRate = newSampleRate; }
+
+    // Audio thread. Writes numSamples of envelope starting at startTime
+    // seconds. Returns false, leaving dest untouched, if there is no track.
+    bool render(float* dest, int numSamples, double startTime);
+
+    float getLastValue() const { return lastValue.load(std::memory_order_relaxed); }
+
+    // Size of the last track handed over, from any thread.
+    juce::int64 getTrackBytes() const { return trackBytes.load(std::memory_order_relaxed); }
+
+    // dest[i] = start + step * i
+    static void fillRamp(float* dest, float start, float step, int numSamples);
+
+private:
+    std::atomic<EnvelopeTrack*> incoming{ nullptr };
+    std::atomic<EnvelopeTrack*> retired{ nullptr };
+
+    // Audio thread state
+    EnvelopeTrack* current = nullptr;
+    size_t cursor = 0;
+    double expectedTime = -1.0;
+
+    double sampleRate = 44100.0;
+    std::atomic<int> controlInterval{ 0 };
+    std::atomic<float> lastValue{ 0.0f };
+    std::atomic<juce::int64> trackBytes{ 0 };
+
+    // Message thread state: the points where the track the audio thread
+    // will hand back differs from the one handed over last.
+    size_t staleFirst = 0;
+    size_t staleLast = SIZE_MAX;
+    bool incomingPatched = false; // the handed-over track matches the points exactly
+
+    static constexpr int maxLinearSteps = 8;
+
+    void takeIncomingTrack();
+    static bool copyPoints(EnvelopeTrack& track, const BreakpointList& points, size_t first, size_t last);
+    void seek(double time);
+    void advanceTo(double time);
+    double valueAt(double time);
+    void renderSampleAccurate(float* dest, int numSamples, double startTime);
+    void renderControlRate(float* dest, int numSamples, double startTime, int interval);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BreakpointPlayer)
+};
@@ -0,0 +1,225 @@
+// BreakpointTextIO.cpp
+
+#include "BreakpointTextIO.h"
+#include <charconv>
+#include <cstring>
+
+BreakpointTextWriter::BreakpointTextWriter(juce::OutputStream& s)
+    : stream(s), buffer(bufferSize) {}
+
+BreakpointTextWriter::~BreakpointTextWriter() {
+    flush();
+}
+
+void BreakpointTextWriter::writeRaw(const char* data, size_t size) {
+    while (size > 0) {
+        if (used == bufferSize)
+            flush();
+
+        size_t toCopy = std::min(size, bufferSize - used);
+        std::memcpy(buffer + used, data, toCopy);
+        used += toCopy;
+        data += toCopy;
+        size -= toCopy;
+    }
+}
+
+void BreakpointTextWriter::writeComment(const juce::String& text) {
+    writeRaw("# ", 2);
+    writeRaw(text.toRawUTF8(), text.getNumBytesAsUTF8());
+    writeRaw("\n", 1);
+}
+
+void BreakpointTextWriter::writeBlankLine() {
+    writeRaw("\n", 1);
+}
+
+char* BreakpointTextWriter::writeNumber(char* dest, double number) {
+    char* limit = dest + maxNumberLength;
+
+    // Fixed-point through integer to_chars: round to micro-units once and
+    // print the two halves, which is both faster than the floating-point
+    // overload and rounds the way juce::String(x, 6) did.
+    if (std::abs(number) < 1.0e12) {
+        auto scaled = static_cast<juce::int64>(std::abs(number) * decimalScale + 0.5);
+        if (number < 0.0 && scaled != 0)
+            *dest++ = '-';
+
+        dest = std::to_chars(dest, limit, scaled / decimalScale).ptr;
+        *dest++ = '.';
+
+        auto fraction = static_cast<int>(scaled % decimalScale);
+        for (int i = decimalPlaces - 1; i >= 0; --i) {
+            dest[i] = static_cast<char>('0' + fraction % 10);
+            fraction /= 10;
+        }
+        return dest + decimalPlaces;
+    }
+
+    return std::to_chars(dest, limit, number, std::chars_format::scientific,
+        decimalPlaces).ptr;
+}
+
+void BreakpointTextWriter::writePoint(double time, double value) {
+    if (bufferSize - used < maxLineLength)
+        flush();
+
+    char* p = buffer + used;
+    p = writeNumber(p, time);
+    *p++ = '\t';
+    p = writeNumber(p, value);
+    *p++ = '\n';
+    used = static_cast<size_t>(p - buffer.get());
+}
+
+void BreakpointTextWriter::writePoints(const BreakpointList& points) {
+    for (const auto& [time, value] : points)
+        writePoint(time, value);
+}
+
+bool BreakpointTextWriter::flush() {
+    if (used > 0) {
+        ok = stream.write(buffer, used) && ok;
+        used = 0;
+    }
+    return ok;
+}
+
+const BreakpointTextParser::Section* BreakpointTextParser::Result::findSection(
+    const juce::String& name) const {
+    for (const auto& section : sections)
+        if (section.name == name)
+            return &section;
+    return nullptr;
+}
+
+BreakpointTextParser::Result BreakpointTextParser::parse(juce::InputStream& stream) {
+    Result result;
+    result.sections.emplace_back();
+
+    std::vector<char> chunk(chunkSize);
+    size_t carried = 0;
+
+    while (true) {
+        // Lines longer than a chunk are rare; grow rather than split them.
+        if (carried == chunk.size())
+            chunk.resize(chunk.size() * 2);
+
+        int bytesRead = stream.read(chunk.data() + carried,
+            static_cast<int>(chunk.size() - carried));
+        size_t available = carried + static_cast<size_t>(juce::jmax(0, bytesRead));
+        bool finished = bytesRead <= 0;
+
+        const char* lineStart = chunk.data();
+        const char* end = chunk.data() + available;
+
+        while (true) {
+            auto* newline = static_cast<const char*>(std::memchr(lineStart, '\n',
+                static_cast<size_t>(end - lineStart)));
+            if (newline == nullptr) break;
+
+            parseLine(lineStart, newline, result);
+            lineStart = newline + 1;
+        }
+
+        carried = static_cast<size_t>(end - lineStart);
+
+        if (finished) {
+            if (carried > 0)
+                parseLine(lineStart, end, result);
+            break;
+        }
+
+        std::memmove(chunk.data(), lineStart, carried);
+    }
+
+    auto& sections = result.sections;
+    sections.erase(std::remove_if(sections.begin(), sections.end(),
+        [](const Section& s) { return s.points.empty(); }), sections.end());
+
+    return result;
+}
+
+void BreakpointTextParser::parseLine(const char* begin, const char* end, Result& result) {
+    while (begin < end && (*begin == ' ' || *begin == '\t'))
+        ++begin;
+    while (end > begin && (end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t'))
+        --end;
+
+    if (begin == end) return;
+
+    if (*begin == '#') {
+        parseComment(begin + 1, end, result);
+        return;
+    }
+
+    double time = 0.0, value = 0.0;
+    if (parsePoint(begin, end, time, value))
+        result.sections.back().points.emplace_back(time, value);
+}
+
+void BreakpointTextParser::parseComment(const char* begin, const char* end, Result& result) {
+    auto text = juce::String::fromUTF8(begin, static_cast<int>(end - begin)).trim();
+    if (text.isEmpty() || text == "Audio Deconstructor Breakpoint File") return;
+
+    auto key = text.upToFirstOccurrenceOf(":", false, false);
+    auto value = text.fromFirstOccurrenceOf(":", false, false).trim();
+
+    if (key == "Feature") { result.featureName = value; return; }
+    if (key == "Source") { result.sourceName = value; return; }
+    if (key == "Sample Rate") { result.sampleRate = value.getDoubleValue(); return; }
+    if (key == "Generated" || key == "Format") return;
+
+    result.sections.push_back({ text, {} });
+}
+
+bool BreakpointTextParser::parsePoint(const char* begin, const char* end,
+    double& time, double& value) {
+
+    double* targets[] = { &time, &value };
+    const char* p = begin;
+
+    for (auto* target : targets) {
+        while (p < end && (*p == ' ' || *p == '\t'))
+            ++p;
+        if (p < end && *p == '+')
+            ++p;
+
+        auto [ptr, ec] = std::from_chars(p, end, *target);
+        if (ec != std::errc()) return false;
+        p = ptr;
+    }
+
+    // Anything after the value must be whitespace or a trailing comment.
+    while (p < end && (*p == ' ' || *p == '\t'))
+        ++p;
+    return p == end || *p == '#';
+}
+
+bool BreakpointFileFormat::write(juce::OutputStream& stream,
+    const juce::String& featureName,
+    const juce::String& sourceName,
+    double sampleRate,
+    const juce::StringArray& outputNames,
+    const std::vector<BreakpointList>& outputs) {
+
+    BreakpointTextWriter writer(stream);
+
+    writer.writeComment("Audio Deconstructor Breakpoint File");
+    writer.writeComment("Feature: " + featureName);
+    writer.writeComment("Source: " + sourceName);
+    writer.writeComment("Sample Rate: " + juce::String(sampleRate) + " Hz");
+    writer.writeComment("Generated: " + juce::Time::getCurrentTime().toString(true, true));
+    writer.writeComment("Format: time(seconds) value");
+    writer.writeBlankLine();
+
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        int index = static_cast<int>(i);
+        writer.writeComment(index < outputNames.size() ? outputNames[index]
+            : "Output " + juce::String(index + 1));
+        writer.writePoints(outputs[i]);
+        writer.writeBlankLine();
+    }
+
+    return writer.flush();
+}
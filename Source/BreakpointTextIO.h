@@ -0,0 +1,82 @@
+// BreakpointTextIO.h
+#pragma once
+
+#include <JuceHeader.h>
+#include "FeatureExtractors.h"
+
+// Buffered writer for the "time<TAB>value" breakpoint text format. Numbers go
+// straight into a fixed buffer through std::to_chars, so writing a track costs
+// no allocation per line.
+class BreakpointTextWriter {
+public:
+    explicit BreakpointTextWriter(juce::OutputStream& stream);
+    ~BreakpointTextWriter();
+
+    void writeComment(const juce::String& text);
+    void writeBlankLine();
+    void writePoint(double time, double value);
+    void writePoints(const BreakpointList& points);
+
+    bool flush();
+
+private:
+    static constexpr size_t bufferSize = 1 << 16;
+    static constexpr size_t maxNumberLength = 60;
+    static constexpr size_t maxLineLength = maxNumberLength * 2 + 2;
+    static constexpr int decimalPlaces = 6;
+    static constexpr juce::int64 decimalScale = 1000000;
+
+    juce::OutputStream& stream;
+    juce::HeapBlock<char> buffer;
+    size_t used = 0;
+    bool ok = true;
+
+    void writeRaw(const char* data, size_t size);
+    char* writeNumber(char* dest, double number);
+
+    JUCE_DECLARE_NON_COPYABLE(BreakpointTextWriter)
+};
+
+// Streaming parser for breakpoint text files. The stream is consumed in
+// fixed-size chunks, so a file is never held in memory as a whole string.
+// Comment lines that aren't part of the file header start a new section,
+// which is how saveBreakpoints separates the outputs of a feature.
+class BreakpointTextParser {
+public:
+    struct Section {
+        juce::String name;
+        BreakpointList points;
+    };
+
+    struct Result {
+        juce::String featureName;
+        juce::String sourceName;
+        double sampleRate = 0.0;
+        std::vector<Section> sections;
+
+        const Section* findSection(const juce::String& name) const;
+    };
+
+    static Result parse(juce::InputStream& stream);
+
+private:
+    static constexpr size_t chunkSize = 1 << 16;
+
+    static void parseLine(const char* begin, const char* end, Result& result);
+    static void parseComment(const char* begin, const char* end, Result& result);
+    static bool parsePoint(const char* begin, const char* end, double& time, double& value);
+};
+
+class BreakpointFileFormat {
+public:
+    static bool write(juce::OutputStream& stream,
+        const juce::String& featureName,
+        const juce::String& sourceName,
+        double sampleRate,
+        const juce::StringArray& outputNames,
+        const std::vector<BreakpointList>& outputs);
+
+    static BreakpointTextParser::Result read(juce::InputStream& stream) {
+        return BreakpointTextParser::parse(stream);
+    }
+};
@@ -0,0 +1,212 @@
+// ControlRateExport.cpp
+#include "ControlRateExport.h"
+#include "BreakpointTextIO.h"
+
+using FVO = juce::FloatVectorOperations;
+
+double ControlRateExport::Grid::getInterval(double sampleRate) const {
+    if (blockSize > 0 && sampleRate > 0.0)
+        return blockSize / sampleRate;
+    return 1.0 / juce::jmax(rate, 1.0e-3);
+}
+
+BreakpointList ControlRateExport::Track::toPoints() const {
+    BreakpointList points(values.size());
+    for (size_t i = 0; i < values.size(); ++i)
+        points[i] = { startTime + interval * static_cast<double>(i), values[i] };
+    return points;
+}
+
+namespace {
+
+// First grid index at or after time, kept within [minIndex, numValues].
+int firstIndexAtOrAfter(double time, double interval, int minIndex, int numValues) {
+    double position = std::ceil(time / interval - 1.0e-9);
+    if (position <= minIndex) return minIndex;
+    if (position >= numValues) return numValues;
+    return static_cast<int>(position);
+}
+
+void fillRamp(float* dest, int count, double startValue, double step) {
+    for (int i = 0; i < count; ++i)
+        dest[i] = static_cast<float>(startValue + step * i);
+}
+
+// Cubic Hermite between a and b, with tangents from the neighbouring points
+// so the curve passes through every breakpoint (Catmull-Rom on uneven times).
+void fillCubic(float* dest, int count, double firstTime, double interval,
+    const BreakpointList& points, size_t segment) {
+
+    const auto& a = points[segment];
+    const auto& b = points[segment + 1];
+    double span = b.first - a.first;
+
+    auto tangent = [&points](size_t i) {
+        size_t before = i > 0 ? i - 1 : i;
+        size_t after = i + 1 < points.size() ? i + 1 : i;
+        double width = points[after].first - points[before].first;
+        return width > 0.0 ? (points[after].second - points[before].second) / width : 0.0;
+    };
+    double m0 = tangent(segment) * span;
+    double m1 = tangent(segment + 1) * span;
+
+    double inverse = 1.0 / span;
+    for (int i = 0; i < count; ++i) {
+        double s = (firstTime + interval * i - a.first) * inverse;
+        double s2 = s * s;
+        double s3 = s2 * s;
+        dest[i] = static_cast<float>((2.0 * s3 - 3.0 * s2 + 1.0) * a.second
+            + (s3 - 2.0 * s2 + s) * m0
+            + (-2.0 * s3 + 3.0 * s2) * b.second
+            + (s3 - s2) * m1);
+    }
+}
+
+} // namespace
+
+ControlRateExport::Track ControlRateExport::resample(const BreakpointList& points, double interval,
+    double endTime, Interpolation interpolation) {
+
+    Track track;
+    track.interval = interval;
+    if (interval <= 0.0) return track;
+
+    int numValues = static_cast<int>(std::floor(juce::jmax(0.0, endTime) / interval + 1.0e-9)) + 1;
+    track.values.resize(static_cast<size_t>(numValues));
+    auto* values = track.values.data();
+
+    if (points.empty()) {
+        FVO::clear(values, numValues);
+        return track;
+    }
+
+    if (interpolation == Interpolation::impulse) {
+        FVO::clear(values, numValues);
+        // Two events in one grid step keep the stronger.
+        for (const auto& [time, value] : points) {
+            int index = static_cast<int>(std::round(time / interval));
+            auto& slot = values[juce::jlimit(0, numValues - 1, index)];
+            if (std::abs(value) > std::abs(slot))
+                slot = static_cast<float>(value);
+        }
+        return track;
+    }
+
+    // Before the first point.
+    int i = firstIndexAtOrAfter(points.front().first, interval, 0, numValues);
+    FVO::fill(values, static_cast<float>(points.front().second), i);
+
+    // Each segment fills the grid values in [a.time, b.time).
+    for (size_t k = 0; k + 1 < points.size() && i < numValues; ++k) {
+        const auto& a = points[k];
+        const auto& b = points[k + 1];
+        int end = firstIndexAtOrAfter(b.first, interval, i, numValues);
+        int count = end - i;
+        if (count == 0) continue;
+
+        double span = b.first - a.first;
+        if (interpolation == Interpolation::hold || span <= 0.0) {
+            FVO::fill(values + i, static_cast<float>(a.second), count);
+        }
+        else if (interpolation == Interpolation::linear) {
+            double slope = (b.second - a.second) / span;
+            fillRamp(values + i, count, a.second + slope * (interval * i - a.first), slope * interval);
+        }
+        else {
+            fillCubic(values + i, count, interval * i, interval, points, k);
+        }
+        i = end;
+    }
+
+    // After the last point.
+    if (i < numValues)
+        FVO::fill(values + i, static_cast<float>(points.back().second), numValues - i);
+
+    return track;
+}
+
+bool ControlRateExport::writeDense(juce::OutputStream& stream, const File& file) {
+    Track defaultGrid;
+    const auto& grid = file.outputs.empty() ? defaultGrid : file.outputs.front();
+
+    stream.writeInt(denseMagic);
+    stream.writeByte(static_cast<char>(denseVersion));
+    stream.writeString(file.featureName);
+    stream.writeString(file.sourceName);
+    stream.writeDouble(file.sampleRate);
+    stream.writeDouble(grid.startTime);
+    stream.writeDouble(grid.interval);
+    stream.writeCompressedInt(static_cast<int>(file.outputs.size()));
+
+    for (size_t i = 0; i < file.outputs.size(); ++i) {
+        const auto& values = file.outputs[i].values;
+        stream.writeString(file.outputNames[static_cast<int>(i)]);
+        stream.writeCompressedInt(static_cast<int>(values.size()));
+
+       #if JUCE_LITTLE_ENDIAN
+        if (!stream.write(values.data(), values.size() * sizeof(float)))
+            return false;
+       #else
+        for (auto value : values)
+            stream.writeFloat(value);
+       #endif
+    }
+    stream.flush();
+    return true;
+}
+
+bool ControlRateExport::readDense(juce::InputStream& stream, File& file) {
+    if (stream.readInt() != denseMagic || stream.readByte() != denseVersion)
+        return false;
+
+    file = {};
+    file.featureName = stream.readString();
+    file.sourceName = stream.readString();
+    file.sampleRate = stream.readDouble();
+    double startTime = stream.readDouble();
+    double interval = stream.readDouble();
+
+    int numOutputs = stream.readCompressedInt();
+    if (numOutputs < 0 || interval <= 0.0) return false;
+
+    for (int i = 0; i < numOutputs; ++i) {
+        file.outputNames.add(stream.readString());
+        int count = stream.readCompressedInt();
+        auto remaining = stream.getNumBytesRemaining();
+        if (count < 0 || (remaining >= 0 && remaining < static_cast<juce::int64>(count) * 4))
+            return false;
+
+        Track track;
+        track.startTime = startTime;
+        track.interval = interval;
+        track.values.resize(static_cast<size_t>(count));
+
+       #if JUCE_LITTLE_ENDIAN
+        auto numBytes = static_cast<int>(count * sizeof(float));
+        if (stream.read(track.values.data(), numBytes) != numBytes)
+            return false;
+       #else
+        for (auto& value : track.values)
+            value = stream.readFloat();
+       #endif
+        file.outputs.push_back(std::move(track));
+    }
+    return true;
+}
+
+bool ControlRateExport::writeText(juce::OutputStream& stream, const File& file) {
+    std::vector<BreakpointList> outputs;
+    outputs.reserve(file.outputs.size());
+    for (const auto& track : file.outputs)
+        outputs.push_back(track.toPoints());
+
+    return BreakpointFileFormat::write(stream, file.featureName, file.sourceName, file.sampleRate,
+        file.outputNames, outputs);
+}
+
+ControlRateExport::Interpolation ControlRateExport::parseInterpolation(const juce::String& name) {
+    if (name.equalsIgnoreCase("hold") || name.equalsIgnoreCase("step")) return Interpolation::hold;
+    if (name.equalsIgnoreCase("cubic")) return Interpolation::cubic;
+    if (name.equalsIgnoreCase("impulse")) return Interpolation::impulse;
+    return Interpolation::linear;
+}
@@ -0,0 +1,67 @@
+// ControlRateExport.h
+#pragma once
+
+#include <JuceHeader.h>
+#include "FeatureExtractors.h"
+
+// Breakpoint tracks resampled onto a uniform grid, for hosts and effect
+// plugins that want automation at a fixed control rate or one value per
+// audio block instead of points at the extractor's hop times.
+//
+// Each segment of a track fills the run of grid values it covers in one
+// pass (a fill, a ramp or a cubic), so a track costs a walk over its points
+// plus one vectorizable loop per run.
+//
+// Dense files (.adcr) hold the grid once and then float32 values per output:
+//   int32 magic "ADCR", uint8 version, string feature, string source,
+//   double sampleRate, double startTime, double interval, compressed int
+//   numOutputs, then per output a string name, a compressed int count and
+//   count little-endian floats.
+class ControlRateExport {
+public:
+    // impulse is for event tracks: each point lands on its nearest grid
+    // value and everything else is 0.
+    enum class Interpolation { hold, linear, cubic, impulse };
+
+    struct Grid {
+        double rate = 100.0; // values per second, used when blockSize is 0
+        int blockSize = 0;   // otherwise one value per blockSize samples
+
+        static Grid perSecond(double rate) { return { rate, 0 }; }
+        static Grid perBlock(int blockSize) { return { 0.0, blockSize }; }
+
+        double getInterval(double sampleRate) const;
+    };
+
+    struct Track {
+        double startTime = 0.0;
+        double interval = 0.01;
+        std::vector<float> values; // values[i] is the track at startTime + i * interval
+
+        // The grid values as breakpoints, for the text format.
+        BreakpointList toPoints() const;
+    };
+
+    struct File {
+        juce::String featureName;
+        juce::String sourceName;
+        double sampleRate = 0.0;
+        juce::StringArray outputNames;
+        std::vector<Track> outputs; // all on the same grid
+    };
+
+    // Values from 0 to endTime inclusive; a track is held flat before its
+    // first point and after its last, except with impulse.
+    static Track resample(const BreakpointList& points, double interval, double endTime,
+        Interpolation interpolation);
+
+    static bool writeDense(juce::OutputStream& stream, const File& file);
+    static bool readDense(juce::InputStream& stream, File& file);
+    static bool writeText(juce::OutputStream& stream, const File& file);
+
+    static Interpolation parseInterpolation(const juce::String& name);
+
+private:
+    static constexpr int denseMagic = 0x52434441; // "ADCR"
+    static constexpr int denseVersion = 1;
+};
@@ -0,0 +1,122 @@
+// EnvelopeApplicator.cpp
+
+#include "EnvelopeApplicator.h"
+
+namespace {
+
+// Balance with a sine law: the centre leaves both channels untouched and
+// the far side fades out as the position moves towards the other.
+inline std::pair<float, float> balanceGains(float position) {
+    position = juce::jlimit(-1.0f, 1.0f, position);
+    float halfPi = juce::MathConstants<float>::halfPi;
+    float left = position > 0.0f ? std::cos(position * halfPi) : 1.0f;
+    float right = position < 0.0f ? std::cos(-position * halfPi) : 1.0f;
+    return { left, right };
+}
+
+} // namespace
+
+EnvelopeApplicator::EnvelopeApplicator() {
+    player.setControlInterval(controlInterval);
+}
+
+void EnvelopeApplicator::prepare(double newSampleRate, int maxBlockSize) {
+    sampleRate = newSampleRate;
+    player.prepare(sampleRate);
+    scratch.setSize(3, juce::jmax(controlInterval, maxBlockSize));
+    hasPreviousPan = false;
+    previousDepth = -1.0f;
+}
+
+void EnvelopeApplicator::process(juce::AudioBuffer<float>& buffer, int numChannels,
+    double startTime, const Parameters& parameters) {
+
+    if (parameters.mode == Mode::off) {
+        hasPreviousPan = false;
+        return;
+    }
+
+    // Hosts may exceed the block size they announced; work through the
+    // scratch space a piece at a time rather than allocate.
+    int numSamples = buffer.getNumSamples();
+    int chunkSize = scratch.getNumSamples();
+    for (int offset = 0; offset < numSamples; offset += chunkSize) {
+        int chunk = juce::jmin(chunkSize, numSamples - offset);
+        processChunk(buffer, numChannels, offset, chunk, startTime + offset / sampleRate, parameters);
+    }
+}
+
+void EnvelopeApplicator::processChunk(juce::AudioBuffer<float>& buffer, int numChannels,
+    int offset, int numSamples, double startTime, const Parameters& parameters) {
+
+    if (!player.render(scratch.getWritePointer(0), numSamples, startTime)) {
+        hasPreviousPan = false;
+        return;
+    }
+
+    if (parameters.mode == Mode::gain)
+        applyGain(buffer, numChannels, offset, numSamples, parameters.depth);
+    else if (parameters.mode == Mode::pan && numChannels >= 2)
+        applyPan(buffer, offset, numSamples, parameters.depth);
+}
+
+void EnvelopeApplicator::applyGain(juce::AudioBuffer<float>& buffer, int numChannels,
+    int offset, int numSamples, float depth) {
+
+    using FVO = juce::FloatVectorOperations;
+    float* gain = scratch.getWritePointer(0);
+
+    // gain = 1 + depth * (envelope - 1), with depth changes ramped across
+    // the block so moving the control doesn't click.
+    if (previousDepth < 0.0f || previousDepth == depth) {
+        FVO::multiply(gain, depth, numSamples);
+        FVO::add(gain, 1.0f - depth, numSamples);
+    }
+    else {
+        float* depthRamp = scratch.getWritePointer(1);
+        float step = (depth - previousDepth) / numSamples;
+        BreakpointPlayer::fillRamp(depthRamp, previousDepth + step, step, numSamples);
+
+        FVO::add(gain, -1.0f, numSamples);
+        FVO::multiply(gain, depthRamp, numSamples);
+        FVO::add(gain, 1.0f, numSamples);
+    }
+    previousDepth = depth;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        FVO::multiply(buffer.getWritePointer(ch, offset), gain, numSamples);
+}
+
+void EnvelopeApplicator::applyPan(juce::AudioBuffer<float>& buffer, int offset, int numSamples,
+    float depth) {
+
+    const float* position = scratch.getReadPointer(0);
+    float* leftGain = scratch.getWritePointer(1);
+    float* rightGain = scratch.getWritePointer(2);
+
+    // The pan law is evaluated once per control interval and each channel
+    // gain ramps to it, continuing from where the previous block ended.
+    for (int i = 0; i < numSamples; i += controlInterval) {
+        int run = juce::jmin(controlInterval, numSamples - i);
+        auto [left, right] = balanceGains(position[i + run - 1] * depth);
+
+        if (!hasPreviousPan) {
+            previousLeft = left;
+            previousRight = right;
+            hasPreviousPan = true;
+        }
+
+        float leftStep = (left - previousLeft) / run;
+        float rightStep = (right - previousRight) / run;
+        BreakpointPlayer::fillRamp(leftGain + i, previousLeft + leftStep, leftStep, run);
+        BreakpointPlayer::fillRamp(rightGain + i, previousRight + rightStep, rightStep, run);
+
+        previousLeft = left;
+        previousRight = right;
+    }
+
+    previousDepth = depth;
+
+    juce::FloatVectorOperations::multiply(buffer.getWritePointer(0, offset), leftGain, numSamples);
+    juce::FloatVectorOperations::multiply(buffer.getWritePointer(1, offset), rightGain, numSamples);
+}
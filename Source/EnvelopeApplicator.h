@@ -0,0 +1,59 @@
+// EnvelopeApplicator.h
+#pragma once
+
+#include <JuceHeader.h>
+#include "BreakpointPlayer.h"
+
+// "Mirror mode": imposes a breakpoint track on the audio passing through,
+// either as gain or as a stereo pan position. It works in place with no
+// lookahead, so it adds no latency.
+//
+// The track is evaluated at control rate and every gain is applied as a
+// linear ramp with FloatVectorOperations; the pan law's trig only runs once
+// per control interval.
+class EnvelopeApplicator {
+public:
+    enum class Mode { off, gain, pan };
+
+    // Read once per block from the parameter atomics.
+    struct Parameters {
+        Mode mode = Mode::off;
+        float depth = 1.0f;
+    };
+
+    EnvelopeApplicator();
+
+    // Not called concurrently with process().
+    void prepare(double sampleRate, int maxBlockSize);
+
+    // Message thread.
+    void setTrack(std::unique_ptr<EnvelopeTrack> track) { player.setTrack(std::move(track)); }
+    bool patchTrack(const BreakpointList& points, size_t first, size_t last) { return player.patchTrack(points, first, last); }
+    juce::int64 getTrackBytes() const { return player.getTrackBytes(); }
+
+    // Audio thread. Leaves the audio untouched when off or without a track.
+    void process(juce::AudioBuffer<float>& buffer, int numChannels, double startTime,
+        const Parameters& parameters);
+
+private:
+    BreakpointPlayer player;
+    double sampleRate = 44100.0;
+
+    // envelope, left gain, right gain
+    juce::AudioBuffer<float> scratch;
+
+    float previousDepth = -1.0f;
+    float previousLeft = 1.0f;
+    float previousRight = 1.0f;
+    bool hasPreviousPan = false;
+
+    static constexpr int controlInterval = 32;
+
+    void processChunk(juce::AudioBuffer<float>& buffer, int numChannels, int offset, int numSamples,
+        double startTime, const Parameters& parameters);
+    void applyGain(juce::AudioBuffer<float>& buffer, int numChannels, int offset, int numSamples,
+        float depth);
+    void applyPan(juce::AudioBuffer<float>& buffer, int offset, int numSamples, float depth);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EnvelopeApplicator)
+};
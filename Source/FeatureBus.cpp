@@ -0,0 +1,316 @@
+// FeatureBus.cpp
+#include "FeatureBus.h"
+
+namespace {
+
+void copyName(char* dest, size_t size, const juce::String& name) {
+    std::memset(dest, 0, size);
+    name.copyToUTF8(dest, size - 1);
+}
+
+juce::String readName(const char* source, size_t size) {
+    size_t length = 0;
+    while (length < size && source[length] != 0)
+        ++length;
+    return juce::String::fromUTF8(source, static_cast<int>(length));
+}
+
+} // namespace
+
+const FeatureBus::TrackView* FeatureBus::View::findTrack(const juce::String& featureName,
+    const juce::String& outputName) const {
+
+    for (const auto& track : tracks) {
+        if (track.featureName == featureName && (outputName.isEmpty() || track.outputName == outputName))
+            return &track;
+    }
+    return nullptr;
+}
+
+const FeatureBus::Track* FeatureBus::Snapshot::findTrack(const juce::String& featureName,
+    const juce::String& outputName) const {
+
+    for (const auto& track : tracks) {
+        if (track.featureName == featureName && (outputName.isEmpty() || track.outputName == outputName))
+            return &track;
+    }
+    return nullptr;
+}
+
+juce::File FeatureBus::getDirectory() {
+    return juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("AudioDeconstructorBus");
+}
+
+juce::File FeatureBus::getBusFile(const juce::String& name) {
+    return getDirectory().getChildFile(juce::File::createLegalFileName(name) + ".adbus");
+}
+
+juce::StringArray FeatureBus::findBuses() {
+    juce::StringArray names;
+    auto staleBefore = juce::Time::getCurrentTime() - juce::RelativeTime::milliseconds(deadAfterMs);
+
+    for (const auto& file : getDirectory().findChildFiles(juce::File::findFiles, false, "*.adbus")) {
+        auto name = file.getFileNameWithoutExtension();
+        if (Reader(name).isAlive()) {
+            names.add(name);
+        }
+        else if (file.getLastModificationTime() < staleBefore) {
+            // Left behind by a writer that crashed, or one that couldn't
+            // delete it while it was mapped. Newer files may be a writer
+            // still setting up.
+            file.deleteFile();
+        }
+    }
+    names.sort(true);
+    return names;
+}
+
+//==============================================================================
+FeatureBus::Writer::Writer(const juce::String& busName)
+    : name(busName), file(getBusFile(busName)) {
+
+    getDirectory().createDirectory();
+    if (!map(initialCapacity)) return;
+
+    auto* header = getHeader();
+    header->sequence.store(header->magic == magic ? header->sequence.load() | 1 : 1u);
+    header->magic = magic;
+    header->version = version;
+    header->numTracks = 0;
+    header->capacity = mapping->getSize();
+    header->heartbeat.store(juce::Time::currentTimeMillis());
+    header->sampleRate = 0.0;
+    std::memset(header->sourceName, 0, sizeof(header->sourceName));
+    header->sequence.fetch_add(1, std::memory_order_release);
+    startTimer(heartbeatIntervalMs);
+}
+
+FeatureBus::Writer::~Writer() {
+    stopTimer();
+    // Readers that still have it mapped see it closed even where the file
+    // can't be deleted yet.
+    if (auto* header = getHeader())
+        header->heartbeat.store(0, std::memory_order_release);
+    mapping.reset();
+    file.deleteFile();
+}
+
+void FeatureBus::Writer::timerCallback() {
+    if (auto* header = getHeader())
+        header->heartbeat.store(juce::Time::currentTimeMillis(), std::memory_order_release);
+}
+
+bool FeatureBus::Writer::map(juce::uint64 capacity) {
+    mapping.reset();
+
+    // Grown through the file itself, so readers' existing mappings stay valid.
+    if (static_cast<juce::uint64>(file.getSize()) < capacity) {
+        juce::FileOutputStream stream(file);
+        if (!stream.openedOk() || !stream.setPosition(static_cast<juce::int64>(capacity))
+            || stream.truncate().failed())
+            return false;
+    }
+
+    mapping = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readWrite);
+    if (mapping->getData() == nullptr || mapping->getSize() < capacity) {
+        mapping.reset();
+        return false;
+    }
+    return true;
+}
+
+FeatureBus::Header* FeatureBus::Writer::getHeader() const {
+    return mapping != nullptr ? static_cast<Header*>(mapping->getData()) : nullptr;
+}
+
+bool FeatureBus::Writer::publish(const juce::String& sourceName, double sampleRate,
+    const std::vector<Source>& tracks) {
+
+    if (!isOpen()) return false;
+
+    juce::uint64 required = headerSize + tracks.size() * sizeof(TrackEntry);
+    for (const auto& track : tracks)
+        required += track.points->size() * 2 * sizeof(double);
+
+    auto* header = getHeader();
+    auto sequence = header->sequence.load(std::memory_order_relaxed);
+    header->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if (required > header->capacity) {
+        auto previous = header->capacity;
+        auto capacity = previous;
+        while (capacity < required)
+            capacity *= 2;
+
+        if (!map(capacity)) {
+            // Windows won't resize a file another process has mapped; keep
+            // the last publication and try again next time.
+            if (map(previous))
+                getHeader()->sequence.store(sequence + 2, std::memory_order_release);
+            return false;
+        }
+        header = getHeader();
+        header->capacity = mapping->getSize();
+    }
+
+    header->numTracks = static_cast<juce::uint32>(tracks.size());
+    header->sampleRate = sampleRate;
+    copyName(header->sourceName, sizeof(header->sourceName), sourceName);
+
+    auto* base = static_cast<char*>(mapping->getData());
+    auto* entries = reinterpret_cast<TrackEntry*>(base + headerSize);
+    juce::uint64 offset = headerSize + tracks.size() * sizeof(TrackEntry);
+
+    // Written column by column straight into the shared pages.
+    for (size_t i = 0; i < tracks.size(); ++i) {
+        const auto& points = *tracks[i].points;
+        auto& entry = entries[i];
+        copyName(entry.featureName, sizeof(entry.featureName), tracks[i].featureName);
+        copyName(entry.outputName, sizeof(entry.outputName), tracks[i].outputName);
+        entry.offset = offset;
+        entry.numPoints = points.size();
+
+        auto* times = reinterpret_cast<double*>(base + offset);
+        auto* values = times + points.size();
+        for (size_t p = 0; p < points.size(); ++p) {
+            times[p] = points[p].first;
+            values[p] = points[p].second;
+        }
+        offset += points.size() * 2 * sizeof(double);
+    }
+
+    header->sequence.store(sequence + 2, std::memory_order_release);
+    return true;
+}
+
+//==============================================================================
+FeatureBus::Reader::Reader(const juce::String& name)
+    : file(getBusFile(name)) {
+    map();
+}
+
+bool FeatureBus::Reader::map() {
+    mapping.reset();
+    if (!file.existsAsFile()) return false;
+
+    mapping = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+    if (mapping->getData() == nullptr || mapping->getSize() < headerSize
+        || static_cast<const Header*>(mapping->getData())->magic != magic
+        || static_cast<const Header*>(mapping->getData())->version != version) {
+        mapping.reset();
+        return false;
+    }
+    return true;
+}
+
+const FeatureBus::Header* FeatureBus::Reader::getHeader() const {
+    return mapping != nullptr ? static_cast<const Header*>(mapping->getData()) : nullptr;
+}
+
+bool FeatureBus::Reader::isAlive() const {
+    // A mapping outlives the file, so a writer that has gone away is also
+    // noticed by looking for it.
+    auto* header = getHeader();
+    if (header == nullptr || !file.existsAsFile()) return false;
+
+    auto heartbeat = header->heartbeat.load(std::memory_order_acquire);
+    return heartbeat != 0 && juce::Time::currentTimeMillis() - heartbeat < deadAfterMs;
+}
+
+juce::uint32 FeatureBus::Reader::getSequence() const {
+    auto* header = getHeader();
+    return header != nullptr ? header->sequence.load(std::memory_order_acquire) : 0;
+}
+
+bool FeatureBus::Reader::view(View& view, int maxAttempts) {
+    if (!file.existsAsFile()) {
+        mapping.reset();
+        return false;
+    }
+
+    for (int attempt = 0; attempt < maxAttempts; ++attempt) {
+        if (getHeader() == nullptr && !map())
+            return false;
+
+        const auto& header = *getHeader();
+        auto sequence = header.sequence.load(std::memory_order_acquire);
+        if ((sequence & 1) != 0) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        if (header.capacity > mapping->getSize()) {
+            if (!map()) return false;
+            continue;
+        }
+
+        view.sequence = sequence;
+        if (locate(header, view) && isUnchanged(view))
+            return true;
+    }
+    return false;
+}
+
+bool FeatureBus::Reader::isUnchanged(const View& view) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    auto* header = getHeader();
+    return header != nullptr && header->sequence.load(std::memory_order_relaxed) == view.sequence;
+}
+
+bool FeatureBus::Reader::read(Snapshot& snapshot, int maxAttempts) {
+    View current;
+    for (int attempt = 0; attempt < maxAttempts; ++attempt) {
+        if (!view(current, maxAttempts - attempt))
+            return false;
+
+        snapshot.sourceName = current.sourceName;
+        snapshot.sampleRate = current.sampleRate;
+        snapshot.tracks.resize(current.tracks.size());
+        for (size_t i = 0; i < current.tracks.size(); ++i) {
+            const auto& source = current.tracks[i];
+            auto& track = snapshot.tracks[i];
+            track.featureName = source.featureName;
+            track.outputName = source.outputName;
+            track.times.assign(source.times, source.times + source.numPoints);
+            track.values.assign(source.values, source.values + source.numPoints);
+        }
+
+        if (isUnchanged(current)) {
+            snapshot.sequence = current.sequence;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FeatureBus::Reader::locate(const Header& header, View& view) const {
+    // Everything read here may be torn, so sizes are checked against the
+    // mapping before they're used and a bad view just retries.
+    auto size = static_cast<juce::uint64>(mapping->getSize());
+    auto numTracks = static_cast<juce::uint64>(header.numTracks);
+    if (headerSize + numTracks * sizeof(TrackEntry) > size)
+        return false;
+
+    const auto* base = static_cast<const char*>(mapping->getData());
+    const auto* entries = reinterpret_cast<const TrackEntry*>(base + headerSize);
+
+    view.sourceName = readName(header.sourceName, sizeof(header.sourceName));
+    view.sampleRate = header.sampleRate;
+    view.tracks.resize(static_cast<size_t>(numTracks));
+
+    for (size_t i = 0; i < view.tracks.size(); ++i) {
+        const auto& entry = entries[i];
+        auto numPoints = entry.numPoints;
+        if (entry.offset > size || numPoints > (size - entry.offset) / (2 * sizeof(double)))
+            return false;
+
+        auto& track = view.tracks[i];
+        track.featureName = readName(entry.featureName, sizeof(entry.featureName));
+        track.outputName = readName(entry.outputName, sizeof(entry.outputName));
+        track.times = reinterpret_cast<const double*>(base + entry.offset);
+        track.values = track.times + numPoints;
+        track.numPoints = static_cast<size_t>(numPoints);
+    }
+    return true;
+}
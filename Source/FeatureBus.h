@@ -0,0 +1,167 @@
+// FeatureBus.h
+#pragma once
+
+#include <JuceHeader.h>
+#include "FeatureExtractors.h"
+
+// Publishes the stored tracks of one plugin instance to other processes and
+// plugin instances on the same machine. Each bus is a file in the temp
+// directory that the writer maps read-write and readers map read-only, so
+// the operating system shares the pages and nothing is parsed or sent.
+//
+// Layout, native byte order:
+//   Header, numTracks TrackEntry records, then per track numPoints times
+//   followed by numPoints values, all doubles.
+//
+// The header's sequence is a seqlock: the writer makes it odd before it
+// touches anything and even again when done, and whatever a reader took
+// from the bus is only good if the sequence was the same even number before
+// and after. The file only grows; a reader that sees a capacity beyond its
+// mapping maps again.
+//
+// The writer stamps a heartbeat into the header every second and zeroes it
+// when it closes. A bus whose heartbeat has stopped belongs to a writer that
+// is gone, crashed ones included; findBuses skips such buses and removes
+// their files.
+class FeatureBus {
+public:
+    static constexpr juce::uint32 magic = 0x53554244; // "DBUS"
+    static constexpr juce::uint32 version = 2;
+    static constexpr int maxNameLength = 64;
+    static constexpr int heartbeatIntervalMs = 1000;
+    static constexpr int deadAfterMs = 5000;
+
+    struct Header {
+        juce::uint32 magic;
+        juce::uint32 version;
+        std::atomic<juce::uint32> sequence;
+        juce::uint32 numTracks;
+        juce::uint64 capacity;
+        std::atomic<juce::int64> heartbeat; // writer's Time::currentTimeMillis, 0 once closed
+        double sampleRate;
+        char sourceName[128];
+    };
+
+    struct TrackEntry {
+        char featureName[maxNameLength];
+        char outputName[maxNameLength];
+        juce::uint64 offset; // from the start of the file
+        juce::uint64 numPoints;
+    };
+
+    // One track to publish; the points are read in place.
+    struct Source {
+        juce::String featureName;
+        juce::String outputName;
+        const BreakpointList* points = nullptr;
+    };
+
+    struct Track {
+        juce::String featureName;
+        juce::String outputName;
+        std::vector<double> times;
+        std::vector<double> values;
+    };
+
+    // A track read in place from the shared pages.
+    struct TrackView {
+        juce::String featureName;
+        juce::String outputName;
+        const double* times = nullptr;
+        const double* values = nullptr;
+        size_t numPoints = 0;
+    };
+
+    // The bus as of one publication, without copying the points. They may
+    // be overwritten at any time, so whatever is computed from them only
+    // counts once Reader::isUnchanged(view) says so afterwards.
+    struct View {
+        juce::uint32 sequence = 0;
+        juce::String sourceName;
+        double sampleRate = 0.0;
+        std::vector<TrackView> tracks;
+
+        const TrackView* findTrack(const juce::String& featureName, const juce::String& outputName) const;
+    };
+
+    struct Snapshot {
+        juce::uint32 sequence = 0;
+        juce::String sourceName;
+        double sampleRate = 0.0;
+        std::vector<Track> tracks;
+
+        const Track* findTrack(const juce::String& featureName, const juce::String& outputName) const;
+    };
+
+    static juce::File getDirectory();
+    static juce::File getBusFile(const juce::String& name);
+    // Names of the buses currently published on this machine.
+    static juce::StringArray findBuses();
+
+    class Writer : private juce::Timer {
+    public:
+        // Creates or takes over the named bus; the bus is marked closed and
+        // the file removed again when the writer goes away. Message thread,
+        // which keeps the heartbeat.
+        explicit Writer(const juce::String& name);
+        ~Writer() override;
+
+        bool isOpen() const { return mapping != nullptr; }
+        const juce::String& getName() const { return name; }
+
+        bool publish(const juce::String& sourceName, double sampleRate, const std::vector<Source>& tracks);
+
+    private:
+        static constexpr juce::uint64 initialCapacity = 1 << 16;
+
+        juce::String name;
+        juce::File file;
+        std::unique_ptr<juce::MemoryMappedFile> mapping;
+
+        bool map(juce::uint64 capacity);
+        Header* getHeader() const;
+        void timerCallback() override;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Writer)
+    };
+
+    class Reader {
+    public:
+        explicit Reader(const juce::String& name);
+
+        bool isOpen() const { return getHeader() != nullptr; }
+        // False once the writer has closed the bus or stopped beating.
+        bool isAlive() const;
+        // Changes with every publication; 0 if the bus isn't there.
+        juce::uint32 getSequence() const;
+
+        // Points a view at the tracks of the current publication, waiting
+        // while the writer is busy. The view stays usable until the next
+        // view or read on this reader, which may map the bus again. Fails if
+        // the bus is gone or never settles.
+        bool view(View& view, int maxAttempts = 1000);
+        // True if nothing has been published since the view was taken, so
+        // what was read from it is consistent.
+        bool isUnchanged(const View& view) const;
+
+        // Copies a consistent state of the bus, retrying while the writer is
+        // busy. Fails if the bus is gone or never settles.
+        bool read(Snapshot& snapshot, int maxAttempts = 1000);
+
+    private:
+        juce::File file;
+        std::unique_ptr<juce::MemoryMappedFile> mapping;
+
+        bool map();
+        const Header* getHeader() const;
+        bool locate(const Header& header, View& view) const;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Reader)
+    };
+
+private:
+    static_assert(std::atomic<juce::uint32>::is_always_lock_free, "the sequence is shared between processes");
+    static_assert(std::atomic<juce::int64>::is_always_lock_free, "the heartbeat is shared between processes");
+
+    static constexpr size_t headerSize = (sizeof(Header) + 7) & ~static_cast<size_t>(7);
+};
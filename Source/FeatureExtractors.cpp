@@ -2,117 +2,325 @@
 
 #include "FeatureExtractors.h"
 
-std::vector<std::vector<std::pair<double, double>>> AmplitudeExtractor::extract(const juce::AudioBuffer<float>& buffer,
+FrameStatistics FrameStatistics::compute(const juce::AudioBuffer<float>& buffer,
     double sampleRate,
-    int channel) {
+    float windowSizeMs,
+    float hopSizePct) {
 
-    std::vector<std::vector<std::pair<double, double>>> results(2);
+    FrameStatistics stats;
+    stats.sampleRate = sampleRate;
 
-    int windowSamples = static_cast<int>(settings.windowSizeMs * sampleRate / 1000.0f);
-    int hopSamples = std::max(1, static_cast<int>(windowSamples * settings.hopSizePct / 100.0f));
+    int windowSamples = static_cast<int>(windowSizeMs * sampleRate / 1000.0f);
+    int hopSamples = std::max(1, static_cast<int>(windowSamples * hopSizePct / 100.0f));
 
     if (windowSamples == 0) windowSamples = 1;
 
-    const float* data = buffer.getReadPointer(channel);
-    int numSamples = buffer.getNumSamples();
+    stats.windowSamples = windowSamples;
+    stats.hopSamples = hopSamples;
 
-    std::vector<float> rmsValues;
-    std::vector<float> peakValues;
-    std::vector<double> times;
+    int numSamples = buffer.getNumSamples();
+    int numChannels = buffer.getNumChannels();
+    size_t numFrames = static_cast<size_t>((numSamples + hopSamples - 1) / hopSamples);
+
+    stats.starts.reserve(numFrames);
+    stats.lengths.reserve(numFrames);
+    stats.channels.resize(static_cast<size_t>(numChannels));
+    for (auto& channel : stats.channels) {
+        channel.sumSquares.reserve(numFrames);
+        channel.sumAbs.reserve(numFrames);
+        channel.peak.reserve(numFrames);
+    }
 
     for (int start = 0; start < numSamples; start += hopSamples) {
         int end = std::min(start + windowSamples, numSamples);
-        int length = end - start;
 
-        if (length == 0) continue;
+        stats.starts.push_back(start);
+        stats.lengths.push_back(end - start);
 
-        float sumSquares = 0.0f;
-        float peak = 0.0f;
+        for (int ch = 0; ch < numChannels; ++ch) {
+            const float* data = buffer.getReadPointer(ch);
 
-        for (int i = start; i < end; ++i) {
-            float sample = data[i];
-            sumSquares += sample * sample;
-            float absSample = std::abs(sample);
-            if (absSample > peak) peak = absSample;
+            float sumSquares = 0.0f;
+            float sumAbs = 0.0f;
+            float peak = 0.0f;
+
+            for (int i = start; i < end; ++i) {
+                float sample = data[i];
+                sumSquares += sample * sample;
+                float absSample = std::abs(sample);
+                sumAbs += absSample;
+                if (absSample > peak) peak = absSample;
+            }
+
+            auto& channel = stats.channels[static_cast<size_t>(ch)];
+            channel.sumSquares.push_back(sumSquares);
+            channel.sumAbs.push_back(sumAbs);
+            channel.peak.push_back(peak);
         }
 
-        float rms = std::sqrt(sumSquares / length);
+        if (numChannels >= 2) {
+            const float* left = buffer.getReadPointer(0);
+            const float* right = buffer.getReadPointer(1);
 
-        times.push_back(start / sampleRate);
-        rmsValues.push_back(rms);
-        peakValues.push_back(peak);
+            float correlation = 0.0f;
+            for (int i = start; i < end; ++i)
+                correlation += left[i] * right[i];
+
+            stats.crossProduct.push_back(correlation);
+        }
     }
 
-    if (settings.normalizeOutput) {
-        float maxRms = *std::max_element(rmsValues.begin(), rmsValues.end());
-        float maxPeak = *std::max_element(peakValues.begin(), peakValues.end());
+    return stats;
+}
+
+namespace {
+
+// Half-band low-pass: a Blackman-windowed sinc cut off at a quarter of the
+// input rate, flat within 0.02 dB to 0.2 and at least 75 dB down (-75.2 dB
+// at worst) from 0.31 of it. Every other tap is zero, so each output needs
+// the centre tap plus one multiply per symmetric pair of odd taps.
+constexpr int halfBandPairs = 12;
+
+const std::array<float, halfBandPairs>& getHalfBandTaps() {
+    static const auto taps = [] {
+        std::array<float, halfBandPairs> result{};
+        constexpr int windowHalfWidth = 2 * halfBandPairs;
+        for (int i = 0; i < halfBandPairs; ++i) {
+            int offset = 2 * i + 1;
+            double x = juce::MathConstants<double>::pi * offset / 2.0;
+            double sinc = std::sin(x) / x;
+            double phase = juce::MathConstants<double>::pi * (offset + windowHalfWidth) / windowHalfWidth;
+            double window = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+            result[static_cast<size_t>(i)] = static_cast<float>(0.5 * sinc * window);
+        }
+        return result;
+    }();
+    return taps;
+}
+
+// Filters and keeps every other sample, computing only the kept outputs.
+juce::AudioBuffer<float> decimateByTwo(const juce::AudioBuffer<float>& input) {
+    const auto& taps = getHalfBandTaps();
+    int numInput = input.getNumSamples();
+    int numOutput = (numInput + 1) / 2;
+
+    juce::AudioBuffer<float> output(input.getNumChannels(), numOutput);
+
+    for (int ch = 0; ch < input.getNumChannels(); ++ch) {
+        const float* x = input.getReadPointer(ch);
+        float* y = output.getWritePointer(ch);
+
+        for (int n = 0; n < numOutput; ++n) {
+            int centre = 2 * n;
+            float sum = 0.5f * x[centre];
+
+            // Outside the buffer counts as silence.
+            if (centre >= 2 * halfBandPairs - 1 && centre + 2 * halfBandPairs - 1 < numInput) {
+                for (int i = 0; i < halfBandPairs; ++i) {
+                    int offset = 2 * i + 1;
+                    sum += taps[static_cast<size_t>(i)] * (x[centre - offset] + x[centre + offset]);
+                }
+            }
+            else {
+                for (int i = 0; i < halfBandPairs; ++i) {
+                    int offset = 2 * i + 1;
+                    float before = centre - offset >= 0 ? x[centre - offset] : 0.0f;
+                    float after = centre + offset < numInput ? x[centre + offset] : 0.0f;
+                    sum += taps[static_cast<size_t>(i)] * (before + after);
+                }
+            }
+            y[n] = sum;
+        }
+    }
+
+    return output;
+}
+
+} // namespace
+
+AnalysisPyramid AnalysisPyramid::compute(const juce::AudioBuffer<float>& buffer, double sampleRate) {
+    AnalysisPyramid pyramid;
+    pyramid.source = &buffer;
+    pyramid.sampleRate = sampleRate;
+
+    const juce::AudioBuffer<float>* previous = &buffer;
+    for (int factor = 2; factor <= maxFactor; factor *= 2) {
+        pyramid.decimated.push_back(decimateByTwo(*previous));
+        previous = &pyramid.decimated.back();
+    }
+    return pyramid;
+}
+
+AnalysisPyramid::Level AnalysisPyramid::getLevel(int factor) const {
+    Level level;
+    level.factor = 1;
+    level.sampleRate = sampleRate;
+    level.audio = source;
+
+    for (size_t i = 0; i < decimated.size() && level.factor < factor; ++i) {
+        level.factor *= 2;
+        level.sampleRate = sampleRate / level.factor;
+        level.audio = &decimated[i];
+    }
+    return level;
+}
+
+AnalysisPyramid::Level AnalysisPyramid::getLevelFor(double bandwidthHz) const {
+    auto best = getLevel(1);
+    for (int factor = 2; factor <= maxFactor; factor *= 2) {
+        auto level = getLevel(factor);
+        if (level.factor != factor || level.getBandwidth() < bandwidthHz) break;
+        best = level;
+    }
+    return best;
+}
+
+FeatureExtractor::Settings FeatureExtractor::getSettingsFor(int dependencies) const {
+    Settings result;
+
+    if (dependencies & windowSizeSetting) result.windowSizeMs = settings.windowSizeMs;
+    if (dependencies & hopSizeSetting) result.hopSizePct = settings.hopSizePct;
+
+    if (dependencies & normalizeSetting) {
+        result.normalizeOutput = settings.normalizeOutput;
+        result.minValue = settings.minValue;
+        result.maxValue = settings.maxValue;
+    }
+
+    if (dependencies & smoothingSetting) {
+        result.smoothOutput = settings.smoothOutput;
+        result.smoothTimeMs = settings.smoothTimeMs;
+    }
+
+    if (dependencies & decimationSetting) result.decimatedAnalysis = settings.decimatedAnalysis;
+
+    return result;
+}
+
+FeatureExtractor::FrameLayout FeatureExtractor::getFrameLayout(double sampleRate) const {
+    // Same arithmetic as FrameStatistics::compute.
+    int windowSamples = static_cast<int>(settings.windowSizeMs * sampleRate / 1000.0f);
+    int hopSamples = std::max(1, static_cast<int>(windowSamples * settings.hopSizePct / 100.0f));
+    return { std::max(1, windowSamples), hopSamples };
+}
+
+std::vector<std::vector<std::pair<double, double>>> FeatureExtractor::extract(const juce::AudioBuffer<float>& buffer,
+    double sampleRate,
+    int channel) {
+
+    auto results = extractRaw(buffer, sampleRate, channel);
+    postProcess(results);
+    return results;
+}
+
+void FeatureExtractor::postProcess(std::vector<std::vector<std::pair<double, double>>>& outputs) const {
+    if (!settings.smoothOutput || settings.smoothTimeMs <= 0.0f) return;
 
-        if (maxRms > 0.0f)
-            for (auto& v : rmsValues)
-                v /= maxRms;
+    // One-pole smoothing over the breakpoint sequence, using the actual
+    // spacing between points so irregular tracks smooth consistently.
+    double timeConstant = settings.smoothTimeMs / 1000.0;
 
-        if (maxPeak > 0.0f)
-            for (auto& v : peakValues)
-                v /= maxPeak;
+    for (size_t output = 0; output < outputs.size(); ++output) {
+        if (!smoothsOutput(static_cast<int>(output))) continue;
+
+        auto& points = outputs[output];
+        for (size_t i = 1; i < points.size(); ++i) {
+            double dt = points[i].first - points[i - 1].first;
+            double coeff = 1.0 - std::exp(-std::max(0.0, dt) / timeConstant);
+            points[i].second = points[i - 1].second + coeff * (points[i].second - points[i - 1].second);
+        }
     }
+}
+
+std::vector<std::vector<std::pair<double, double>>> AmplitudeExtractor::extractRaw(const juce::AudioBuffer<float>& buffer,
+    double sampleRate,
+    int channel) {
+
+    return extractFromFrames(FrameStatistics::compute(buffer, sampleRate,
+        settings.windowSizeMs, settings.hopSizePct), channel);
+}
+
+std::vector<std::vector<std::pair<double, double>>> AmplitudeExtractor::extractFromFrames(const FrameStatistics& frames,
+    int channel) {
 
-    for (size_t i = 0; i < times.size(); ++i) {
-        results[0].push_back({ times[i], rmsValues[i] });
-        results[1].push_back({ times[i], peakValues[i] });
+    std::vector<std::vector<std::pair<double, double>>> results(2);
+
+    if (channel < 0 || static_cast<size_t>(channel) >= frames.channels.size())
+        return results;
+
+    const auto& stats = frames.channels[static_cast<size_t>(channel)];
+    size_t numFrames = frames.getNumFrames();
+
+    results[0].reserve(numFrames);
+    results[1].reserve(numFrames);
+
+    for (size_t i = 0; i < numFrames; ++i) {
+        double time = frames.starts[i] / frames.sampleRate;
+        float rms = std::sqrt(stats.sumSquares[i] / frames.lengths[i]);
+
+        results[0].push_back({ time, rms });
+        results[1].push_back({ time, stats.peak[i] });
     }
 
     return results;
 }
 
-std::vector<std::vector<std::pair<double, double>>> PanningExtractor::extract(const juce::AudioBuffer<float>& buffer,
+void AmplitudeExtractor::postProcess(std::vector<std::vector<std::pair<double, double>>>& outputs) const {
+    if (settings.normalizeOutput) {
+        for (auto& points : outputs) {
+            double maxValue = 0.0;
+            for (const auto& p : points)
+                maxValue = std::max(maxValue, p.second);
+
+            if (maxValue > 0.0)
+                for (auto& p : points)
+                    p.second /= maxValue;
+        }
+    }
+
+    FeatureExtractor::postProcess(outputs);
+}
+
+std::vector<std::vector<std::pair<double, double>>> PanningExtractor::extractRaw(const juce::AudioBuffer<float>& buffer,
     double sampleRate,
     int channel) {
 
+    return extractFromFrames(FrameStatistics::compute(buffer, sampleRate,
+        settings.windowSizeMs, settings.hopSizePct), channel);
+}
+
+std::vector<std::vector<std::pair<double, double>>> PanningExtractor::extractFromFrames(const FrameStatistics& frames,
+    int channel) {
+
     std::vector<std::vector<std::pair<double, double>>> results(3);
 
-    if (buffer.getNumChannels() < 2) {
+    if (frames.channels.size() < 2) {
         results[0].push_back({ 0.0, 0.0 });
         results[1].push_back({ 0.0, 0.0 });
         results[2].push_back({ 0.0, 0.0 });
         return results;
     }
 
-    const float* left = buffer.getReadPointer(0);
-    const float* right = buffer.getReadPointer(1);
-    int numSamples = buffer.getNumSamples();
-
-    int windowSamples = static_cast<int>(settings.windowSizeMs * sampleRate / 1000.0f);
-    int hopSamples = std::max(1, static_cast<int>(windowSamples * settings.hopSizePct / 100.0f));
-
-    for (int start = 0; start < numSamples; start += hopSamples) {
-        int end = std::min(start + windowSamples, numSamples);
-        int length = end - start;
-
-        if (length == 0) continue;
+    const auto& left = frames.channels[0];
+    const auto& right = frames.channels[1];
+    size_t numFrames = frames.getNumFrames();
 
-        double time = start / sampleRate;
+    for (auto& output : results)
+        output.reserve(numFrames);
 
-        float leftSum = 0.0f, rightSum = 0.0f;
-        float leftSq = 0.0f, rightSq = 0.0f;
-        float correlation = 0.0f;
-
-        for (int i = start; i < end; ++i) {
-            float l = left[i];
-            float r = right[i];
-            leftSum += std::abs(l);
-            rightSum += std::abs(r);
-            leftSq += l * l;
-            rightSq += r * r;
-            correlation += l * r;
-        }
+    for (size_t i = 0; i < numFrames; ++i) {
+        int length = frames.lengths[i];
+        double time = frames.starts[i] / frames.sampleRate;
 
+        float leftSum = left.sumAbs[i];
+        float rightSum = right.sumAbs[i];
         float totalSum = leftSum + rightSum;
         float pan = totalSum > 0.0f ? (rightSum - leftSum) / totalSum : 0.0f;
 
-        float leftRMS = std::sqrt(leftSq / length);
-        float rightRMS = std::sqrt(rightSq / length);
+        float leftRMS = std::sqrt(left.sumSquares[i] / length);
+        float rightRMS = std::sqrt(right.sumSquares[i] / length);
         float denom = leftRMS * rightRMS;
-        float corr = denom > 0.0f ? correlation / (length * denom) : 0.0f;
+        float corr = denom > 0.0f ? frames.crossProduct[i] / (length * denom) : 0.0f;
         float width = 1.0f - (corr * 0.5f + 0.5f);
 
         float totalRMS = leftRMS + rightRMS;
@@ -132,7 +340,7 @@ SpectralExtractor::SpectralExtractor() {
     fftData.resize(fftSize * 2, 0.0f);
 }
 
-std::vector<std::vector<std::pair<double, double>>> SpectralExtractor::extract(const juce::AudioBuffer<float>& buffer,
+std::vector<std::vector<std::pair<double, double>>> SpectralExtractor::extractRaw(const juce::AudioBuffer<float>& buffer,
     double sampleRate,
     int channel) {
 
@@ -144,16 +352,23 @@ std::vector<std::vector<std::pair<double, double>>> SpectralExtractor::extract(c
     int hopSamples = fftSize / 2;
     std::vector<float> previousMagnitudes;
 
+    AnalysisProfiler::Accumulator transformTime(profiler, "FFT", getName());
+    AnalysisProfiler::Accumulator descriptorTime(profiler, "descriptors", getName());
+
     for (int start = 0; start <= numSamples - fftSize; start += hopSamples) {
         double time = start / sampleRate;
 
+        transformTime.start();
         for (int i = 0; i < fftSize; ++i) {
             float window = 0.5f * (1.0f - std::cos(2.0f * juce::MathConstants<float>::pi * i / fftSize));
             fftData[i] = data[start + i] * window;
         }
 
         fft->performFrequencyOnlyForwardTransform(fftData.data());
+        transformTime.stop();
+        transformTime.addFrames(1);
 
+        descriptorTime.start();
         std::vector<float> magnitudes(fftSize / 2);
         for (int i = 0; i < fftSize / 2; ++i) {
             float real = fftData[i * 2];
@@ -172,6 +387,8 @@ std::vector<std::vector<std::pair<double, double>>> SpectralExtractor::extract(c
         results[3].push_back({ time, rolloff });
 
         previousMagnitudes = magnitudes;
+        descriptorTime.stop();
+        descriptorTime.addFrames(1);
     }
 
     return results;
@@ -237,14 +454,27 @@ float SpectralExtractor::calculateRolloff(const std::vector<float>& magnitudes,
     return sampleRate / 2.0f;
 }
 
-std::vector<std::vector<std::pair<double, double>>> PitchExtractor::extract(const juce::AudioBuffer<float>& buffer,
+std::vector<std::vector<std::pair<double, double>>> PitchExtractor::extractRaw(const juce::AudioBuffer<float>& buffer,
     double sampleRate,
     int channel) {
 
-    std::vector<std::vector<std::pair<double, double>>> results(2);
+    return analyse(buffer.getReadPointer(channel), buffer.getNumSamples(), sampleRate, false);
+}
 
-    const float* data = buffer.getReadPointer(channel);
-    int numSamples = buffer.getNumSamples();
+std::vector<std::vector<std::pair<double, double>>> PitchExtractor::extractFromPyramid(const AnalysisPyramid& pyramid,
+    int channel) {
+
+    auto level = pyramid.getLevelFor(requiredBandwidth);
+
+    // Lags are coarser after decimation, so the peak is interpolated.
+    return analyse(level.audio->getReadPointer(channel), level.audio->getNumSamples(),
+        level.sampleRate, level.factor > 1);
+}
+
+std::vector<std::vector<std::pair<double, double>>> PitchExtractor::analyse(const float* data, int numSamples,
+    double sampleRate, bool interpolate) {
+
+    std::vector<std::vector<std::pair<double, double>>> results(2);
 
     int windowSamples = static_cast<int>(0.05 * sampleRate);
     int hopSamples = windowSamples / 2;
@@ -252,7 +482,7 @@ std::vector<std::vector<std::pair<double, double>>> PitchExtractor::extract(cons
     for (int start = 0; start < numSamples - windowSamples; start += hopSamples) {
         double time = start / sampleRate;
 
-        auto [freq, confidence] = detectPitch(data + start, windowSamples, sampleRate);
+        auto [freq, confidence] = detectPitch(data + start, windowSamples, sampleRate, interpolate);
 
         results[0].push_back({ time, freq });
         results[1].push_back({ time, confidence });
@@ -261,7 +491,13 @@ std::vector<std::vector<std::pair<double, double>>> PitchExtractor::extract(cons
     return results;
 }
 
-std::pair<float, float> PitchExtractor::detectPitch(const float* data, int numSamples, double sampleRate) {
+FeatureExtractor::FrameLayout PitchExtractor::getFrameLayout(double sampleRate) const {
+    int windowSamples = static_cast<int>(0.05 * sampleRate);
+    return { windowSamples, windowSamples / 2 };
+}
+
+std::pair<float, float> PitchExtractor::detectPitch(const float* data, int numSamples, double sampleRate,
+    bool interpolate) {
     int minLag = static_cast<int>(sampleRate / 1000.0);
     int maxLag = static_cast<int>(sampleRate / 50.0);
 
@@ -275,7 +511,16 @@ std::pair<float, float> PitchExtractor::detectPitch(const float* data, int numSa
     }
 
     auto maxIt = std::max_element(correlation.begin(), correlation.end());
-    int peakLag = static_cast<int>(std::distance(correlation.begin(), maxIt)) + minLag;
+    int peakIndex = static_cast<int>(std::distance(correlation.begin(), maxIt));
+    double peakLag = peakIndex + minLag;
+
+    if (interpolate && peakIndex > 0 && peakIndex + 1 < static_cast<int>(correlation.size())) {
+        float before = correlation[static_cast<size_t>(peakIndex - 1)];
+        float after = correlation[static_cast<size_t>(peakIndex + 1)];
+        float curvature = before - 2.0f * *maxIt + after;
+        if (curvature < 0.0f)
+            peakLag += 0.5 * (before - after) / curvature;
+    }
 
     float freq = static_cast<float>(sampleRate / peakLag);
     float confidence = *maxIt / correlation[0];
@@ -283,35 +528,134 @@ std::pair<float, float> PitchExtractor::detectPitch(const float* data, int numSa
     return { freq, std::max(0.0f, std::min(1.0f, confidence)) };
 }
 
-std::vector<std::vector<std::pair<double, double>>> TransientExtractor::extract(const juce::AudioBuffer<float>& buffer,
-    double sampleRate,
-    int channel) {
+int TransientExtractor::getFftOrder(double sampleRate) {
+    return juce::jlimit(8, 13, juce::roundToInt(std::log2(sampleRate * 0.023)));
+}
 
-    std::vector<std::vector<std::pair<double, double>>> results(1);
+FeatureExtractor::FrameLayout TransientExtractor::getFrameLayout(double sampleRate) const {
+    int size = 1 << getFftOrder(sampleRate);
+    int hop = size / 4;
 
-    const float* data = buffer.getReadPointer(channel);
-    int numSamples = buffer.getNumSamples();
+    // A frame needs its right half plus the frames its threshold and peak
+    // test look ahead to. Looking back, the flux of the earliest frame
+    // those tests read must come from frames clear of the chunk start.
+    int after = std::max(medianAfter, peakAfter);
+    int before = std::max(medianBefore, peakBefore);
+    return { size / 2 + after * hop, hop, before + fluxLag + size / (2 * hop) };
+}
 
-    int windowSamples = 1024;
-    int hopSamples = 512;
+std::vector<float> TransientExtractor::computeFlux(const float* data, int numSamples, int order, int hop) {
+    int size = 1 << order;
+    if (fft == nullptr || fft->getSize() != size) {
+        fft = std::make_unique<juce::dsp::FFT>(order);
+        fftData.assign(static_cast<size_t>(size) * 2, 0.0f);
+    }
 
-    float previousEnergy = 0.0f;
+    int numBins = size / 2;
+    int numFrames = (numSamples + hop - 1) / hop;
+
+    // Octave bands down from Nyquist; the lowest takes everything below.
+    std::array<int, numBands + 1> bandEdges{};
+    for (int b = 0; b < numBands; ++b)
+        bandEdges[static_cast<size_t>(b)] = b == 0 ? 0 : numBins >> (numBands - b);
+    bandEdges[numBands] = numBins;
+
+    // Magnitudes scaled so a full-scale sinusoid peaks near 1.
+    float magnitudeScale = 4.0f / size;
+    // Each frame is compared with the one two hops back, maximum-filtered
+    // across neighbouring bins, so vibrato and low partials beating inside
+    // the short window don't read as onsets.
+    std::vector<float> older(static_cast<size_t>(numBins), 0.0f);
+    std::vector<float> previous(static_cast<size_t>(numBins), 0.0f);
+    std::vector<float> current(static_cast<size_t>(numBins));
+    std::vector<float> reference(static_cast<size_t>(numBins));
+    std::vector<float> flux(static_cast<size_t>(numFrames), 0.0f);
+
+    AnalysisProfiler::Accumulator transformTime(profiler, "FFT", getName());
+    AnalysisProfiler::Accumulator fluxTime(profiler, "flux", getName());
+
+    for (int frame = 0; frame < numFrames; ++frame) {
+        transformTime.start();
+        int start = frame * hop - size / 2;
+        for (int i = 0; i < size; ++i) {
+            int index = start + i;
+            float sample = index >= 0 && index < numSamples ? data[index] : 0.0f;
+            float window = 0.5f * (1.0f - std::cos(2.0f * juce::MathConstants<float>::pi * i / size));
+            fftData[static_cast<size_t>(i)] = sample * window;
+        }
+        std::fill(fftData.begin() + size, fftData.end(), 0.0f);
 
-    for (int start = 0; start < numSamples - windowSamples; start += hopSamples) {
-        double time = start / sampleRate;
+        fft->performFrequencyOnlyForwardTransform(fftData.data());
+        transformTime.stop();
+        transformTime.addFrames(1);
+
+        fluxTime.start();
+        for (int k = 0; k < numBins; ++k)
+            current[static_cast<size_t>(k)] = std::log1p(compression * magnitudeScale * fftData[static_cast<size_t>(k)]);
+
+        for (int k = 0; k < numBins; ++k) {
+            float peak = older[static_cast<size_t>(k)];
+            if (k > 0) peak = std::max(peak, older[static_cast<size_t>(k - 1)]);
+            if (k + 1 < numBins) peak = std::max(peak, older[static_cast<size_t>(k + 1)]);
+            reference[static_cast<size_t>(k)] = peak;
+        }
 
-        float energy = 0.0f;
-        for (int i = 0; i < windowSamples; ++i) {
-            float sample = data[start + i];
-            energy += sample * sample;
+        float total = 0.0f;
+        for (int b = 0; b < numBands; ++b) {
+            int first = bandEdges[static_cast<size_t>(b)];
+            int last = bandEdges[static_cast<size_t>(b) + 1];
+            if (last <= first) continue;
+
+            float rise = 0.0f;
+            for (int k = first; k < last; ++k)
+                rise += std::max(0.0f, current[static_cast<size_t>(k)] - reference[static_cast<size_t>(k)]);
+            total += rise / (last - first);
         }
-        energy = std::sqrt(energy / windowSamples);
+        flux[static_cast<size_t>(frame)] = total / numBands;
+
+        std::swap(older, previous);
+        std::swap(previous, current);
+        fluxTime.stop();
+        fluxTime.addFrames(1);
+    }
+
+    return flux;
+}
 
-        float onsetStrength = std::max(0.0f, energy - previousEnergy);
+std::vector<std::vector<std::pair<double, double>>> TransientExtractor::extractRaw(const juce::AudioBuffer<float>& buffer,
+    double sampleRate,
+    int channel) {
 
-        results[0].push_back({ time, onsetStrength });
+    std::vector<std::vector<std::pair<double, double>>> results(1);
 
-        previousEnergy = energy;
+    int order = getFftOrder(sampleRate);
+    int hop = (1 << order) / 4;
+    auto flux = computeFlux(buffer.getReadPointer(channel), buffer.getNumSamples(), order, hop);
+    int numFrames = static_cast<int>(flux.size());
+
+    std::array<float, medianBefore + medianAfter + 1> window{};
+
+    for (int n = 0; n < numFrames; ++n) {
+        float value = flux[static_cast<size_t>(n)];
+        if (value <= thresholdOffset) continue;
+
+        // Strictly above the frames before, so a plateau fires once.
+        bool isPeak = true;
+        for (int i = std::max(0, n - peakBefore); i < n && isPeak; ++i)
+            isPeak = flux[static_cast<size_t>(i)] < value;
+        for (int i = n + 1; i <= std::min(numFrames - 1, n + peakAfter) && isPeak; ++i)
+            isPeak = flux[static_cast<size_t>(i)] <= value;
+        if (!isPeak) continue;
+
+        int first = std::max(0, n - medianBefore);
+        int last = std::min(numFrames - 1, n + medianAfter);
+        int count = last - first + 1;
+        std::copy(flux.begin() + first, flux.begin() + last + 1, window.begin());
+        std::nth_element(window.begin(), window.begin() + count / 2, window.begin() + count);
+        float threshold = thresholdOffset + thresholdScale * window[static_cast<size_t>(count / 2)];
+
+        if (value > threshold)
+            results[0].push_back({ static_cast<double>(n) * hop / sampleRate, value });
     }
 
     return results;
@@ -2,11 +2,68 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "AnalysisProfiler.h"
 #include <vector>
 #include <memory>
 #include <algorithm>
+#include <array>
 #include <cmath>
 
+using BreakpointList = std::vector<std::pair<double, double>>;
+
+// Per-frame sums over the time-domain analysis windows. Amplitude and Panning
+// both derive their outputs from these, so the processor computes them once
+// per window/hop setting and shares them.
+struct FrameStatistics {
+    struct Channel {
+        std::vector<float> sumSquares;
+        std::vector<float> sumAbs;
+        std::vector<float> peak;
+    };
+
+    double sampleRate = 0.0;
+    int windowSamples = 0;
+    int hopSamples = 0;
+    std::vector<int> starts;
+    std::vector<int> lengths;
+    std::vector<Channel> channels;
+    std::vector<float> crossProduct; // sum of channel 0 * channel 1, stereo only
+
+    size_t getNumFrames() const { return starts.size(); }
+
+    static FrameStatistics compute(const juce::AudioBuffer<float>& buffer, double sampleRate,
+        float windowSizeMs, float hopSizePct);
+};
+
+// Copies of the audio low-passed and decimated by 2, 4 and 8, for extractors
+// that only look at low frequencies. Each level is made from the one above
+// with a half-band polyphase filter that is zero-phase, so times line up
+// with the source. The source buffer is not copied and must outlive the
+// pyramid.
+struct AnalysisPyramid {
+    struct Level {
+        int factor = 1;
+        double sampleRate = 0.0;
+        const juce::AudioBuffer<float>* audio = nullptr;
+
+        // Highest frequency that passes the decimation filters unchanged.
+        double getBandwidth() const { return factor == 1 ? sampleRate * 0.5 : sampleRate * passbandFraction; }
+    };
+
+    static constexpr int maxFactor = 8;
+    static constexpr double passbandFraction = 0.38;
+
+    // The most decimated level whose passband still covers bandwidthHz.
+    Level getLevelFor(double bandwidthHz) const;
+    Level getLevel(int factor) const;
+
+    static AnalysisPyramid compute(const juce::AudioBuffer<float>& buffer, double sampleRate);
+
+    const juce::AudioBuffer<float>* source = nullptr;
+    double sampleRate = 0.0;
+    std::vector<juce::AudioBuffer<float>> decimated; // by 2, 4, 8
+};
+
 class FeatureExtractor {
 public:
     virtual ~FeatureExtractor() = default;
@@ -16,6 +73,8 @@ public:
     virtual bool supportsMultiChannel() const { return false; }
     virtual int getNumOutputs() const { return 1; }
     virtual juce::String getOutputName(int index) const { return getName(); }
+    // Bump when an extractor's output changes so cached results are dropped.
+    virtual int getVersion() const { return 1; }
 
     struct Settings {
         float windowSizeMs = 15.0f;
@@ -25,13 +84,65 @@ public:
         float maxValue = 1.0f;
         bool smoothOutput = false;
         float smoothTimeMs = 10.0f;
+        bool decimatedAnalysis = false;
     };
 
     Settings settings;
 
-    virtual std::vector<std::vector<std::pair<double, double>>> extract(const juce::AudioBuffer<float>& buffer,
+    // Receives timings of stages inside extractRaw when profiling is on.
+    AnalysisProfiler* profiler = nullptr;
+
+    // Which settings each stage reads. A change to anything outside the raw
+    // mask only reruns postProcess on the stored raw output.
+    enum SettingsDependency {
+        windowSizeSetting = 1 << 0,
+        hopSizeSetting = 1 << 1,
+        normalizeSetting = 1 << 2,
+        smoothingSetting = 1 << 3,
+        decimationSetting = 1 << 4
+    };
+    virtual int getRawSettingsDependencies() const { return 0; }
+    virtual int getPostSettingsDependencies() const { return smoothingSetting; }
+    Settings getSettingsFor(int dependencies) const;
+
+    // Full analysis: the raw extraction followed by post-processing.
+    std::vector<std::vector<std::pair<double, double>>> extract(const juce::AudioBuffer<float>& buffer,
+        double sampleRate,
+        int channel = 0);
+
+    virtual std::vector<std::vector<std::pair<double, double>>> extractRaw(const juce::AudioBuffer<float>& buffer,
         double sampleRate,
         int channel = 0) = 0;
+
+    // Length of each analysis frame and the distance between frame starts,
+    // used when a stream is analysed a block at a time. A frame is reported
+    // once length samples from its start have arrived; each pass reruns the
+    // extractor from lookback frames earlier, so frames that depend on their
+    // neighbours come out as they would offline.
+    struct FrameLayout {
+        int length = 0;
+        int hop = 0;
+        int lookback = 1;
+    };
+    virtual FrameLayout getFrameLayout(double sampleRate) const;
+
+    // Outputs hold a point per detected event rather than one per frame.
+    virtual bool emitsEvents() const { return false; }
+    // Whether the smoothing setting applies to an output. Event outputs and
+    // ones whose jumps carry meaning opt out.
+    virtual bool smoothsOutput(int index) const { return !emitsEvents(); }
+
+    virtual bool usesFrameStatistics() const { return false; }
+    virtual std::vector<std::vector<std::pair<double, double>>> extractFromFrames(const FrameStatistics& frames,
+        int channel) { return {}; }
+
+    // Extractors that only need low frequencies analyse the cheapest level of
+    // the shared pyramid when decimated analysis is on.
+    virtual bool usesAnalysisPyramid() const { return false; }
+    virtual std::vector<std::vector<std::pair<double, double>>> extractFromPyramid(const AnalysisPyramid& pyramid,
+        int channel) { return {}; }
+
+    virtual void postProcess(std::vector<std::vector<std::pair<double, double>>>& outputs) const;
 };
 
 class AmplitudeExtractor : public FeatureExtractor {
@@ -41,10 +152,20 @@ public:
     bool supportsMultiChannel() const override { return true; }
     int getNumOutputs() const override { return 2; }
     juce::String getOutputName(int index) const override { return index == 0 ? "RMS" : "Peak"; }
+    int getVersion() const override { return 2; }
 
-    std::vector<std::vector<std::pair<double, double>>> extract(const juce::AudioBuffer<float>& buffer,
+    int getRawSettingsDependencies() const override { return windowSizeSetting | hopSizeSetting; }
+    int getPostSettingsDependencies() const override { return normalizeSetting | smoothingSetting; }
+
+    std::vector<std::vector<std::pair<double, double>>> extractRaw(const juce::AudioBuffer<float>& buffer,
         double sampleRate,
         int channel = 0) override;
+
+    bool usesFrameStatistics() const override { return true; }
+    std::vector<std::vector<std::pair<double, double>>> extractFromFrames(const FrameStatistics& frames,
+        int channel) override;
+
+    void postProcess(std::vector<std::vector<std::pair<double, double>>>& outputs) const override;
 };
 
 class PanningExtractor : public FeatureExtractor {
@@ -62,9 +183,15 @@ public:
         }
     }
 
-    std::vector<std::vector<std::pair<double, double>>> extract(const juce::AudioBuffer<float>& buffer,
+    int getRawSettingsDependencies() const override { return windowSizeSetting | hopSizeSetting; }
+
+    std::vector<std::vector<std::pair<double, double>>> extractRaw(const juce::AudioBuffer<float>& buffer,
         double sampleRate,
         int channel = 0) override;
+
+    bool usesFrameStatistics() const override { return true; }
+    std::vector<std::vector<std::pair<double, double>>> extractFromFrames(const FrameStatistics& frames,
+        int channel) override;
 };
 
 class SpectralExtractor : public FeatureExtractor {
@@ -84,7 +211,9 @@ public:
         }
     }
 
-    std::vector<std::vector<std::pair<double, double>>> extract(const juce::AudioBuffer<float>& buffer,
+    FrameLayout getFrameLayout(double) const override { return { fftSize, fftSize / 2 }; }
+
+    std::vector<std::vector<std::pair<double, double>>> extractRaw(const juce::AudioBuffer<float>& buffer,
         double sampleRate,
         int channel = 0) override;
 
@@ -106,24 +235,70 @@ public:
     int getNumOutputs() const override { return 2; }
     juce::String getOutputName(int index) const override { return index == 0 ? "Frequency" : "Confidence"; }
 
-    std::vector<std::vector<std::pair<double, double>>> extract(const juce::AudioBuffer<float>& buffer,
+    FrameLayout getFrameLayout(double sampleRate) const override;
+    // Smoothing the frequency would glide through notes never played
+    // whenever the detected pitch jumps.
+    bool smoothsOutput(int index) const override { return index != 0; }
+
+    int getRawSettingsDependencies() const override { return decimationSetting; }
+
+    std::vector<std::vector<std::pair<double, double>>> extractRaw(const juce::AudioBuffer<float>& buffer,
         double sampleRate,
         int channel = 0) override;
 
+    // Detection tops out at 1 kHz; the second harmonic keeps the
+    // autocorrelation peak sharp.
+    static constexpr double requiredBandwidth = 2000.0;
+
+    bool usesAnalysisPyramid() const override { return settings.decimatedAnalysis; }
+    std::vector<std::vector<std::pair<double, double>>> extractFromPyramid(const AnalysisPyramid& pyramid,
+        int channel) override;
+
 private:
-    std::pair<float, float> detectPitch(const float* data, int numSamples, double sampleRate);
+    std::vector<std::vector<std::pair<double, double>>> analyse(const float* data, int numSamples,
+        double sampleRate, bool interpolate);
+    std::pair<float, float> detectPitch(const float* data, int numSamples, double sampleRate, bool interpolate);
 };
 
+// Spectral-flux onset detector. Rises in log magnitude are summed per octave
+// band and the bands averaged, so a hi-hat counts as much as a kick. An onset
+// is a local maximum of that curve above a running median threshold, and
+// only onsets are emitted, each with its flux as the strength. Frames are
+// centred on their times, about 23 ms long with a quarter-frame hop.
 class TransientExtractor : public FeatureExtractor {
 public:
     juce::String getName() const override { return "Transients"; }
     juce::Colour getColor() const override { return juce::Colours::red; }
     int getNumOutputs() const override { return 1; }
     juce::String getOutputName(int index) const override { return "Onset Strength"; }
+    int getVersion() const override { return 2; }
 
-    std::vector<std::vector<std::pair<double, double>>> extract(const juce::AudioBuffer<float>& buffer,
+    bool emitsEvents() const override { return true; }
+    int getPostSettingsDependencies() const override { return 0; }
+    FrameLayout getFrameLayout(double sampleRate) const override;
+
+    std::vector<std::vector<std::pair<double, double>>> extractRaw(const juce::AudioBuffer<float>& buffer,
         double sampleRate,
         int channel = 0) override;
+
+    static int getFftOrder(double sampleRate);
+
+    static constexpr int numBands = 8;
+    static constexpr float compression = 100.0f;
+    static constexpr int fluxLag = 2;
+    static constexpr int medianBefore = 8;   // frames in the threshold's median
+    static constexpr int medianAfter = 2;
+    static constexpr int peakBefore = 5;     // also the shortest gap between onsets
+    static constexpr int peakAfter = 2;
+    static constexpr float thresholdScale = 1.5f;
+    static constexpr float thresholdOffset = 0.01f;
+
+private:
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float> fftData;
+
+    // Onset detection function, one value per frame.
+    std::vector<float> computeFlux(const float* data, int numSamples, int order, int hop);
 };
 
 class FeatureExtractorFactory {
@@ -0,0 +1,262 @@
+// LiveAnalyzer.cpp
+
+#include "LiveAnalyzer.h"
+#include "TraceRecorder.h"
+#include <cstring>
+
+LiveAnalyzer::LiveAnalyzer() : juce::Thread("Live Analysis") {}
+
+LiveAnalyzer::~LiveAnalyzer() {
+    stopThread(2000);
+}
+
+void LiveAnalyzer::prepare(double newSampleRate, int newNumChannels, int maxBlockSize) {
+    stopCapture();
+
+    sampleRate = newSampleRate;
+    numChannels = juce::jmax(0, newNumChannels);
+
+    int capacity = juce::jmax(maxBlockSize * 4, static_cast<int>(sampleRate * ringSeconds));
+    fifo.setTotalSize(capacity);
+    ring.setSize(numChannels, capacity);
+    ring.clear();
+}
+
+void LiveAnalyzer::release() {
+    stopCapture();
+
+    numChannels = 0;
+    ring.setSize(0, 0);
+    fifo.setTotalSize(1);
+
+    const juce::ScopedLock sl(workerLock);
+    history.setSize(0, 0);
+    historyLength = 0;
+}
+
+void LiveAnalyzer::pushBlock(const juce::AudioBuffer<float>& buffer) {
+    if (!capturing.load(std::memory_order_acquire) || numChannels == 0) return;
+
+    int numSamples = buffer.getNumSamples();
+    if (fifo.getFreeSpace() < numSamples) {
+        // The worker has fallen behind; it skips the lost span rather than
+        // joining audio from either side of it.
+        droppedSamples.fetch_add(numSamples, std::memory_order_relaxed);
+        return;
+    }
+
+    int channelsToCopy = juce::jmin(numChannels, buffer.getNumChannels());
+    const auto scope = fifo.write(numSamples);
+
+    for (int ch = 0; ch < numChannels; ++ch) {
+        if (ch < channelsToCopy) {
+            if (scope.blockSize1 > 0)
+                ring.copyFrom(ch, scope.startIndex1, buffer, ch, 0, scope.blockSize1);
+            if (scope.blockSize2 > 0)
+                ring.copyFrom(ch, scope.startIndex2, buffer, ch, scope.blockSize1, scope.blockSize2);
+        }
+        else {
+            if (scope.blockSize1 > 0) ring.clear(ch, scope.startIndex1, scope.blockSize1);
+            if (scope.blockSize2 > 0) ring.clear(ch, scope.startIndex2, scope.blockSize2);
+        }
+    }
+}
+
+bool LiveAnalyzer::startCapture(const FeatureExtractor::Settings& settings) {
+    stopCapture();
+    if (numChannels == 0) return false;
+
+    {
+        const juce::ScopedLock sl(workerLock);
+
+        // Anything still in the ring belongs to the previous capture.
+        { const auto stale = fifo.read(fifo.getNumReady()); }
+        droppedSamples = 0;
+        totalDroppedSamples = 0;
+
+        features.clear();
+        for (const auto& name : FeatureExtractorFactory::getAvailableFeatures()) {
+            LiveFeature feature;
+            feature.extractor = FeatureExtractorFactory::createExtractor(name);
+            feature.extractor->settings = settings;
+            feature.layout = feature.extractor->getFrameLayout(sampleRate);
+            features.push_back(std::move(feature));
+        }
+
+        history.setSize(numChannels, static_cast<int>(sampleRate * ringSeconds), false, true, true);
+        historyStart = 0;
+        historyLength = 0;
+        capturedSamples = 0;
+    }
+
+    {
+        const juce::ScopedLock sl(resultsLock);
+        newBreakpoints.clear();
+    }
+
+    capturing.store(true, std::memory_order_release);
+    startThread();
+    return true;
+}
+
+void LiveAnalyzer::stopCapture() {
+    if (!capturing.exchange(false)) return;
+
+    stopThread(2000);
+    // Analyse whatever the worker hadn't reached yet, including the trailing
+    // partial frames an offline extraction would report.
+    processPending(true);
+}
+
+double LiveAnalyzer::getCapturedSeconds() const {
+    return static_cast<double>(capturedSamples.load()) / sampleRate;
+}
+
+bool LiveAnalyzer::takeNewBreakpoints(std::map<juce::String, std::vector<BreakpointList>>& dest) {
+    const juce::ScopedLock sl(resultsLock);
+    if (newBreakpoints.empty()) return false;
+
+    dest = std::move(newBreakpoints);
+    newBreakpoints.clear();
+    return true;
+}
+
+void LiveAnalyzer::run() {
+    while (!threadShouldExit()) {
+        processPending(false);
+        wait(pollIntervalMs);
+    }
+}
+
+void LiveAnalyzer::processPending(bool finalPass) {
+    const juce::ScopedLock sl(workerLock);
+
+    // Read before draining: drops only happen while the ring is full, so
+    // nearly everything drained now came before them.
+    auto dropped = droppedSamples.exchange(0);
+
+    drainRing();
+
+    std::map<juce::String, std::vector<BreakpointList>> found;
+    for (auto& feature : features)
+        analyseFeature(feature, found[feature.extractor->getName()], finalPass);
+
+    if (dropped > 0) {
+        totalDroppedSamples += dropped;
+        skipGap(dropped);
+    }
+
+    trimHistory();
+
+    const juce::ScopedLock rl(resultsLock);
+    for (auto& [name, outputs] : found) {
+        bool hasPoints = std::any_of(outputs.begin(), outputs.end(),
+            [](const BreakpointList& points) { return !points.empty(); });
+        if (!hasPoints) continue;
+
+        auto& target = newBreakpoints[name];
+        target.resize(juce::jmax(target.size(), outputs.size()));
+        for (size_t i = 0; i < outputs.size(); ++i)
+            target[i].insert(target[i].end(), outputs[i].begin(), outputs[i].end());
+    }
+}
+
+void LiveAnalyzer::drainRing() {
+    int ready = fifo.getNumReady();
+    if (ready == 0 || numChannels == 0) return;
+
+    if (history.getNumSamples() < historyLength + ready) {
+        history.setSize(numChannels, juce::jmax(historyLength + ready, history.getNumSamples() * 2),
+            true, false, true);
+    }
+
+    const auto scope = fifo.read(ready);
+    for (int ch = 0; ch < numChannels; ++ch) {
+        if (scope.blockSize1 > 0)
+            history.copyFrom(ch, historyLength, ring, ch, scope.startIndex1, scope.blockSize1);
+        if (scope.blockSize2 > 0)
+            history.copyFrom(ch, historyLength + scope.blockSize1, ring, ch, scope.startIndex2, scope.blockSize2);
+    }
+
+    historyLength += ready;
+    capturedSamples = historyStart + historyLength;
+}
+
+void LiveAnalyzer::analyseFeature(LiveFeature& feature, std::vector<BreakpointList>& found,
+    bool finalPass) {
+    const auto& layout = feature.layout;
+    juce::int64 end = historyStart + historyLength;
+
+    juce::int64 required = finalPass ? 1 : layout.length;
+    if (layout.length <= 0 || feature.nextFrame + required > end) return;
+
+    TraceRecorder::Scope trace("live pass", feature.extractor->getName());
+
+    // Lookback frames give extractors that compare against earlier frames
+    // (flux, onset thresholds) the same input they'd see offline. Their
+    // output is discarded below.
+    auto lookback = juce::jmin(static_cast<juce::int64>(layout.lookback),
+        (feature.nextFrame - historyStart) / layout.hop);
+    juce::int64 chunkStart = feature.nextFrame - lookback * layout.hop;
+
+    juce::AudioBuffer<float> chunk(history.getArrayOfWritePointers(), numChannels,
+        static_cast<int>(chunkStart - historyStart), static_cast<int>(end - chunkStart));
+
+    auto outputs = feature.extractor->extractRaw(chunk, sampleRate, 0);
+    found.resize(outputs.size());
+
+    juce::int64 lastFrame = -1;
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        for (const auto& [time, value] : outputs[i]) {
+            auto frame = chunkStart + static_cast<juce::int64>(std::llround(time * sampleRate));
+
+            // Extractors also emit the trailing partial frame; it is
+            // reported once the rest of its window has arrived, or on the final pass.
+            if (frame < feature.nextFrame || frame + required > end) continue;
+
+            found[i].emplace_back(static_cast<double>(frame) / sampleRate, value);
+            lastFrame = juce::jmax(lastFrame, frame);
+        }
+    }
+
+    // Most frames of an event extractor emit nothing, so it moves on past
+    // every frame that is complete.
+    if (feature.extractor->emitsEvents() && end - required >= feature.nextFrame)
+        lastFrame = juce::jmax(lastFrame,
+            feature.nextFrame + (end - required - feature.nextFrame) / layout.hop * layout.hop);
+
+    if (lastFrame >= 0)
+        feature.nextFrame = lastFrame + layout.hop;
+}
+
+void LiveAnalyzer::skipGap(juce::int64 numSamples) {
+    // Frames never straddle the gap; each extractor restarts after it as it
+    // would at the start of a file.
+    historyStart += historyLength + numSamples;
+    historyLength = 0;
+    capturedSamples = historyStart;
+    for (auto& feature : features)
+        feature.nextFrame = historyStart;
+}
+
+void LiveAnalyzer::trimHistory() {
+    juce::int64 keepFrom = historyStart + historyLength;
+    for (const auto& feature : features)
+        keepFrom = juce::jmin(keepFrom, feature.nextFrame
+            - static_cast<juce::int64>(feature.layout.hop) * feature.layout.lookback);
+    keepFrom = juce::jmax(keepFrom, historyStart);
+
+    // Only shift once a good share of the buffer is stale, so each sample
+    // is moved a bounded number of times.
+    int discard = static_cast<int>(keepFrom - historyStart);
+    if (discard == 0 || discard < history.getNumSamples() / 2) return;
+
+    int remaining = historyLength - discard;
+    for (int ch = 0; ch < numChannels; ++ch) {
+        float* data = history.getWritePointer(ch);
+        std::memmove(data, data + discard, sizeof(float) * static_cast<size_t>(remaining));
+    }
+
+    historyStart = keepFrom;
+    historyLength = remaining;
+}
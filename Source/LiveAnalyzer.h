@@ -0,0 +1,82 @@
+// LiveAnalyzer.h
+#pragma once
+
+#include <JuceHeader.h>
+#include "FeatureExtractors.h"
+
+// Analyses the plugin's input while the host plays.
+//
+// The audio thread only copies each block into a single-producer,
+// single-consumer ring (pushBlock never allocates or locks). A worker thread
+// drains the ring into a linear history and runs every extractor over the
+// frames that have become complete since its last pass, so the breakpoints
+// match an offline extraction of the same audio frame for frame. Times are
+// seconds since the capture started.
+class LiveAnalyzer : private juce::Thread {
+public:
+    LiveAnalyzer();
+    ~LiveAnalyzer() override;
+
+    // Not called concurrently with pushBlock (prepareToPlay/releaseResources).
+    void prepare(double sampleRate, int numChannels, int maxBlockSize);
+    void release();
+
+    // Audio thread.
+    void pushBlock(const juce::AudioBuffer<float>& buffer);
+
+    // Message thread. Settings are taken once per capture so the frame
+    // layout stays fixed while it runs. Fails if the input has no channels.
+    bool startCapture(const FeatureExtractor::Settings& settings);
+    void stopCapture();
+    bool isCapturing() const { return capturing.load(); }
+
+    double getSampleRate() const { return sampleRate; }
+    double getCapturedSeconds() const;
+    juce::int64 getNumDroppedSamples() const { return totalDroppedSamples.load(); }
+
+    // Moves out the breakpoints found since the previous call, per feature
+    // and output. Returns false when there is nothing new.
+    bool takeNewBreakpoints(std::map<juce::String, std::vector<BreakpointList>>& dest);
+
+private:
+    struct LiveFeature {
+        std::unique_ptr<FeatureExtractor> extractor;
+        FeatureExtractor::FrameLayout layout;
+        juce::int64 nextFrame = 0;
+    };
+
+    double sampleRate = 44100.0;
+    int numChannels = 0;
+
+    // Audio thread -> worker
+    juce::AbstractFifo fifo{ 1 };
+    juce::AudioBuffer<float> ring;
+    std::atomic<bool> capturing{ false };
+    std::atomic<juce::int64> droppedSamples{ 0 };
+    std::atomic<juce::int64> totalDroppedSamples{ 0 };
+
+    // Worker state, guarded by workerLock so start/stop can drain the ring
+    // from the message thread between passes.
+    juce::CriticalSection workerLock;
+    std::vector<LiveFeature> features;
+    juce::AudioBuffer<float> history;
+    juce::int64 historyStart = 0;
+    int historyLength = 0;
+    std::atomic<juce::int64> capturedSamples{ 0 };
+
+    // Worker -> message thread
+    juce::CriticalSection resultsLock;
+    std::map<juce::String, std::vector<BreakpointList>> newBreakpoints;
+
+    static constexpr double ringSeconds = 4.0;
+    static constexpr int pollIntervalMs = 10;
+
+    void run() override;
+    void processPending(bool finalPass);
+    void drainRing();
+    void analyseFeature(LiveFeature& feature, std::vector<BreakpointList>& found, bool finalPass);
+    void trimHistory();
+    void skipGap(juce::int64 numSamples);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LiveAnalyzer)
+};
@@ -0,0 +1,90 @@
+// MemoryBudget.cpp
+#include "MemoryBudget.h"
+
+juce::int64 MemoryBudget::Usage::getTotal() const {
+    juce::int64 total = 0;
+    for (auto count : bytes)
+        total += count;
+    return total;
+}
+
+juce::String MemoryBudget::getKindName(Kind kind) {
+    switch (kind) {
+        case decodedAudio: return "Decoded audio";
+        case frameStatistics: return "Frame statistics";
+        case analysisPyramid: return "Decimated audio";
+        case rawStages: return "Raw extractor output";
+        case tracks: return "Tracks";
+        case sessionTracks: return "Other session files";
+        case playbackTracks: return "Playback copies";
+        case trackIndexes: return "Track indexes";
+        case similarityIndex: return "Similarity index";
+        case undoHistory: return "Undo history";
+        default: return {};
+    }
+}
+
+juce::String MemoryBudget::formatBytes(juce::int64 bytes) {
+    if (bytes >= 1024LL * 1024 * 1024)
+        return juce::String(bytes / (1024.0 * 1024.0 * 1024.0), 2) + " GB";
+    if (bytes >= 1024LL * 1024)
+        return juce::String(bytes / (1024.0 * 1024.0), 1) + " MB";
+    return juce::String(bytes / 1024) + " KB";
+}
+
+juce::String MemoryBudget::describe(const Usage& usage, juce::int64 limit) {
+    juce::String text;
+    text << "Memory " << formatBytes(usage.getTotal()) << " of "
+        << (limit == unlimited ? juce::String("unlimited") : formatBytes(limit)) << "\n";
+
+    for (int kind = 0; kind < numKinds; ++kind) {
+        text << ("  " + getKindName(static_cast<Kind>(kind))).paddedRight(' ', 28)
+            << formatBytes(usage.bytes[static_cast<size_t>(kind)]).paddedLeft(' ', 12) << "\n";
+    }
+    if (usage.numSpilledFiles > 0) {
+        text << ("  Spilled to disk (" + juce::String(usage.numSpilledFiles) + " files)").paddedRight(' ', 28)
+            << formatBytes(usage.spilledBytes).paddedLeft(' ', 12) << "\n";
+    }
+    return text;
+}
+
+juce::int64 MemoryBudget::bytesOf(const juce::AudioBuffer<float>& buffer) {
+    return static_cast<juce::int64>(buffer.getNumChannels()) * buffer.getNumSamples()
+        * static_cast<juce::int64>(sizeof(float));
+}
+
+juce::int64 MemoryBudget::bytesOf(const FrameStatistics& frames) {
+    auto count = [](const auto& column) {
+        return static_cast<juce::int64>(column.capacity() * sizeof(column[0]));
+    };
+
+    juce::int64 bytes = count(frames.starts) + count(frames.lengths) + count(frames.crossProduct);
+    for (const auto& channel : frames.channels)
+        bytes += count(channel.sumSquares) + count(channel.sumAbs) + count(channel.peak);
+    return bytes;
+}
+
+juce::int64 MemoryBudget::bytesOf(const AnalysisPyramid& pyramid) {
+    juce::int64 bytes = 0;
+    for (const auto& level : pyramid.decimated)
+        bytes += bytesOf(level);
+    return bytes;
+}
+
+juce::int64 MemoryBudget::bytesOf(const std::vector<BreakpointList>& outputs) {
+    juce::int64 bytes = 0;
+    for (const auto& points : outputs)
+        bytes += static_cast<juce::int64>(points.capacity() * sizeof(points[0]));
+    return bytes;
+}
+
+juce::int64 MemoryBudget::bytesOf(const std::map<juce::String, std::vector<BreakpointList>>& features) {
+    juce::int64 bytes = 0;
+    for (const auto& [featureName, outputs] : features)
+        bytes += bytesOf(outputs);
+    return bytes;
+}
+
+juce::int64 MemoryBudget::bytesOf(const BreakpointIndex& index) {
+    return index.getMemoryBytes();
+}
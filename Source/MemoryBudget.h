@@ -0,0 +1,51 @@
+// MemoryBudget.h
+#pragma once
+
+#include <JuceHeader.h>
+#include "FeatureExtractors.h"
+#include "BreakpointIndex.h"
+#include <array>
+
+// Accounting of what the plugin holds in memory, by kind, against a limit
+// the user picks. The processor fills a Usage from its own members; going
+// over the limit makes it give up the kinds it can get back, coldest first
+// (see AudioDeconstructorProcessor::enforceMemoryBudget).
+class MemoryBudget {
+public:
+    enum Kind {
+        decodedAudio,    // the file on view
+        frameStatistics, // shared frame sums, recomputed on demand
+        analysisPyramid, // decimated copies, recomputed on demand
+        rawStages,       // raw extractor output, also in the analysis cache
+        tracks,          // the tracks on view, and their encoding for the plugin state
+        sessionTracks,   // tracks of other session files still in memory
+        playbackTracks,  // the audio thread's copies of the played and mirrored tracks
+        trackIndexes,    // time indexes over the tracks on view
+        similarityIndex, // sampled grids of every indexed file
+        undoHistory,     // edits kept for undo, up to the history's own limit
+        numKinds
+    };
+
+    struct Usage {
+        std::array<juce::int64, numKinds> bytes{};
+        juce::int64 spilledBytes = 0; // session tracks written out to disk
+        int numSpilledFiles = 0;
+
+        juce::int64 getTotal() const;
+    };
+
+    static constexpr juce::int64 defaultLimit = 1024LL * 1024 * 1024;
+    static constexpr juce::int64 unlimited = 0;
+
+    static juce::String getKindName(Kind kind);
+    static juce::String formatBytes(juce::int64 bytes);
+    // One line per kind, for the stats view.
+    static juce::String describe(const Usage& usage, juce::int64 limit);
+
+    static juce::int64 bytesOf(const juce::AudioBuffer<float>& buffer);
+    static juce::int64 bytesOf(const FrameStatistics& frames);
+    static juce::int64 bytesOf(const AnalysisPyramid& pyramid);
+    static juce::int64 bytesOf(const std::vector<BreakpointList>& outputs);
+    static juce::int64 bytesOf(const std::map<juce::String, std::vector<BreakpointList>>& features);
+    static juce::int64 bytesOf(const BreakpointIndex& index);
+};
@@ -0,0 +1,495 @@
+// MultiFeatureDisplay.cpp
+#include "MultiFeatureDisplay.h"
+#include "TraceRecorder.h"
+
+namespace {
+
+constexpr int rulerHeight = 16;
+constexpr double zoomPerWheelUnit = 3.0; // a wheel notch is about 0.1, so ~20% per notch
+constexpr double smoothing = 0.35;       // fraction of the remaining distance per animation frame
+
+double getNiceStep(double approximateStep) {
+    double magnitude = std::pow(10.0, std::floor(std::log10(approximateStep)));
+    for (double multiple : { 1.0, 2.0, 5.0 }) {
+        if (magnitude * multiple >= approximateStep)
+            return magnitude * multiple;
+    }
+    return magnitude * 10.0;
+}
+
+} // namespace
+
+MultiFeatureDisplay::MultiFeatureDisplay() {
+    setOpaque(true);
+}
+
+void MultiFeatureDisplay::resized() {
+}
+
+void MultiFeatureDisplay::setFeatures(const FeatureMap* newFeatures) {
+    features = newFeatures;
+    featuresChanged();
+}
+
+void MultiFeatureDisplay::featuresChanged() {
+    tracksDirty = true;
+    repaint();
+}
+
+void MultiFeatureDisplay::setIndexSource(IndexSource source) {
+    indexSource = std::move(source);
+    featuresChanged();
+}
+
+void MultiFeatureDisplay::setRevisionSource(RevisionSource source) {
+    revisionSource = std::move(source);
+    featuresChanged();
+}
+
+const BreakpointIndex* MultiFeatureDisplay::getIndex(const Track& track) const {
+    if (track.ownIndex != nullptr) return track.ownIndex.get();
+    return indexSource != nullptr ? indexSource(track.feature, track.output) : nullptr;
+}
+
+void MultiFeatureDisplay::setActiveFeature(const juce::String& feature, int outputIndex) {
+    if (feature == activeFeature && outputIndex == activeOutput) return;
+
+    activeFeature = feature;
+    activeOutput = outputIndex;
+    repaint();
+}
+
+void MultiFeatureDisplay::setShowAllFeatures(bool showAll) {
+    if (showAll == showAllFeatures) return;
+
+    showAllFeatures = showAll;
+    repaint();
+}
+
+void MultiFeatureDisplay::setLayout(Layout newLayout) {
+    if (newLayout == layout) return;
+
+    layout = newLayout;
+    repaint();
+}
+
+void MultiFeatureDisplay::setDuration(double seconds) {
+    duration = juce::jmax(0.0, seconds);
+}
+
+void MultiFeatureDisplay::setTimeRange(double startTime, double endTime) {
+    moveTo(startTime, endTime, false);
+}
+
+double MultiFeatureDisplay::getTotalDuration() {
+    updateTracks();
+
+    double total = duration;
+    for (const auto& track : tracks) {
+        if (!track.points->empty())
+            total = juce::jmax(total, track.points->back().first);
+    }
+    return juce::jmax(total, minimumSpan);
+}
+
+void MultiFeatureDisplay::moveTo(double startTime, double endTime, bool animate) {
+    double total = getTotalDuration();
+    double span = juce::jlimit(minimumSpan, juce::jmax(total, minimumSpan), endTime - startTime);
+    startTime = juce::jlimit(0.0, juce::jmax(0.0, total - span), startTime);
+
+    targetStartTime = startTime;
+    targetEndTime = startTime + span;
+
+    if (!animate) {
+        viewStartTime = targetStartTime;
+        viewEndTime = targetEndTime;
+        stopTimer();
+    }
+    else if (!isTimerRunning()) {
+        startTimerHz(60);
+    }
+    repaint();
+}
+
+void MultiFeatureDisplay::zoomAround(double time, double factor) {
+    // The pointer stays over the same time; the span compounds on the target
+    // so quick wheel movements add up while the view catches up.
+    double fraction = (time - viewStartTime) / (viewEndTime - viewStartTime);
+    double span = (targetEndTime - targetStartTime) * factor;
+    double startTime = time - fraction * span;
+    moveTo(startTime, startTime + span, true);
+}
+
+void MultiFeatureDisplay::panBy(double seconds) {
+    moveTo(targetStartTime + seconds, targetEndTime + seconds, true);
+}
+
+void MultiFeatureDisplay::timerCallback() {
+    viewStartTime += (targetStartTime - viewStartTime) * smoothing;
+    viewEndTime += (targetEndTime - viewEndTime) * smoothing;
+
+    double tolerance = (targetEndTime - targetStartTime) * 1.0e-3;
+    if (std::abs(targetStartTime - viewStartTime) < tolerance && std::abs(targetEndTime - viewEndTime) < tolerance) {
+        viewStartTime = targetStartTime;
+        viewEndTime = targetEndTime;
+        stopTimer();
+    }
+    repaint();
+}
+
+void MultiFeatureDisplay::mouseDown(const juce::MouseEvent& event) {
+    if (event.mods.isPopupMenu()) {
+        juce::PopupMenu menu;
+        menu.addItem(1, "Stacked", true, layout == Layout::stacked);
+        menu.addItem(2, "Overlaid", true, layout == Layout::overlaid);
+        menu.addSeparator();
+        menu.addItem(3, "All Features", true, showAllFeatures);
+        menu.addItem(4, "Show Everything");
+
+        juce::Component::SafePointer<MultiFeatureDisplay> safeThis(this);
+        menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(this), [safeThis](int result) {
+            if (safeThis == nullptr) return;
+            switch (result) {
+            case 1: safeThis->setLayout(Layout::stacked); break;
+            case 2: safeThis->setLayout(Layout::overlaid); break;
+            case 3: safeThis->setShowAllFeatures(!safeThis->showAllFeatures); break;
+            case 4: safeThis->moveTo(0.0, safeThis->getTotalDuration(), true); break;
+            default: break;
+            }
+            });
+        return;
+    }
+
+    dragStart = event.position;
+    dragStartTime = viewStartTime;
+    dragMoved = false;
+}
+
+void MultiFeatureDisplay::mouseDrag(const juce::MouseEvent& event) {
+    if (event.mods.isPopupMenu()) return;
+
+    float distance = event.position.x - dragStart.x;
+    dragMoved = dragMoved || std::abs(distance) > 2.0f;
+    if (!dragMoved) return;
+
+    double span = viewEndTime - viewStartTime;
+    double startTime = dragStartTime - distance * span / juce::jmax(1, getGraphArea().getWidth());
+    moveTo(startTime, startTime + span, false);
+}
+
+void MultiFeatureDisplay::mouseUp(const juce::MouseEvent& event) {
+    if (dragMoved || event.mods.isPopupMenu() || onTrackSelected == nullptr || layout != Layout::stacked)
+        return;
+
+    updateTracks();
+
+    auto area = getGraphArea();
+    auto visible = getVisibleTracks();
+    for (int lane = 0; lane < static_cast<int>(visible.size()); ++lane) {
+        if (getLaneArea(area, lane, static_cast<int>(visible.size())).contains(event.getPosition())) {
+            onTrackSelected(visible[static_cast<size_t>(lane)]->feature, visible[static_cast<size_t>(lane)]->output);
+            break;
+        }
+    }
+}
+
+void MultiFeatureDisplay::mouseDoubleClick(const juce::MouseEvent&) {
+    moveTo(0.0, getTotalDuration(), true);
+}
+
+void MultiFeatureDisplay::mouseWheelMove(const juce::MouseEvent& event, const juce::MouseWheelDetails& wheel) {
+    double span = viewEndTime - viewStartTime;
+
+    // Trackpads scroll sideways to pan; shift turns a vertical wheel into a pan.
+    if (event.mods.isShiftDown() || std::abs(wheel.deltaX) > std::abs(wheel.deltaY)) {
+        float delta = std::abs(wheel.deltaX) > std::abs(wheel.deltaY) ? wheel.deltaX : wheel.deltaY;
+        panBy(-delta * span);
+        return;
+    }
+
+    auto area = getGraphArea();
+    double time = viewStartTime + (event.position.x - area.getX()) * span / juce::jmax(1, area.getWidth());
+    zoomAround(time, std::pow(2.0, -wheel.deltaY * zoomPerWheelUnit));
+}
+
+void MultiFeatureDisplay::mouseMagnify(const juce::MouseEvent& event, float scaleFactor) {
+    if (scaleFactor <= 0.0f) return;
+
+    auto area = getGraphArea();
+    double time = viewStartTime + (event.position.x - area.getX())
+        * (viewEndTime - viewStartTime) / juce::jmax(1, area.getWidth());
+    zoomAround(time, 1.0 / scaleFactor);
+}
+
+void MultiFeatureDisplay::updateTracks() {
+    // Track pointers go stale once the map changes. Reading the revision
+    // may itself replace the map, so it comes before anything else.
+    if (revisionSource != nullptr) {
+        auto revision = revisionSource();
+        if (revision != tracksRevision) {
+            tracksRevision = revision;
+            tracksDirty = true;
+        }
+    }
+    if (tracksDirty)
+        rebuildTracks();
+}
+
+void MultiFeatureDisplay::rebuildTracks() {
+    tracks.clear();
+    tracksDirty = false;
+    if (features == nullptr) return;
+
+    for (const auto& [featureName, outputs] : *features) {
+        auto info = featureInfo.find(featureName);
+        if (info == featureInfo.end()) {
+            FeatureInfo newInfo;
+            newInfo.colour = FeatureExtractorFactory::getFeatureColour(featureName);
+            if (auto extractor = FeatureExtractorFactory::createExtractor(featureName)) {
+                for (int i = 0; i < extractor->getNumOutputs(); ++i)
+                    newInfo.outputNames.add(extractor->getOutputName(i));
+                newInfo.events = extractor->emitsEvents();
+            }
+            info = featureInfo.emplace(featureName, std::move(newInfo)).first;
+        }
+
+        for (size_t output = 0; output < outputs.size(); ++output) {
+            Track track;
+            track.feature = featureName;
+            track.output = static_cast<int>(output);
+            track.label = featureName + ": " + (output < static_cast<size_t>(info->second.outputNames.size())
+                ? info->second.outputNames[static_cast<int>(output)] : juce::String(track.output + 1));
+            track.colour = info->second.colour.brighter(0.3f * track.output);
+            track.events = info->second.events;
+            track.points = &outputs[output];
+            if (getIndex(track) == nullptr)
+                track.ownIndex = std::make_unique<BreakpointIndex>(outputs[output]);
+            setValueRange(track);
+            tracks.push_back(std::move(track));
+        }
+    }
+}
+
+void MultiFeatureDisplay::setValueRange(Track& track) const {
+    auto* index = getIndex(track);
+    auto overall = index != nullptr ? index->getOverallSummary() : BreakpointIndex::Summary();
+    track.minValue = overall.isEmpty() ? 0.0f : overall.minValue;
+    track.maxValue = overall.isEmpty() ? 1.0f : overall.maxValue;
+
+    // Events rise from zero; flat tracks get a unit range around their value.
+    if (track.events)
+        track.minValue = juce::jmin(track.minValue, 0.0f);
+    if (track.maxValue - track.minValue < 1.0e-6f) {
+        track.minValue -= 0.5f;
+        track.maxValue += 0.5f;
+    }
+}
+
+std::vector<const MultiFeatureDisplay::Track*> MultiFeatureDisplay::getVisibleTracks() const {
+    std::vector<const Track*> visible;
+    for (const auto& track : tracks) {
+        if (showAllFeatures || track.feature == activeFeature)
+            visible.push_back(&track);
+    }
+    return visible;
+}
+
+juce::Rectangle<int> MultiFeatureDisplay::getGraphArea() const {
+    return getLocalBounds().withTrimmedBottom(rulerHeight);
+}
+
+juce::Rectangle<int> MultiFeatureDisplay::getLaneArea(const juce::Rectangle<int>& area, int lane, int numLanes) const {
+    if (layout == Layout::overlaid || numLanes <= 1) return area;
+
+    int top = area.getY() + area.getHeight() * lane / numLanes;
+    int bottom = area.getY() + area.getHeight() * (lane + 1) / numLanes;
+    return { area.getX(), top, area.getWidth(), bottom - top };
+}
+
+void MultiFeatureDisplay::paint(juce::Graphics& g) {
+    TraceRecorder::Scope trace("overview paint");
+
+    updateTracks();
+
+    g.fillAll(juce::Colour(0xff2d2d2d));
+
+    auto area = getGraphArea();
+    drawGrid(g, area);
+    drawAllFeatures(g, area);
+
+    g.setColour(juce::Colour(0xff444444));
+    g.drawRect(getLocalBounds(), 1);
+}
+
+void MultiFeatureDisplay::drawGrid(juce::Graphics& g, const juce::Rectangle<int>& area) {
+    double span = viewEndTime - viewStartTime;
+    if (span <= 0.0 || area.getWidth() <= 0) return;
+
+    // About one labelled line per 100 pixels, on round times.
+    double step = getNiceStep(span * 100.0 / area.getWidth());
+    int decimals = juce::jmax(0, static_cast<int>(-std::floor(std::log10(step))));
+
+    auto ruler = getLocalBounds().removeFromBottom(rulerHeight);
+    g.setFont(10.0f);
+
+    for (double time = std::ceil(viewStartTime / step) * step; time <= viewEndTime; time += step) {
+        float x = static_cast<float>(area.getX() + (time - viewStartTime) / span * area.getWidth());
+
+        g.setColour(juce::Colour(0xff3a3a3a));
+        g.drawVerticalLine(juce::roundToInt(x), static_cast<float>(area.getY()), static_cast<float>(area.getBottom()));
+
+        g.setColour(juce::Colours::grey);
+        g.drawText(juce::String(time, decimals) + "s", juce::roundToInt(x) + 2, ruler.getY(), 60, ruler.getHeight(),
+            juce::Justification::centredLeft);
+    }
+}
+
+void MultiFeatureDisplay::drawAllFeatures(juce::Graphics& g, const juce::Rectangle<int>& area) {
+    auto visible = getVisibleTracks();
+    if (visible.empty()) {
+        g.setColour(juce::Colours::grey);
+        g.setFont(12.0f);
+        g.drawText("No extracted features", area, juce::Justification::centred);
+        return;
+    }
+
+    int numLanes = static_cast<int>(visible.size());
+    g.setFont(11.0f);
+
+    for (int lane = 0; lane < numLanes; ++lane) {
+        const auto& track = *visible[static_cast<size_t>(lane)];
+        bool highlighted = track.feature == activeFeature && track.output == activeOutput;
+        auto laneArea = getLaneArea(area, lane, numLanes);
+
+        if (layout == Layout::stacked) {
+            if (highlighted) {
+                g.setColour(juce::Colour(0xff363636));
+                g.fillRect(laneArea);
+            }
+            g.setColour(juce::Colour(0xff444444));
+            g.drawHorizontalLine(laneArea.getBottom() - 1, static_cast<float>(area.getX()),
+                static_cast<float>(area.getRight()));
+        }
+
+        {
+            juce::Graphics::ScopedSaveState state(g);
+            g.reduceClipRegion(laneArea);
+            drawFeature(g, laneArea.reduced(0, 2), track, highlighted);
+        }
+
+        // Stacked lanes carry their own label; overlaid tracks get a legend.
+        auto labelArea = layout == Layout::stacked ? laneArea.withHeight(juce::jmin(14, laneArea.getHeight()))
+                                                   : area.withTrimmedTop(lane * 14).withHeight(14);
+        g.setColour(track.colour.withAlpha(highlighted ? 1.0f : 0.8f));
+        g.drawText(track.label, labelArea.reduced(4, 0), juce::Justification::topLeft);
+    }
+}
+
+std::vector<MultiFeatureDisplay::Column> MultiFeatureDisplay::computeColumns(const Track& track,
+    const BreakpointIndex& index, size_t begin, size_t end, int width) const {
+
+    const auto& points = *track.points;
+    double pixelsPerSecond = width / (viewEndTime - viewStartTime);
+    // Columns start empty, with an inverted range.
+    std::vector<Column> columns(static_cast<size_t>(width));
+
+    auto add = [&](double time, const Column& values) {
+        int x = juce::jlimit(0, width - 1, static_cast<int>((time - viewStartTime) * pixelsPerSecond));
+        columns[static_cast<size_t>(x)].add(values);
+    };
+
+    // The coarsest summary that still puts a couple of entries in each column.
+    double pointsPerColumn = static_cast<double>(end - begin) / width;
+    int level = -1;
+    while (level + 1 < index.getNumLevels()
+        && static_cast<double>(index.getPointsPerEntry(level + 1)) * 2.0 <= pointsPerColumn)
+        ++level;
+
+    if (level < 0) {
+        for (size_t i = begin; i < end; ++i) {
+            auto value = static_cast<float>(points[i].second);
+            add(points[i].first, { value, value, value, value });
+        }
+    }
+    else {
+        const auto& entries = index.getLevel(level);
+        size_t pointsPerEntry = index.getPointsPerEntry(level);
+        for (size_t entry = begin / pointsPerEntry; entry <= (end - 1) / pointsPerEntry; ++entry)
+            add(points[entry * pointsPerEntry].first, entries[entry]);
+    }
+
+    return columns;
+}
+
+void MultiFeatureDisplay::drawFeature(juce::Graphics& g, const juce::Rectangle<int>& area, const Track& track,
+    bool highlighted) {
+
+    const auto& points = *track.points;
+    auto* index = getIndex(track);
+    if (index == nullptr || points.empty() || area.getWidth() <= 0 || area.getHeight() <= 0) return;
+
+    // The visible points plus one either side, so lines run off the edges.
+    auto [begin, end] = index->findRange(viewStartTime, viewEndTime);
+    if (begin > 0) --begin;
+    if (end < points.size()) ++end;
+    if (begin >= end) return;
+
+    double span = viewEndTime - viewStartTime;
+    float range = track.maxValue - track.minValue;
+    auto toX = [&](double time) { return static_cast<float>(area.getX() + (time - viewStartTime) / span * area.getWidth()); };
+    auto toY = [&](float value) { return area.getBottom() - (value - track.minValue) / range * area.getHeight(); };
+    float baseline = toY(juce::jlimit(track.minValue, track.maxValue, 0.0f));
+
+    g.setColour(track.colour.withAlpha(highlighted || layout == Layout::stacked ? 0.95f : 0.7f));
+    float thickness = highlighted ? 1.5f : 1.0f;
+
+    // Zoomed in, every point is drawn; otherwise one min/max bar per column.
+    if (end - begin <= static_cast<size_t>(area.getWidth()) * 2) {
+        if (track.events) {
+            for (size_t i = begin; i < end; ++i) {
+                float x = toX(points[i].first);
+                float y = toY(static_cast<float>(points[i].second));
+                g.drawLine(x, baseline, x, y, thickness);
+                g.fillEllipse(x - 2.0f, y - 2.0f, 4.0f, 4.0f);
+            }
+            return;
+        }
+
+        juce::Path path;
+        path.startNewSubPath(toX(points[begin].first), toY(static_cast<float>(points[begin].second)));
+        for (size_t i = begin + 1; i < end; ++i)
+            path.lineTo(toX(points[i].first), toY(static_cast<float>(points[i].second)));
+        g.strokePath(path, juce::PathStrokeType(thickness));
+        return;
+    }
+
+    auto columns = computeColumns(track, *index, begin, end, area.getWidth());
+
+    if (track.events) {
+        for (size_t x = 0; x < columns.size(); ++x) {
+            if (!columns[x].isEmpty())
+                g.drawVerticalLine(area.getX() + static_cast<int>(x), toY(columns[x].maxValue), baseline);
+        }
+        return;
+    }
+
+    juce::Path path;
+    bool started = false;
+    for (size_t x = 0; x < columns.size(); ++x) {
+        const auto& column = columns[x];
+        if (column.isEmpty()) continue;
+
+        float px = static_cast<float>(area.getX() + static_cast<int>(x)) + 0.5f;
+        if (!started) {
+            path.startNewSubPath(px, toY(column.first));
+            started = true;
+        }
+        else {
+            path.lineTo(px, toY(column.first));
+        }
+        path.lineTo(px, toY(column.minValue));
+        path.lineTo(px, toY(column.maxValue));
+        path.lineTo(px, toY(column.last));
+    }
+    g.strokePath(path, juce::PathStrokeType(thickness));
+}
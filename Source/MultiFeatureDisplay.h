@@ -1,39 +1,137 @@
+// MultiFeatureDisplay.h
 #pragma once
 #include <JuceHeader.h>
+#include "FeatureExtractors.h"
+#include "BreakpointIndex.h"
 
-class MultiFeatureDisplay : public juce::Component {
+// Every output of every extracted feature on one time axis, either stacked in
+// lanes or overlaid. The breakpoints are read in place from the map handed to
+// setFeatures, so it must outlive the display and only change on the message
+// thread. Its owner reports changes through the revision source, which is
+// checked before every read, or by calling featuresChanged().
+//
+// Only the visible time range is drawn, reduced to a min/max per pixel
+// column. Zoomed out, the columns are built from the block summaries of each
+// track's BreakpointIndex rather than from the points themselves. The
+// indexes can come from the map's owner (setIndexSource), so an edit only
+// re-indexes the track it changed.
+class MultiFeatureDisplay : public juce::Component,
+    private juce::Timer {
 public:
+    using FeatureMap = std::map<juce::String, std::vector<BreakpointList>>;
+
+    enum class Layout { stacked, overlaid };
+
     MultiFeatureDisplay();
     ~MultiFeatureDisplay() override = default;
 
     void paint(juce::Graphics& g) override;
     void resized() override;
 
-    void setFeatures(const std::map<juce::String,
-        std::vector<std::vector<std::pair<double, double>>>>&features);
+    // Wheel zooms around the pointer, horizontal wheel and drag pan,
+    // double-click shows everything and a click selects a lane.
+    void mouseDown(const juce::MouseEvent& event) override;
+    void mouseDrag(const juce::MouseEvent& event) override;
+    void mouseUp(const juce::MouseEvent& event) override;
+    void mouseDoubleClick(const juce::MouseEvent& event) override;
+    void mouseWheelMove(const juce::MouseEvent& event, const juce::MouseWheelDetails& wheel) override;
+    void mouseMagnify(const juce::MouseEvent& event, float scaleFactor) override;
+
+    void setFeatures(const FeatureMap* features);
+    void featuresChanged();
+
+    // Looked up on every paint, so the source may drop and rebuild an index
+    // whenever its track changes. Without one, or where it has none, the
+    // display indexes the tracks itself each time the features change.
+    using IndexSource = std::function<const BreakpointIndex*(const juce::String& feature, int outputIndex)>;
+    void setIndexSource(IndexSource source);
+    // Any change to the map must move the revision, or the display would
+    // read tracks that have been replaced.
+    using RevisionSource = std::function<juce::uint32()>;
+    void setRevisionSource(RevisionSource source);
     void setActiveFeature(const juce::String& feature, int outputIndex = 0);
     void setShowAllFeatures(bool showAll);
+    void setLayout(Layout newLayout);
+    Layout getLayout() const { return layout; }
+
+    // Length of the material; the view can pan up to it or the last
+    // breakpoint, whichever is later.
+    void setDuration(double seconds);
     void setTimeRange(double startTime, double endTime);
+    double getViewStartTime() const { return viewStartTime; }
+    double getViewEndTime() const { return viewEndTime; }
+
+    // Called when a lane is clicked.
+    std::function<void(const juce::String& feature, int outputIndex)> onTrackSelected;
+
+    static constexpr double minimumSpan = 0.005;
 
 private:
+    struct Track {
+        juce::String feature;
+        int output = 0;
+        juce::String label;
+        juce::Colour colour;
+        bool events = false;
+        const BreakpointList* points = nullptr;
+        std::unique_ptr<BreakpointIndex> ownIndex; // when the index source has none
+        float minValue = 0.0f;
+        float maxValue = 1.0f;
+    };
+
+    // Values of the points one pixel column covers.
+    using Column = BreakpointIndex::Summary;
+
+    // Names and colours per feature, looked up once.
     struct FeatureInfo {
-        juce::Colour color;
-        std::vector<std::pair<double, double>> points;
-        juce::String name;
+        juce::Colour colour;
+        juce::StringArray outputNames;
+        bool events = false;
     };
 
-    std::map<juce::String, FeatureInfo> features;
+    const FeatureMap* features = nullptr;
+    IndexSource indexSource;
+    RevisionSource revisionSource;
+    juce::uint32 tracksRevision = 0;
+    std::map<juce::String, FeatureInfo> featureInfo;
+    std::vector<Track> tracks;
+    bool tracksDirty = true;
+
     juce::String activeFeature;
     int activeOutput = 0;
-    bool showAllFeatures = false;
+    bool showAllFeatures = true;
+    Layout layout = Layout::stacked;
+
+    double duration = 0.0;
     double viewStartTime = 0.0;
     double viewEndTime = 5.0; // 5 second default view
+    double targetStartTime = 0.0;
+    double targetEndTime = 5.0;
+
+    juce::Point<float> dragStart;
+    double dragStartTime = 0.0;
+    bool dragMoved = false;
+
+    void timerCallback() override;
+
+    void updateTracks();
+    void rebuildTracks();
+    const BreakpointIndex* getIndex(const Track& track) const;
+    void setValueRange(Track& track) const;
+    std::vector<const Track*> getVisibleTracks() const;
+    double getTotalDuration();
+    void zoomAround(double time, double factor);
+    void panBy(double seconds);
+    void moveTo(double startTime, double endTime, bool animate);
 
     juce::Rectangle<int> getGraphArea() const;
+    juce::Rectangle<int> getLaneArea(const juce::Rectangle<int>& area, int lane, int numLanes) const;
     void drawGrid(juce::Graphics& g, const juce::Rectangle<int>& area);
-    void drawFeature(juce::Graphics& g, const juce::Rectangle<int>& area,
-        const FeatureInfo& feature);
+    void drawFeature(juce::Graphics& g, const juce::Rectangle<int>& area, const Track& track,
+        bool highlighted);
     void drawAllFeatures(juce::Graphics& g, const juce::Rectangle<int>& area);
+    std::vector<Column> computeColumns(const Track& track, const BreakpointIndex& index,
+        size_t begin, size_t end, int width) const;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MultiFeatureDisplay)
-};
\ No newline at end of file
+};
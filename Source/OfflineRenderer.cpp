@@ -0,0 +1,232 @@
+// OfflineRenderer.cpp
+
+#include "OfflineRenderer.h"
+#include "BreakpointPlayer.h"
+#include "EnvelopeApplicator.h"
+#include "TraceRecorder.h"
+
+namespace {
+
+constexpr double warmupSeconds = 0.1;
+constexpr int processingBlockSize = 1 << 16;
+constexpr int filterControlInterval = 32;
+
+struct Segment {
+    juce::int64 start = 0;
+    int length = 0;
+    juce::AudioBuffer<float> audio;
+    juce::WaitableEvent done;
+    bool ok = false;
+};
+
+// Topology-preserving-transform state variable lowpass (Q = 1/sqrt 2),
+// retuned once per control interval.
+class ModulatedLowpass {
+public:
+    void setCutoff(double cutoffHz, double sampleRate) {
+        double g = std::tan(juce::MathConstants<double>::pi * cutoffHz / sampleRate);
+        double k = juce::MathConstants<double>::sqrt2;
+        a1 = static_cast<float>(1.0 / (1.0 + g * (g + k)));
+        a2 = static_cast<float>(g) * a1;
+        a3 = static_cast<float>(g) * a2;
+    }
+
+    void process(float* data, int numSamples) {
+        for (int i = 0; i < numSamples; ++i) {
+            float v3 = data[i] - ic2;
+            float v1 = a1 * ic1 + a2 * v3;
+            float v2 = ic2 + a2 * ic1 + a3 * v3;
+            ic1 = 2.0f * v1 - ic1;
+            ic2 = 2.0f * v2 - ic2;
+            data[i] = v2;
+        }
+    }
+
+private:
+    float a1 = 1.0f, a2 = 0.0f, a3 = 0.0f;
+    float ic1 = 0.0f, ic2 = 0.0f;
+};
+
+void applyFilter(juce::AudioBuffer<float>& audio, double sampleRate, double startTime,
+    const EnvelopeTrack& track, float depth, const OfflineRenderer::Options& options) {
+
+    int numSamples = audio.getNumSamples();
+    int numChannels = audio.getNumChannels();
+
+    BreakpointPlayer player;
+    player.prepare(sampleRate);
+    player.setControlInterval(filterControlInterval);
+    player.setTrack(std::make_unique<EnvelopeTrack>(track));
+
+    std::vector<float> envelope(static_cast<size_t>(numSamples));
+    if (!player.render(envelope.data(), numSamples, startTime)) return;
+
+    std::vector<ModulatedLowpass> filters(static_cast<size_t>(numChannels));
+    double nyquistLimit = sampleRate * 0.49;
+    double range = options.maxCutoffHz / options.minCutoffHz;
+
+    for (int i = 0; i < numSamples; i += filterControlInterval) {
+        int run = juce::jmin(filterControlInterval, numSamples - i);
+
+        double position = juce::jlimit(0.0, 1.0, 1.0 - depth * (1.0 - envelope[static_cast<size_t>(i)]));
+        double cutoff = juce::jmin(nyquistLimit, options.minCutoffHz * std::pow(range, position));
+
+        for (int ch = 0; ch < numChannels; ++ch) {
+            auto& filter = filters[static_cast<size_t>(ch)];
+            filter.setCutoff(cutoff, sampleRate);
+            filter.process(audio.getWritePointer(ch, i), run);
+        }
+    }
+}
+
+bool processSegment(const juce::File& source, Segment& segment, double sampleRate, int numChannels,
+    const std::vector<OfflineRenderer::Modulation>& modulations,
+    const std::vector<std::unique_ptr<EnvelopeTrack>>& tracks,
+    const OfflineRenderer::Options& options) {
+
+    TraceRecorder::Scope trace("render segment");
+
+    // Readers aren't thread-safe, so every segment opens its own.
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(source));
+    if (reader == nullptr) return false;
+
+    auto warmup = juce::jmin(segment.start, static_cast<juce::int64>(sampleRate * warmupSeconds));
+    auto readStart = segment.start - warmup;
+    int total = static_cast<int>(warmup) + segment.length;
+
+    juce::AudioBuffer<float> audio(numChannels, total);
+    if (!reader->read(&audio, 0, total, readStart, true, true)) return false;
+
+    double startTime = static_cast<double>(readStart) / sampleRate;
+
+    for (size_t m = 0; m < modulations.size(); ++m) {
+        const auto& modulation = modulations[m];
+
+        if (modulation.target == OfflineRenderer::Target::filterCutoff) {
+            applyFilter(audio, sampleRate, startTime, *tracks[m], modulation.depth, options);
+            continue;
+        }
+
+        EnvelopeApplicator applicator;
+        applicator.prepare(sampleRate, processingBlockSize);
+        applicator.setTrack(std::make_unique<EnvelopeTrack>(*tracks[m]));
+
+        EnvelopeApplicator::Parameters parameters;
+        parameters.mode = modulation.target == OfflineRenderer::Target::pan
+            ? EnvelopeApplicator::Mode::pan : EnvelopeApplicator::Mode::gain;
+        parameters.depth = modulation.depth;
+        applicator.process(audio, numChannels, startTime, parameters);
+    }
+
+    segment.audio.setSize(numChannels, segment.length);
+    for (int ch = 0; ch < numChannels; ++ch)
+        segment.audio.copyFrom(ch, 0, audio, ch, static_cast<int>(warmup), segment.length);
+    return true;
+}
+
+int chooseBitDepth(juce::AudioFormat& format, int sourceBits) {
+    auto depths = format.getPossibleBitDepths();
+    if (depths.contains(sourceBits) || depths.isEmpty()) return sourceBits;
+
+    int best = depths.getFirst();
+    for (int bits : depths)
+        best = juce::jmax(best, bits);
+    return best;
+}
+
+} // namespace
+
+juce::Result OfflineRenderer::render(const juce::File& source, const juce::File& destination,
+    const std::vector<Modulation>& modulations, const Options& options,
+    std::function<bool(float)> progressCallback) {
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(source));
+    if (reader == nullptr)
+        return juce::Result::fail("Can't read " + source.getFileName());
+
+    auto* format = formatManager.findFormatForFileExtension(destination.getFileExtension());
+    if (format == nullptr)
+        return juce::Result::fail("Unsupported output format: " + destination.getFileExtension());
+
+    double sampleRate = reader->sampleRate;
+    int numChannels = static_cast<int>(reader->numChannels);
+    juce::int64 lengthInSamples = reader->lengthInSamples;
+
+    juce::TemporaryFile temp(destination);
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+    {
+        auto stream = std::make_unique<juce::FileOutputStream>(temp.getFile());
+        if (!stream->openedOk())
+            return juce::Result::fail("Can't write " + destination.getFileName());
+
+        writer.reset(format->createWriterFor(stream.get(), sampleRate,
+            static_cast<unsigned int>(numChannels),
+            chooseBitDepth(*format, static_cast<int>(reader->bitsPerSample)),
+            reader->metadataValues, 0));
+        if (writer != nullptr)
+            stream.release();
+    }
+    if (writer == nullptr)
+        return juce::Result::fail("Can't create a " + format->getFormatName() + " writer");
+
+    std::vector<std::unique_ptr<EnvelopeTrack>> tracks;
+    for (const auto& modulation : modulations)
+        tracks.push_back(modulation.events ? EnvelopeTrack::fromEvents(modulation.points)
+            : EnvelopeTrack::fromBreakpoints(modulation.points));
+
+    auto segmentLength = juce::jmax<juce::int64>(1, static_cast<juce::int64>(sampleRate * options.segmentSeconds));
+    std::vector<std::unique_ptr<Segment>> segments;
+    for (juce::int64 start = 0; start < lengthInSamples; start += segmentLength) {
+        auto segment = std::make_unique<Segment>();
+        segment->start = start;
+        segment->length = static_cast<int>(juce::jmin(segmentLength, lengthInSamples - start));
+        segments.push_back(std::move(segment));
+    }
+
+    int numThreads = options.numThreads > 0 ? options.numThreads : juce::SystemStats::getNumCpus();
+
+    // Declared after everything its jobs refer to, so it is destroyed (and
+    // waits for them) first.
+    juce::ThreadPool pool(numThreads);
+
+    // Bounds memory to a few segments per thread however long the file is.
+    size_t maxInFlight = static_cast<size_t>(numThreads) * 2;
+    size_t nextToSchedule = 0;
+
+    for (size_t i = 0; i < segments.size(); ++i) {
+        while (nextToSchedule < segments.size() && nextToSchedule < i + maxInFlight) {
+            auto* segment = segments[nextToSchedule++].get();
+            pool.addJob([&, segment] {
+                segment->ok = processSegment(source, *segment, sampleRate, numChannels,
+                    modulations, tracks, options);
+                segment->done.signal();
+            });
+        }
+
+        auto& segment = *segments[i];
+        segment.done.wait();
+
+        if (!segment.ok)
+            return juce::Result::fail("Failed to read " + source.getFileName());
+        if (!writer->writeFromAudioSampleBuffer(segment.audio, 0, segment.length))
+            return juce::Result::fail("Failed to write " + destination.getFileName());
+
+        segment.audio.setSize(0, 0);
+
+        if (progressCallback != nullptr
+            && !progressCallback(static_cast<float>(i + 1) / static_cast<float>(segments.size())))
+            return juce::Result::fail("Render cancelled");
+    }
+
+    writer.reset();
+
+    if (!temp.overwriteTargetFileWithTemporary())
+        return juce::Result::fail("Can't replace " + destination.getFileName());
+
+    return juce::Result::ok();
+}
@@ -0,0 +1,42 @@
+// OfflineRenderer.h
+#pragma once
+
+#include <JuceHeader.h>
+#include "FeatureExtractors.h"
+
+// Applies breakpoint tracks to an audio file and writes the result, faster
+// than real time.
+//
+// The source is cut into segments that are read, processed and encoded
+// independently on a thread pool; the calling thread writes them out in
+// order as they complete. Each segment starts a little early and discards
+// that warm-up so filter state and pan ramps are settled at its first
+// sample, which makes the output independent of how it was split.
+class OfflineRenderer {
+public:
+    enum class Target { gain, pan, filterCutoff };
+
+    struct Modulation {
+        Target target = Target::gain;
+        BreakpointList points;
+        // Gain and pan scale as in mirror mode. For the filter, depth 0
+        // leaves it fully open and 1 sweeps the whole cutoff range.
+        float depth = 1.0f;
+        // The points are events, applied as pulses (EnvelopeTrack::fromEvents).
+        bool events = false;
+    };
+
+    struct Options {
+        double segmentSeconds = 5.0;
+        int numThreads = 0; // 0 uses every core
+        float minCutoffHz = 40.0f;
+        float maxCutoffHz = 18000.0f;
+    };
+
+    // Modulations are applied in order. The output format follows the
+    // destination's extension. The callback gets the fraction written after
+    // each segment; returning false cancels, leaving the destination as it was.
+    static juce::Result render(const juce::File& source, const juce::File& destination,
+        const std::vector<Modulation>& modulations, const Options& options,
+        std::function<bool(float)> progressCallback = nullptr);
+};
@@ -4,6 +4,37 @@
 #include "PluginEditor.h"
 #include "PluginProcessor.h"
 #include "FeatureExtractors.h"
+#include "TraceRecorder.h"
+
+// Renders on its own thread behind a progress window with a cancel button,
+// and deletes itself when done. The editor may close meanwhile.
+class AudioDeconstructorEditor::RenderJob : public juce::ThreadWithProgressWindow {
+public:
+    RenderJob(AudioDeconstructorEditor& editor, const juce::File& source, const juce::File& destination,
+        OfflineRenderer::Modulation modulation)
+        : juce::ThreadWithProgressWindow("Rendering " + destination.getFileName(), true, true),
+        editor(&editor), source(source), destination(destination), modulation(std::move(modulation)) {}
+
+    void run() override {
+        result = OfflineRenderer::render(source, destination, { modulation }, OfflineRenderer::Options(),
+            [this](float progress) {
+                setProgress(progress);
+                return !threadShouldExit();
+            });
+    }
+
+    void threadComplete(bool) override {
+        if (editor != nullptr)
+            editor->renderFinished(result, destination);
+        delete this;
+    }
+
+private:
+    juce::Component::SafePointer<AudioDeconstructorEditor> editor;
+    juce::File source, destination;
+    OfflineRenderer::Modulation modulation;
+    juce::Result result = juce::Result::ok();
+};
 
 AudioDeconstructorEditor::AudioDeconstructorEditor(AudioDeconstructorProcessor& p)
     : AudioProcessorEditor(&p), processor(p) {
@@ -28,6 +59,42 @@ AudioDeconstructorEditor::AudioDeconstructorEditor(AudioDeconstructorProcessor&
     clearButton.addListener(this);
     addAndMakeVisible(clearButton);
 
+    liveButton.setButtonText("Live");
+    liveButton.setClickingTogglesState(true);
+    liveButton.setToggleState(processor.isLiveCapturing(), juce::dontSendNotification);
+    liveButton.addListener(this);
+    addAndMakeVisible(liveButton);
+
+    renderButton.setButtonText("Render");
+    renderButton.addListener(this);
+    addAndMakeVisible(renderButton);
+
+    statsButton.setButtonText("Stats");
+    statsButton.setClickingTogglesState(true);
+    statsButton.setToggleState(processor.isProfilingEnabled(), juce::dontSendNotification);
+    statsButton.addListener(this);
+    addAndMakeVisible(statsButton);
+
+    traceButton.setButtonText("Trace");
+    traceButton.setClickingTogglesState(true);
+    traceButton.setToggleState(TraceRecorder::isRecording(), juce::dontSendNotification);
+    traceButton.addListener(this);
+    addAndMakeVisible(traceButton);
+
+    shareButton.setButtonText("Share");
+    shareButton.setClickingTogglesState(true);
+    shareButton.setToggleState(processor.isFeatureBusEnabled(), juce::dontSendNotification);
+    shareButton.addListener(this);
+    addAndMakeVisible(shareButton);
+
+    rangeButton.setButtonText("Range");
+    rangeButton.addListener(this);
+    addAndMakeVisible(rangeButton);
+
+    sessionSelector.setTextWhenNothingSelected("Drop several files to queue them");
+    sessionSelector.addListener(this);
+    addAndMakeVisible(sessionSelector);
+
     featureLabel.setText("Feature:", juce::dontSendNotification);
     addAndMakeVisible(featureLabel);
 
@@ -40,6 +107,11 @@ AudioDeconstructorEditor::AudioDeconstructorEditor(AudioDeconstructorProcessor&
     outputSelector.addListener(this);
     addAndMakeVisible(outputSelector);
 
+    envelopeOutToggle.setButtonText("Envelope Out");
+    envelopeOutToggle.setToggleState(processor.getPlaybackFeature().isNotEmpty(), juce::dontSendNotification);
+    envelopeOutToggle.addListener(this);
+    addAndMakeVisible(envelopeOutToggle);
+
     windowSizeSlider.setRange(1.0, 100.0, 0.1);
     windowSizeSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 60, 24);
     windowSizeSlider.setSliderStyle(juce::Slider::LinearHorizontal);
@@ -53,6 +125,26 @@ AudioDeconstructorEditor::AudioDeconstructorEditor(AudioDeconstructorProcessor&
     normalizeToggle.setButtonText("Normalize");
     addAndMakeVisible(normalizeToggle);
 
+    decimateToggle.setButtonText("Decimate");
+    addAndMakeVisible(decimateToggle);
+
+    mirrorModeSelector.addItemList({ "Mirror Off", "Mirror Gain", "Mirror Pan" }, 1);
+    addAndMakeVisible(mirrorModeSelector);
+
+    mirrorDepthSlider.setRange(0.0, 1.0, 0.01);
+    mirrorDepthSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 40, 24);
+    mirrorDepthSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    addAndMakeVisible(mirrorDepthSlider);
+
+    windowSizeAttachment = std::make_unique<SliderAttachment>(processor.params, "windowSize", windowSizeSlider);
+    hopSizeAttachment = std::make_unique<SliderAttachment>(processor.params, "hopSize", hopSizeSlider);
+    normalizeAttachment = std::make_unique<ButtonAttachment>(processor.params, "normalize", normalizeToggle);
+    decimateAttachment = std::make_unique<ButtonAttachment>(processor.params, "decimate", decimateToggle);
+    mirrorModeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        processor.params, "mirrorMode", mirrorModeSelector);
+    mirrorDepthAttachment = std::make_unique<SliderAttachment>(processor.params, "mirrorDepth", mirrorDepthSlider);
+    mirrorModeSelector.addListener(this);
+
     infoLabel.setText("Load an audio file or drag & drop here", juce::dontSendNotification);
     infoLabel.setJustificationType(juce::Justification::centred);
     addAndMakeVisible(infoLabel);
@@ -61,9 +153,52 @@ AudioDeconstructorEditor::AudioDeconstructorEditor(AudioDeconstructorProcessor&
     statusLabel.setJustificationType(juce::Justification::centred);
     addAndMakeVisible(statusLabel);
 
+    statsView.setMultiLine(true);
+    statsView.setReadOnly(true);
+    statsView.setCaretVisible(false);
+    statsView.setFont(juce::FontOptions(juce::Font::getDefaultMonospacedFontName(), 12.0f, juce::Font::plain));
+    statsView.setColour(juce::TextEditor::backgroundColourId, juce::Colour(0xe0101010));
+    addChildComponent(statsView);
+
+    for (int i = 0; i < static_cast<int>(std::size(budgetChoices)); ++i) {
+        budgetSelector.addItem(budgetChoices[i] == MemoryBudget::unlimited ? juce::String("No memory limit")
+            : "Memory limit " + MemoryBudget::formatBytes(budgetChoices[i]), i + 1);
+        if (budgetChoices[i] == processor.getMemoryBudget())
+            budgetSelector.setSelectedId(i + 1, juce::dontSendNotification);
+    }
+    budgetSelector.addListener(this);
+    addChildComponent(budgetSelector);
+    if (processor.isProfilingEnabled())
+        toggleStats();
+
+    overview.setFeatures(&processor.getAllBreakpoints());
+    // Shares the processor's indexes, which it drops per edited feature.
+    overview.setIndexSource([this](const juce::String& featureName, int outputIndex) {
+        return processor.getTrackIndex(featureName, outputIndex);
+    });
+    // Restores or replacements of the tracks move the revision, which the
+    // overview checks before reading them.
+    overview.setRevisionSource([this] { return processor.getBreakpointRevision(); });
+    overview.onTrackSelected = [this](const juce::String& featureName, int outputIndex) {
+        selectTrack(featureName, outputIndex);
+    };
+    addAndMakeVisible(overview);
+
     updateFeatureSelector();
+    // Reopens on the track the plugin was mirroring and playing.
+    auto mirrored = processor.getMirrorFeature();
+    if (mirrored.isNotEmpty() && processor.getAvailableFeatures().contains(mirrored))
+        selectTrack(mirrored, processor.getMirrorOutput());
+    else
+        updatePlaybackTrack();
+
+    if (!processor.hasLoadedAudio() && !processor.getExtractedFeatures().isEmpty()) {
+        infoLabel.setText("Restored: " + processor.getLoadedFileName(),
+            juce::dontSendNotification);
+    }
 
-    setSize(800, 700);
+    setWantsKeyboardFocus(true);
+    setSize(800, 820);
     startTimerHz(30);
 }
 
@@ -72,6 +207,7 @@ AudioDeconstructorEditor::~AudioDeconstructorEditor() {
 }
 
 void AudioDeconstructorEditor::paint(juce::Graphics& g) {
+    TraceRecorder::Scope trace("paint");
     g.fillAll(juce::Colour(0xff1e1e1e));
 
     g.setColour(juce::Colours::white);
@@ -87,6 +223,21 @@ void AudioDeconstructorEditor::paint(juce::Graphics& g) {
     }
 
     drawWaveform(g, graphBounds);
+    drawSelection(g, graphBounds);
+}
+
+void AudioDeconstructorEditor::drawSelection(juce::Graphics& g, const juce::Rectangle<int>& area) {
+    if (selectionEnd == selectionStart) return;
+
+    float left = timeValueToScreen(static_cast<float>(juce::jmin(selectionStart, selectionEnd)), 0.0f).x;
+    float right = timeValueToScreen(static_cast<float>(juce::jmax(selectionStart, selectionEnd)), 0.0f).x;
+    auto selection = juce::Rectangle<float>(left, static_cast<float>(area.getY()), right - left,
+        static_cast<float>(area.getHeight())).getIntersection(area.toFloat());
+
+    g.setColour(juce::Colours::white.withAlpha(0.12f));
+    g.fillRect(selection);
+    g.setColour(juce::Colours::white.withAlpha(0.4f));
+    g.drawRect(selection, 1.0f);
 }
 
 void AudioDeconstructorEditor::drawGraphBackground(juce::Graphics& g,
@@ -197,6 +348,7 @@ void AudioDeconstructorEditor::drawWaveform(juce::Graphics& g,
 void AudioDeconstructorEditor::resized() {
     auto area = getLocalBounds();
     auto header = area.removeFromTop(40);
+    sessionSelector.setBounds(header.reduced(10, 8).removeFromRight(220));
 
     graphBounds = area.removeFromTop(300).reduced(10, 10);
 
@@ -210,6 +362,16 @@ void AudioDeconstructorEditor::resized() {
     saveAllButton.setBounds(controlRow1.removeFromLeft(80));
     controlRow1.removeFromLeft(5);
     clearButton.setBounds(controlRow1.removeFromLeft(70));
+    controlRow1.removeFromLeft(10);
+    liveButton.setBounds(controlRow1.removeFromLeft(70));
+    controlRow1.removeFromLeft(5);
+    renderButton.setBounds(controlRow1.removeFromLeft(70));
+    controlRow1.removeFromLeft(5);
+    statsButton.setBounds(controlRow1.removeFromLeft(60));
+    controlRow1.removeFromLeft(5);
+    traceButton.setBounds(controlRow1.removeFromLeft(60));
+    controlRow1.removeFromLeft(5);
+    shareButton.setBounds(controlRow1.removeFromLeft(65));
 
     auto controlRow2 = area.removeFromTop(40).reduced(10, 5);
     featureLabel.setBounds(controlRow2.removeFromLeft(60));
@@ -219,6 +381,12 @@ void AudioDeconstructorEditor::resized() {
     outputLabel.setBounds(controlRow2.removeFromLeft(60));
     controlRow2.removeFromLeft(5);
     outputSelector.setBounds(controlRow2.removeFromLeft(140));
+    controlRow2.removeFromLeft(15);
+    envelopeOutToggle.setBounds(controlRow2.removeFromLeft(120));
+    controlRow2.removeFromLeft(15);
+    decimateToggle.setBounds(controlRow2.removeFromLeft(100));
+    controlRow2.removeFromLeft(5);
+    rangeButton.setBounds(controlRow2.removeFromLeft(70));
 
     auto controlRow3 = area.removeFromTop(40).reduced(10, 5);
     windowSizeSlider.setBounds(controlRow3.removeFromLeft(200));
@@ -226,14 +394,44 @@ void AudioDeconstructorEditor::resized() {
     hopSizeSlider.setBounds(controlRow3.removeFromLeft(200));
     controlRow3.removeFromLeft(10);
     normalizeToggle.setBounds(controlRow3.removeFromLeft(100));
+    controlRow3.removeFromLeft(5);
+    mirrorModeSelector.setBounds(controlRow3.removeFromLeft(110));
+    controlRow3.removeFromLeft(5);
+    mirrorDepthSlider.setBounds(controlRow3);
 
     auto statusRow = area.removeFromTop(30).reduced(10, 5);
     infoLabel.setBounds(statusRow.removeFromLeft(400));
     statusLabel.setBounds(statusRow);
+
+    overview.setBounds(area.reduced(10, 5));
+
+    statsView.setBounds(graphBounds.reduced(20));
+    budgetSelector.setBounds(statsView.getBounds().reduced(6).removeFromTop(24).removeFromRight(180));
 }
 
 void AudioDeconstructorEditor::timerCallback() {
+    if (processor.isLiveCapturing()) {
+        processor.collectLiveBreakpoints();
+        statusLabel.setText("Capturing: " + juce::String(processor.getLiveCaptureSeconds(), 1) + "s",
+            juce::dontSendNotification);
+    }
+
+    if (processor.getSession().getRevision() != sessionRevision)
+        updateSessionSelector();
+    if (processor.collectSessionFeatures()) {
+        statusLabel.setText("Analysed: " + processor.getLoadedFileName(), juce::dontSendNotification);
+        updateFeatureSelector();
+    }
+
     updateDisplay();
+
+    // Refreshed a few times a second; rebuilding the text every frame would
+    // show up in the stats themselves.
+    if (statsView.isVisible() && --statsRefreshCountdown <= 0) {
+        updateStats();
+        statsRefreshCountdown = 8;
+    }
+
     repaint();
 }
 
@@ -241,7 +439,7 @@ bool AudioDeconstructorEditor::isInterestedInFileDrag(const juce::StringArray& f
     for (const auto& file : files) {
         if (file.endsWithIgnoreCase(".wav") || file.endsWithIgnoreCase(".aif") ||
             file.endsWithIgnoreCase(".aiff") || file.endsWithIgnoreCase(".mp3") ||
-            file.endsWithIgnoreCase(".flac")) {
+            file.endsWithIgnoreCase(".flac") || file.endsWithIgnoreCase(".adbp")) {
             return true;
         }
     }
@@ -249,32 +447,102 @@ bool AudioDeconstructorEditor::isInterestedInFileDrag(const juce::StringArray& f
 }
 
 void AudioDeconstructorEditor::filesDropped(const juce::StringArray& files, int, int) {
+    juce::Array<juce::File> audioFiles;
     for (const auto& file : files) {
-        if (file.endsWithIgnoreCase(".wav") || file.endsWithIgnoreCase(".aif") ||
-            file.endsWithIgnoreCase(".aiff") || file.endsWithIgnoreCase(".mp3") ||
-            file.endsWithIgnoreCase(".flac")) {
-            if (processor.loadAudioFile(juce::File(file))) {
-                infoLabel.setText("Loaded: " + juce::File(file).getFileName(),
-                    juce::dontSendNotification);
-                statusLabel.setText("Ready to extract features", juce::dontSendNotification);
+        if (file.endsWithIgnoreCase(".adbp")) {
+            auto result = processor.loadCompressedBreakpoints(juce::File(file));
+            statusLabel.setText(result.wasOk() ? "Loaded: " + juce::File(file).getFileName()
+                : result.getErrorMessage(), juce::dontSendNotification);
+            if (result.wasOk()) {
                 updateFeatureSelector();
-                repaint();
+                updateDisplay();
             }
-            break;
+        }
+        else if (file.endsWithIgnoreCase(".wav") || file.endsWithIgnoreCase(".aif") ||
+            file.endsWithIgnoreCase(".aiff") || file.endsWithIgnoreCase(".mp3") ||
+            file.endsWithIgnoreCase(".flac")) {
+            audioFiles.add(juce::File(file));
         }
     }
+
+    if (audioFiles.size() > 1) {
+        int numQueued = processor.queueFiles(audioFiles);
+        statusLabel.setText("Queued " + juce::String(numQueued) + " files for analysis",
+            juce::dontSendNotification);
+        showLoadedFile();
+        updateSessionSelector();
+    }
+    else if (!audioFiles.isEmpty() && processor.loadAudioFile(audioFiles.getFirst())) {
+        showLoadedFile();
+        statusLabel.setText("Ready to extract features", juce::dontSendNotification);
+    }
+}
+
+void AudioDeconstructorEditor::showLoadedFile() {
+    if (!processor.hasLoadedAudio()) return;
+
+    infoLabel.setText("Loaded: " + processor.getLoadedFile().getFileName(), juce::dontSendNotification);
+    updateFeatureSelector();
+    repaint();
+}
+
+void AudioDeconstructorEditor::updateSessionSelector() {
+    const auto& session = processor.getSession();
+    sessionRevision = session.getRevision();
+    sessionSelector.clear(juce::dontSendNotification);
+
+    for (int i = 0; i < session.getNumFiles(); ++i) {
+        auto entry = session.getEntry(i);
+        auto text = entry.file.getFileName();
+        if (entry.status == AnalysisSession::Status::queued)
+            text << " (queued)";
+        else if (entry.status == AnalysisSession::Status::analysing)
+            text << " (" << entry.numFeaturesDone << "/" << entry.numFeatures << ")";
+        else if (entry.status == AnalysisSession::Status::failed)
+            text << " (failed)";
+        sessionSelector.addItem(text, i + 1);
+    }
+
+    int selected = session.indexOf(processor.getLoadedFile());
+    if (selected >= 0)
+        sessionSelector.setSelectedId(selected + 1, juce::dontSendNotification);
 }
 
 void AudioDeconstructorEditor::comboBoxChanged(juce::ComboBox* combo) {
-    if (combo == &featureSelector) {
+    if (combo == &budgetSelector) {
+        int index = budgetSelector.getSelectedId() - 1;
+        if (juce::isPositiveAndBelow(index, static_cast<int>(std::size(budgetChoices)))) {
+            processor.setMemoryBudget(budgetChoices[index]);
+            updateStats();
+        }
+    }
+    else if (combo == &sessionSelector) {
+        auto entry = processor.getSession().getEntry(sessionSelector.getSelectedId() - 1);
+        if (entry.file != juce::File() && entry.file != processor.getLoadedFile()) {
+            if (processor.selectSessionFile(entry.file)) {
+                showLoadedFile();
+                statusLabel.setText(processor.getExtractedFeatures().isEmpty() ? "Waiting for analysis"
+                    : "Ready", juce::dontSendNotification);
+            }
+            else {
+                statusLabel.setText("Can't read " + entry.file.getFileName(), juce::dontSendNotification);
+            }
+        }
+    }
+    else if (combo == &featureSelector) {
         currentFeature = featureSelector.getText();
         updateOutputSelector();
+        updatePlaybackTrack();
         updateDisplay();
     }
     else if (combo == &outputSelector) {
         currentOutput = outputSelector.getSelectedId() - 1;
+        updatePlaybackTrack();
         updateDisplay();
     }
+    else if (combo == &mirrorModeSelector) {
+        updateMirrorTrack();
+    }
 }
 
 void AudioDeconstructorEditor::buttonClicked(juce::Button* button) {
@@ -293,6 +561,35 @@ void AudioDeconstructorEditor::buttonClicked(juce::Button* button) {
     else if (button == &clearButton) {
         clearAll();
     }
+    else if (button == &liveButton) {
+        toggleLiveCapture();
+    }
+    else if (button == &renderButton) {
+        renderToFile();
+    }
+    else if (button == &statsButton) {
+        toggleStats();
+    }
+    else if (button == &traceButton) {
+        toggleTrace();
+    }
+    else if (button == &shareButton) {
+        bool enable = shareButton.getToggleState();
+        if (processor.setFeatureBusEnabled(enable)) {
+            statusLabel.setText(enable ? "Sharing as " + processor.getFeatureBusName() : "Sharing stopped",
+                juce::dontSendNotification);
+        }
+        else {
+            shareButton.setToggleState(false, juce::dontSendNotification);
+            statusLabel.setText("Can't open the feature bus", juce::dontSendNotification);
+        }
+    }
+    else if (button == &rangeButton) {
+        showRangeMenu();
+    }
+    else if (button == &envelopeOutToggle) {
+        updatePlaybackTrack();
+    }
 }
 
 void AudioDeconstructorEditor::loadAudioFile() {
@@ -347,7 +644,7 @@ void AudioDeconstructorEditor::saveCurrentBreakpoints() {
         "Save Breakpoint File",
         juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
         .getChildFile(processor.getLoadedFileName() + "_" + currentFeature + ".txt"),
-        "*.txt"
+        "*.txt;*.adbp;*.adcr"
     );
 
     auto browserFlags = juce::FileBrowserComponent::saveMode |
@@ -356,12 +653,61 @@ void AudioDeconstructorEditor::saveCurrentBreakpoints() {
     fileChooser->launchAsync(browserFlags, [this](const juce::FileChooser& chooser) {
         auto result = chooser.getResult();
         if (result.getFullPathName().isNotEmpty()) {
-            processor.saveBreakpoints(currentFeature, result);
+            if (result.hasFileExtension("adbp"))
+                processor.saveCompressedBreakpoints(currentFeature, result);
+            else if (result.hasFileExtension("adcr")) {
+                saveControlRate(result);
+                return;
+            }
+            else
+                processor.saveBreakpoints(currentFeature, result);
             statusLabel.setText("Saved: " + result.getFileName(), juce::dontSendNotification);
         }
         });
 }
 
+void AudioDeconstructorEditor::saveControlRate(const juce::File& file) {
+    auto* window = new juce::AlertWindow("Control-Rate Export",
+        "Resample every output of " + currentFeature + " onto a fixed grid.", juce::MessageBoxIconType::NoIcon);
+
+    juce::StringArray grids;
+    for (auto rate : exportRates)
+        grids.add(juce::String(rate, 0) + " values a second");
+    for (auto blockSize : exportBlockSizes)
+        grids.add("One value per " + juce::String(blockSize) + " samples");
+    window->addComboBox("grid", grids, "Grid");
+    window->getComboBoxComponent("grid")->setSelectedItemIndex(exportGridChoice);
+
+    // Event features are always written as impulses.
+    window->addComboBox("interpolation", { "Linear", "Hold", "Cubic" }, "Interpolation");
+    window->getComboBoxComponent("interpolation")->setSelectedItemIndex(exportInterpolationChoice);
+
+    window->addButton("Save", 1, juce::KeyPress(juce::KeyPress::returnKey));
+    window->addButton("Cancel", 0, juce::KeyPress(juce::KeyPress::escapeKey));
+
+    juce::Component::SafePointer<AudioDeconstructorEditor> safeThis(this);
+    auto featureName = currentFeature;
+    window->enterModalState(true, juce::ModalCallbackFunction::create([safeThis, window, file, featureName](int result) {
+        if (result == 0 || safeThis == nullptr) return;
+
+        safeThis->exportGridChoice = window->getComboBoxComponent("grid")->getSelectedItemIndex();
+        safeThis->exportInterpolationChoice = window->getComboBoxComponent("interpolation")->getSelectedItemIndex();
+
+        constexpr int numRates = static_cast<int>(std::size(exportRates));
+        int choice = juce::jmax(0, safeThis->exportGridChoice);
+        auto grid = choice < numRates ? ControlRateExport::Grid::perSecond(exportRates[choice])
+            : ControlRateExport::Grid::perBlock(exportBlockSizes[juce::jmin(choice - numRates,
+                static_cast<int>(std::size(exportBlockSizes)) - 1)]);
+
+        const ControlRateExport::Interpolation interpolations[] = { ControlRateExport::Interpolation::linear,
+            ControlRateExport::Interpolation::hold, ControlRateExport::Interpolation::cubic };
+        auto interpolation = interpolations[juce::jlimit(0, 2, safeThis->exportInterpolationChoice)];
+
+        safeThis->processor.saveControlRateBreakpoints(featureName, file, grid, interpolation);
+        safeThis->statusLabel.setText("Saved: " + file.getFileName(), juce::dontSendNotification);
+    }), true);
+}
+
 void AudioDeconstructorEditor::saveAllBreakpoints() {
     fileChooser = std::make_unique<juce::FileChooser>(
         "Select Directory to Save All Breakpoints",
@@ -392,15 +738,314 @@ void AudioDeconstructorEditor::clearAll() {
     repaint();
 }
 
+void AudioDeconstructorEditor::toggleLiveCapture() {
+    if (!liveButton.getToggleState()) {
+        processor.stopLiveCapture();
+        statusLabel.setText("Captured " + juce::String(processor.getLiveCaptureSeconds(), 1) + "s",
+            juce::dontSendNotification);
+        updateDisplay();
+        return;
+    }
+
+    if (!processor.startLiveCapture()) {
+        liveButton.setToggleState(false, juce::dontSendNotification);
+        statusLabel.setText("No input to capture", juce::dontSendNotification);
+        return;
+    }
+
+    displayedBreakpoints.clear();
+    infoLabel.setText("Live: " + processor.getLoadedFileName(), juce::dontSendNotification);
+}
+
+void AudioDeconstructorEditor::renderToFile() {
+    if (isRendering) return;
+    if (currentFeature.isEmpty() || !processor.isFeatureExtracted(currentFeature)) {
+        statusLabel.setText("Extract a feature first", juce::dontSendNotification);
+        return;
+    }
+
+    fileChooser = std::make_unique<juce::FileChooser>(
+        "Choose Audio To Process",
+        juce::File::getSpecialLocation(juce::File::userDocumentsDirectory),
+        "*.wav;*.aif;*.aiff;*.flac"
+    );
+
+    auto openFlags = juce::FileBrowserComponent::openMode |
+        juce::FileBrowserComponent::canSelectFiles;
+
+    fileChooser->launchAsync(openFlags, [this](const juce::FileChooser& chooser) {
+        auto source = chooser.getResult();
+        if (!source.existsAsFile()) return;
+
+        fileChooser = std::make_unique<juce::FileChooser>(
+            "Save Rendered Audio",
+            source.getSiblingFile(source.getFileNameWithoutExtension() + "_" + currentFeature + ".wav"),
+            "*.wav;*.aif;*.aiff;*.flac"
+        );
+
+        auto saveFlags = juce::FileBrowserComponent::saveMode |
+            juce::FileBrowserComponent::canSelectFiles;
+
+        fileChooser->launchAsync(saveFlags, [this, source](const juce::FileChooser& saveChooser) {
+            auto destination = saveChooser.getResult();
+            if (destination.getFullPathName().isEmpty()) return;
+
+            // Uses the mirror mode to pick gain or pan.
+            auto target = mirrorModeSelector.getSelectedItemIndex() == 2
+                ? OfflineRenderer::Target::pan : OfflineRenderer::Target::gain;
+
+            OfflineRenderer::Modulation modulation;
+            auto result = processor.makeRenderModulation(currentFeature, currentOutput, target, modulation);
+            if (result.failed()) {
+                statusLabel.setText(result.getErrorMessage(), juce::dontSendNotification);
+                return;
+            }
+
+            isRendering = true;
+            statusLabel.setText("Rendering " + destination.getFileName(), juce::dontSendNotification);
+            (new RenderJob(*this, source, destination, std::move(modulation)))->launchThread();
+            });
+        });
+}
+
+void AudioDeconstructorEditor::renderFinished(const juce::Result& result, const juce::File& destination) {
+    isRendering = false;
+    statusLabel.setText(result.wasOk() ? "Rendered: " + destination.getFileName()
+        : result.getErrorMessage(), juce::dontSendNotification);
+}
+
+void AudioDeconstructorEditor::toggleTrace() {
+    if (traceButton.getToggleState()) {
+        TraceRecorder::start();
+        statusLabel.setText("Tracing...", juce::dontSendNotification);
+        return;
+    }
+
+    TraceRecorder::stop();
+
+    fileChooser = std::make_unique<juce::FileChooser>(
+        "Save Trace",
+        juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("trace.json"),
+        "*.json"
+    );
+
+    auto saveFlags = juce::FileBrowserComponent::saveMode |
+        juce::FileBrowserComponent::canSelectFiles;
+
+    fileChooser->launchAsync(saveFlags, [this](const juce::FileChooser& chooser) {
+        auto file = chooser.getResult();
+        if (file.getFullPathName().isEmpty()) return;
+
+        auto result = TraceRecorder::writeTo(file);
+        auto dropped = TraceRecorder::getNumDroppedEvents();
+
+        juce::String message = result.wasOk() ? "Trace saved: " + file.getFileName()
+            : result.getErrorMessage();
+        if (result.wasOk() && dropped > 0)
+            message << " (" << juce::String(dropped) << " events dropped)";
+        statusLabel.setText(message, juce::dontSendNotification);
+        });
+}
+
+void AudioDeconstructorEditor::showRangeMenu() {
+    if (currentFeature.isEmpty() || !processor.isFeatureExtracted(currentFeature)) {
+        statusLabel.setText("Extract a feature first", juce::dontSendNotification);
+        return;
+    }
+
+    juce::PopupMenu menu;
+    menu.addItem(1, "Scale x0.5");
+    menu.addItem(2, "Scale x2");
+    menu.addItem(3, "Offset +0.1");
+    menu.addItem(4, "Offset -0.1");
+    menu.addItem(5, "Clamp to 0..1");
+    menu.addItem(6, "Invert");
+    menu.addItem(7, "Quantize to 0.1");
+    menu.addSeparator();
+    menu.addItem(8, "Stretch x0.5");
+    menu.addItem(9, "Stretch x2");
+    menu.addItem(10, "Resample to 16 points");
+    menu.addItem(11, "Resample to 128 points");
+    menu.addSeparator();
+    menu.addItem(12, "Find Similar Regions", selectionEnd > selectionStart);
+
+    // Crossfade targets: every other extracted output, numbered from 100.
+    juce::PopupMenu crossfade;
+    int itemId = 100;
+    for (const auto& featureName : processor.getExtractedFeatures()) {
+        for (int output = 0; output < processor.getNumOutputsForFeature(featureName); ++output, ++itemId) {
+            if (featureName != currentFeature || output != currentOutput)
+                crossfade.addItem(itemId, featureName + ": " + processor.getOutputName(featureName, output));
+        }
+    }
+    menu.addSubMenu("Crossfade To", crossfade);
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&rangeButton),
+        [safeThis = juce::Component::SafePointer<AudioDeconstructorEditor>(this)](int result) {
+            if (safeThis == nullptr || result == 0) return;
+            if (result == 12)
+                safeThis->findSimilarRegions();
+            else
+                safeThis->applyRangeEdit(result);
+        });
+}
+
+void AudioDeconstructorEditor::applyRangeEdit(int menuResult) {
+    double start = juce::jmin(selectionStart, selectionEnd);
+    double end = juce::jmax(selectionStart, selectionEnd);
+    if (end <= start) {
+        auto points = processor.getBreakpointsInRange(currentFeature, currentOutput,
+            0.0, std::numeric_limits<double>::max());
+        start = 0.0;
+        end = points.empty() ? 0.0 : points[points.size() - 1].first;
+    }
+
+    bool changed = false;
+    switch (menuResult) {
+    case 1: changed = processor.scaleRange(currentFeature, currentOutput, start, end, 0.5); break;
+    case 2: changed = processor.scaleRange(currentFeature, currentOutput, start, end, 2.0); break;
+    case 3: changed = processor.offsetRange(currentFeature, currentOutput, start, end, 0.1); break;
+    case 4: changed = processor.offsetRange(currentFeature, currentOutput, start, end, -0.1); break;
+    case 5: changed = processor.clampRange(currentFeature, currentOutput, start, end, 0.0, 1.0); break;
+    case 6: changed = processor.invertRange(currentFeature, currentOutput, start, end); break;
+    case 7: changed = processor.quantizeRange(currentFeature, currentOutput, start, end, 0.1); break;
+    case 8: changed = processor.stretchRange(currentFeature, currentOutput, start, end, 0.5); break;
+    case 9: changed = processor.stretchRange(currentFeature, currentOutput, start, end, 2.0); break;
+    case 10: changed = processor.resampleRange(currentFeature, currentOutput, start, end, 16); break;
+    case 11: changed = processor.resampleRange(currentFeature, currentOutput, start, end, 128); break;
+    default: {
+        int itemId = 100;
+        for (const auto& featureName : processor.getExtractedFeatures()) {
+            int numOutputs = processor.getNumOutputsForFeature(featureName);
+            if (menuResult < itemId + numOutputs) {
+                changed = processor.crossfadeRange(currentFeature, currentOutput, start, end,
+                    featureName, menuResult - itemId);
+                break;
+            }
+            itemId += numOutputs;
+        }
+        break;
+    }
+    }
+
+    // A stretch moves the selection's end along with the points.
+    if (changed && (menuResult == 8 || menuResult == 9) && selectionEnd > selectionStart)
+        selectionEnd = selectionStart + (selectionEnd - selectionStart) * (menuResult == 8 ? 0.5 : 2.0);
+
+    updateDisplay();
+    statusLabel.setText(changed ? "Edited " + juce::String(start, 2) + "-" + juce::String(end, 2) + "s"
+        : "Nothing to edit in the range", juce::dontSendNotification);
+}
+
+void AudioDeconstructorEditor::findSimilarRegions() {
+    auto search = processor.findSimilarRegions(selectionStart, selectionEnd);
+    const auto& matches = search.matches;
+
+    // Files analysed with other features can't be compared on every track.
+    juce::String skipped;
+    if (search.numSkipped > 0)
+        skipped << ", " << search.numSkipped << " files skipped for lacking a track";
+
+    if (matches.empty()) {
+        statusLabel.setText("No similar regions found" + skipped, juce::dontSendNotification);
+        return;
+    }
+    statusLabel.setText("Searched " + juce::String(search.numSources) + " files on "
+        + juce::String(search.numTracks) + " tracks" + skipped, juce::dontSendNotification);
+
+    juce::PopupMenu menu;
+    menu.addSectionHeader("Similar to " + juce::String(selectionStart, 2) + "-" + juce::String(selectionEnd, 2)
+        + "s, in " + juce::String(search.windowSeconds, 1) + "s windows");
+    for (size_t i = 0; i < matches.size(); ++i) {
+        const auto& match = matches[i];
+        auto fileName = match.file == processor.getLoadedFile() ? juce::String("This file") : match.file.getFileName();
+        menu.addItem(static_cast<int>(i) + 1, fileName + " @ " + juce::String(match.startTime, 2) + "s (distance "
+            + juce::String(match.distance, 2) + ")");
+    }
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&rangeButton),
+        [safeThis = juce::Component::SafePointer<AudioDeconstructorEditor>(this), matches](int result) {
+            if (safeThis != nullptr && result > 0)
+                safeThis->showSimilarRegion(matches[static_cast<size_t>(result - 1)]);
+        });
+}
+
+void AudioDeconstructorEditor::showSimilarRegion(const SimilarityIndex::Match& match) {
+    if (match.file != processor.getLoadedFile()) {
+        if (!processor.selectSessionFile(match.file)) {
+            statusLabel.setText("Can't read " + match.file.getFileName(), juce::dontSendNotification);
+            return;
+        }
+        showLoadedFile();
+        updateSessionSelector();
+    }
+
+    selectionStart = match.startTime;
+    selectionEnd = match.endTime;
+    updateDisplay();
+
+    // Some context either side of the match.
+    double margin = match.endTime - match.startTime;
+    overview.setTimeRange(juce::jmax(0.0, match.startTime - margin), match.endTime + margin);
+    statusLabel.setText("Selected " + juce::String(selectionStart, 2) + "-" + juce::String(selectionEnd, 2) + "s",
+        juce::dontSendNotification);
+    repaint();
+}
+
+void AudioDeconstructorEditor::toggleStats() {
+    bool show = statsButton.getToggleState();
+    processor.setProfilingEnabled(show);
+    statsView.setVisible(show);
+    budgetSelector.setVisible(show);
+    if (show)
+        updateStats();
+}
+
+void AudioDeconstructorEditor::updateStats() {
+    statsView.setText(MemoryBudget::describe(processor.getMemoryUsage(), processor.getMemoryBudget())
+        + "\n" + processor.getProfileSummary(), juce::dontSendNotification);
+}
+
+void AudioDeconstructorEditor::updatePlaybackTrack() {
+    if (envelopeOutToggle.getToggleState() && currentFeature.isNotEmpty())
+        processor.setPlaybackTrack(currentFeature, currentOutput);
+    else
+        processor.clearPlaybackTrack();
+
+    updateMirrorTrack();
+}
+
+void AudioDeconstructorEditor::updateMirrorTrack() {
+    // Mirror mode applies the selected track; switching it on picks the
+    // track up and switching it off lets it go.
+    if (processor.isMirrorOn() && currentFeature.isNotEmpty())
+        processor.setMirrorTrack(currentFeature, currentOutput);
+    else
+        processor.clearMirrorTrack();
+}
+
 void AudioDeconstructorEditor::updateDisplay() {
     if (currentFeature.isNotEmpty()) {
+        AnalysisProfiler::ScopedStage stage(&processor.getProfiler(), "Display copy");
         auto points = processor.getBreakpointsForDisplay(currentFeature, currentOutput);
+        stage.addBreakpoints(static_cast<juce::int64>(points.size()));
+        stage.addBytes(AnalysisProfiler::bytesOf(points));
         displayedBreakpoints.clear();
         for (const auto& p : points) {
             displayedBreakpoints.push_back({ static_cast<float>(p.first),
                                            static_cast<float>(p.second) });
         }
     }
+
+    // The overview rebuilds its tracks itself when the revision moves; this
+    // only makes sure it repaints.
+    if (processor.getBreakpointRevision() != overviewRevision) {
+        overviewRevision = processor.getBreakpointRevision();
+        overview.repaint();
+    }
+    overview.setActiveFeature(currentFeature, currentOutput);
+    overview.setDuration(processor.hasLoadedAudio()
+        ? processor.getLoadedAudio().getNumSamples() / processor.getLoadedSampleRate() : 0.0);
 }
 
 void AudioDeconstructorEditor::updateFeatureSelector() {
@@ -439,6 +1084,17 @@ void AudioDeconstructorEditor::updateOutputSelector() {
     }
 }
 
+void AudioDeconstructorEditor::selectTrack(const juce::String& featureName, int outputIndex) {
+    currentFeature = featureName;
+    featureSelector.setText(featureName, juce::dontSendNotification);
+    updateOutputSelector();
+
+    currentOutput = outputIndex;
+    outputSelector.setSelectedId(outputIndex + 1, juce::dontSendNotification);
+    updatePlaybackTrack();
+    updateDisplay();
+}
+
 int AudioDeconstructorEditor::findBreakpointAtPosition(juce::Point<float> position,
     float tolerance) {
 
@@ -522,8 +1178,8 @@ std::pair<float, float> AudioDeconstructorEditor::screenToTimeValue(
 void AudioDeconstructorEditor::updateBreakpointFromDrag(juce::Point<float> currentPosition) {
     if (draggedBreakpoint.index >= 0 && currentFeature.isNotEmpty()) {
         auto [newTime, newValue] = screenToTimeValue(currentPosition);
-        processor.updateBreakpoint(currentFeature, currentOutput,
-            draggedBreakpoint.index, newTime, newValue);
+        draggedBreakpoint.index = static_cast<int>(processor.updateBreakpoint(currentFeature, currentOutput,
+            static_cast<size_t>(draggedBreakpoint.index), newTime, newValue));
         updateDisplay();
     }
 }
@@ -550,12 +1206,18 @@ void AudioDeconstructorEditor::removeBreakpointAtPosition(juce::Point<float> pos
 
 void AudioDeconstructorEditor::mouseDown(const juce::MouseEvent& event) {
     if (graphBounds.contains(event.getPosition())) {
-        if (event.mods.isLeftButtonDown()) {
+        if (event.mods.isLeftButtonDown() && event.mods.isShiftDown()) {
+            selectionStart = selectionEnd = screenToTimeValue(event.position).first;
+            isSelecting = true;
+            repaint();
+        }
+        else if (event.mods.isLeftButtonDown()) {
             int index = findBreakpointAtPosition(event.position);
             if (index >= 0) {
                 draggedBreakpoint.index = index;
                 draggedBreakpoint.dragStartPosition = event.position;
                 isDragging = true;
+                processor.beginEditGesture();
             }
         }
         else if (event.mods.isRightButtonDown()) {
@@ -565,18 +1227,47 @@ void AudioDeconstructorEditor::mouseDown(const juce::MouseEvent& event) {
 }
 
 void AudioDeconstructorEditor::mouseDrag(const juce::MouseEvent& event) {
-    if (isDragging && event.mods.isLeftButtonDown()) {
+    if (isSelecting) {
+        selectionEnd = screenToTimeValue(event.position).first;
+        repaint();
+    }
+    else if (isDragging && event.mods.isLeftButtonDown()) {
         updateBreakpointFromDrag(event.position);
     }
 }
 
 void AudioDeconstructorEditor::mouseUp(const juce::MouseEvent&) {
+    if (isSelecting) {
+        isSelecting = false;
+        if (selectionEnd < selectionStart)
+            std::swap(selectionStart, selectionEnd);
+        statusLabel.setText(selectionEnd > selectionStart
+            ? "Selected " + juce::String(selectionStart, 2) + "-" + juce::String(selectionEnd, 2) + "s"
+            : "Selection cleared", juce::dontSendNotification);
+    }
     if (isDragging) {
         isDragging = false;
+        processor.endEditGesture();
         statusLabel.setText("Breakpoint updated", juce::dontSendNotification);
     }
 }
 
+bool AudioDeconstructorEditor::keyPressed(const juce::KeyPress& key) {
+    auto mods = key.getModifiers();
+    if (!mods.isCommandDown() || isDragging) return false;
+
+    // Letter key codes differ in case between platforms.
+    auto code = juce::CharacterFunctions::toUpperCase(static_cast<juce::juce_wchar>(key.getKeyCode()));
+    bool redo = code == 'Y' || (code == 'Z' && mods.isShiftDown());
+    if (!redo && code != 'Z') return false;
+
+    if (redo ? processor.redoEdit() : processor.undoEdit()) {
+        updateDisplay();
+        statusLabel.setText(redo ? "Redo" : "Undo", juce::dontSendNotification);
+    }
+    return true;
+}
+
 void AudioDeconstructorEditor::mouseDoubleClick(const juce::MouseEvent& event) {
     if (graphBounds.contains(event.getPosition()) && event.mods.isLeftButtonDown()) {
         addBreakpointAtPosition(event.position);
@@ -3,6 +3,7 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "MultiFeatureDisplay.h"
 
 class AudioDeconstructorEditor : public juce::AudioProcessorEditor,
     private juce::Timer,
@@ -20,6 +21,7 @@ public:
     void mouseDrag(const juce::MouseEvent& event) override;
     void mouseUp(const juce::MouseEvent& event) override;
     void mouseDoubleClick(const juce::MouseEvent& event) override;
+    bool keyPressed(const juce::KeyPress& key) override;
 
 private:
     AudioDeconstructorProcessor& processor;
@@ -29,20 +31,66 @@ private:
     juce::TextButton saveButton;
     juce::TextButton saveAllButton;
     juce::TextButton clearButton;
+    juce::TextButton liveButton;
+    juce::TextButton renderButton;
+    juce::TextButton statsButton;
+    juce::TextButton traceButton;
+    juce::TextButton shareButton;
+    juce::TextButton rangeButton;
+
+    // Files queued by dropping several at once; picking one views it.
+    juce::ComboBox sessionSelector;
+    juce::uint32 sessionRevision = 0;
 
     juce::ComboBox featureSelector;
     juce::ComboBox outputSelector;
     juce::Label featureLabel;
     juce::Label outputLabel;
+    juce::ToggleButton envelopeOutToggle;
 
     juce::Slider windowSizeSlider;
     juce::Slider hopSizeSlider;
     juce::ToggleButton normalizeToggle;
+    juce::ToggleButton decimateToggle;
+    juce::ComboBox mirrorModeSelector;
+    juce::Slider mirrorDepthSlider;
+
+    using SliderAttachment = juce::AudioProcessorValueTreeState::SliderAttachment;
+    using ButtonAttachment = juce::AudioProcessorValueTreeState::ButtonAttachment;
+    std::unique_ptr<SliderAttachment> windowSizeAttachment;
+    std::unique_ptr<SliderAttachment> hopSizeAttachment;
+    std::unique_ptr<ButtonAttachment> normalizeAttachment;
+    std::unique_ptr<ButtonAttachment> decimateAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> mirrorModeAttachment;
+    std::unique_ptr<SliderAttachment> mirrorDepthAttachment;
 
     juce::Label infoLabel;
     juce::Label statusLabel;
 
+    // Profiling results, shown over the graph while the Stats button is on.
+    juce::TextEditor statsView;
+    int statsRefreshCountdown = 0;
+    // Memory budget, picked from a few sizes while the stats are showing.
+    juce::ComboBox budgetSelector;
+    static constexpr juce::int64 budgetChoices[] = { 256LL << 20, 512LL << 20, 1LL << 30, 2LL << 30, 4LL << 30,
+        MemoryBudget::unlimited };
+
+    // Control-rate export (.adcr) options, asked for on each save and kept
+    // while the editor is open. Rates come first in the grid menu, then
+    // block sizes.
+    static constexpr double exportRates[] = { 100.0, 200.0, 1000.0 };
+    static constexpr int exportBlockSizes[] = { 64, 128, 256, 512, 1024 };
+    int exportGridChoice = 0;
+    int exportInterpolationChoice = 0; // linear, hold, cubic
+
+    // Every extracted track on one zoomable time axis, read straight from
+    // the processor's breakpoints.
+    MultiFeatureDisplay overview;
+    juce::uint32 overviewRevision = 0;
+
     std::unique_ptr<juce::FileChooser> fileChooser;
+    class RenderJob;
+    bool isRendering = false;
 
     juce::Rectangle<int> graphBounds;
     std::vector<std::pair<float, float>> displayedBreakpoints;
@@ -58,6 +106,12 @@ private:
     DraggedBreakpoint draggedBreakpoint;
     bool isDragging = false;
 
+    // Time range picked by shift-dragging over the graph; the Range menu
+    // edits it, or the whole track when nothing is selected.
+    double selectionStart = 0.0;
+    double selectionEnd = 0.0;
+    bool isSelecting = false;
+
     void timerCallback() override;
     bool isInterestedInFileDrag(const juce::StringArray&) override;
     void filesDropped(const juce::StringArray& files, int, int) override;
@@ -74,15 +128,32 @@ private:
     void loadAudioFile();
     void extractFeatures();
     void saveCurrentBreakpoints();
+    void saveControlRate(const juce::File& file);
     void saveAllBreakpoints();
     void clearAll();
+    void toggleLiveCapture();
+    void renderToFile();
+    void renderFinished(const juce::Result& result, const juce::File& destination);
+    void toggleStats();
+    void updateStats();
+    void toggleTrace();
+    void showRangeMenu();
+    void applyRangeEdit(int menuResult);
+    void findSimilarRegions();
+    void showSimilarRegion(const SimilarityIndex::Match& match);
+    void updatePlaybackTrack();
+    void updateMirrorTrack();
     void updateDisplay();
     void updateFeatureSelector();
     void updateOutputSelector();
+    void updateSessionSelector();
+    void showLoadedFile();
+    void selectTrack(const juce::String& featureName, int outputIndex);
 
     void drawGraphBackground(juce::Graphics& g, const juce::Rectangle<int>& area);
     void drawWaveform(juce::Graphics& g, const juce::Rectangle<int>& area);
     void drawAudioWaveform(juce::Graphics& g, const juce::Rectangle<int>& area);
+    void drawSelection(juce::Graphics& g, const juce::Rectangle<int>& area);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioDeconstructorEditor)
 };
\ No newline at end of file
@@ -5,11 +5,135 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+namespace {
+
+juce::int64 countBreakpoints(const std::vector<BreakpointList>& outputs) {
+    juce::int64 total = 0;
+    for (const auto& output : outputs)
+        total += static_cast<juce::int64>(output.size());
+    return total;
+}
+
+} // namespace
+
+// One edit of one output: a point inserted, removed, or moved from one index
+// to another with a new time and value. Only that point is stored; undo
+// applies the inverse.
+class AudioDeconstructorProcessor::BreakpointEdit : public juce::UndoableAction {
+public:
+    enum class Kind { insert, remove, move };
+
+    BreakpointEdit(AudioDeconstructorProcessor& owner, const juce::String& featureName, int outputIndex, Kind kind,
+        size_t from, size_t to, std::pair<double, double> before, std::pair<double, double> after)
+        : owner(owner), featureName(featureName), outputIndex(outputIndex), kind(kind),
+        from(from), to(to), before(before), after(after) {}
+
+    bool perform() override {
+        switch (kind) {
+        case Kind::insert: return insert(to, after);
+        case Kind::remove: return remove(from);
+        default: return owner.moveBreakpoint(featureName, outputIndex, from, to, after);
+        }
+    }
+
+    bool undo() override {
+        switch (kind) {
+        case Kind::insert: return remove(to);
+        case Kind::remove: return insert(from, before);
+        default: return owner.moveBreakpoint(featureName, outputIndex, to, from, before);
+        }
+    }
+
+    int getSizeInUnits() override {
+        return static_cast<int>(sizeof(*this)) + featureName.getNumBytesAsUTF8();
+    }
+
+    // Successive moves of the same point, as in a drag, become one move.
+    juce::UndoableAction* createCoalescedAction(juce::UndoableAction* next) override {
+        auto* edit = dynamic_cast<BreakpointEdit*>(next);
+        if (edit == nullptr || kind != Kind::move || edit->kind != Kind::move || edit->from != to
+            || edit->outputIndex != outputIndex || edit->featureName != featureName)
+            return nullptr;
+
+        return new BreakpointEdit(owner, featureName, outputIndex, Kind::move, from, edit->to, before, edit->after);
+    }
+
+private:
+    AudioDeconstructorProcessor& owner;
+    juce::String featureName;
+    int outputIndex;
+    Kind kind;
+    size_t from, to;
+    std::pair<double, double> before, after;
+
+    bool insert(size_t index, std::pair<double, double> point) {
+        auto* points = owner.findTrack(featureName, outputIndex);
+        if (points == nullptr || index > points->size()) return false;
+
+        points->insert(points->begin() + static_cast<std::ptrdiff_t>(index), point);
+        owner.markEdited(featureName, outputIndex, index, SIZE_MAX);
+        return true;
+    }
+
+    bool remove(size_t index) {
+        auto* points = owner.findTrack(featureName, outputIndex);
+        if (points == nullptr || index >= points->size()) return false;
+
+        points->erase(points->begin() + static_cast<std::ptrdiff_t>(index));
+        owner.markEdited(featureName, outputIndex, index, SIZE_MAX);
+        return true;
+    }
+};
+
+// Replaces a run of points of one output with another run, keeping both so
+// undo can put the old one back. Value-only edits keep the length and are
+// copied over in place.
+class AudioDeconstructorProcessor::RangeEdit : public juce::UndoableAction {
+public:
+    RangeEdit(AudioDeconstructorProcessor& owner, const juce::String& featureName, int outputIndex,
+        size_t position, BreakpointList removed, BreakpointList inserted)
+        : owner(owner), featureName(featureName), outputIndex(outputIndex), position(position),
+        removed(std::move(removed)), inserted(std::move(inserted)) {}
+
+    bool perform() override { return splice(removed, inserted); }
+    bool undo() override { return splice(inserted, removed); }
+
+    int getSizeInUnits() override {
+        return static_cast<int>(sizeof(*this) + (removed.size() + inserted.size()) * sizeof(removed.front()))
+            + featureName.getNumBytesAsUTF8();
+    }
+
+private:
+    AudioDeconstructorProcessor& owner;
+    juce::String featureName;
+    int outputIndex;
+    size_t position;
+    BreakpointList removed, inserted;
+
+    bool splice(const BreakpointList& from, const BreakpointList& to) {
+        auto* points = owner.findTrack(featureName, outputIndex);
+        if (points == nullptr || position + from.size() > points->size()) return false;
+
+        auto start = points->begin() + static_cast<std::ptrdiff_t>(position);
+        if (from.size() == to.size()) {
+            std::copy(to.begin(), to.end(), start);
+            owner.markEdited(featureName, outputIndex, position, position + to.size());
+        }
+        else {
+            start = points->erase(start, start + static_cast<std::ptrdiff_t>(from.size()));
+            points->insert(start, to.begin(), to.end());
+            owner.markEdited(featureName, outputIndex, position, SIZE_MAX);
+        }
+        return true;
+    }
+};
+
 AudioDeconstructorProcessor::AudioDeconstructorProcessor()
     : AudioProcessor(BusesProperties()
         .withInput("Input", juce::AudioChannelSet::stereo(), true)
         .withInput("Input", juce::AudioChannelSet::mono(), true)
-        .withOutput("Output", juce::AudioChannelSet::stereo(), true))
+        .withOutput("Output", juce::AudioChannelSet::stereo(), true)
+        .withOutput("Envelope", juce::AudioChannelSet::mono(), false))
     , params(*this, nullptr, "PARAMS", {
         std::make_unique<juce::AudioParameterFloat>(
             juce::ParameterID{"windowSize", 1},
@@ -38,13 +162,64 @@ AudioDeconstructorProcessor::AudioDeconstructorProcessor()
             "Smooth Time (ms)",
             juce::NormalisableRange<float>(1.0f, 50.0f, 1.0f),
             10.0f
+        ),
+        std::make_unique<juce::AudioParameterBool>(
+            juce::ParameterID{"decimate", 1},
+            "Decimated Analysis",
+            false
+        ),
+        std::make_unique<juce::AudioParameterChoice>(
+            juce::ParameterID{"mirrorMode", 1},
+            "Mirror Mode",
+            juce::StringArray{ "Off", "Gain", "Pan" },
+            0
+        ),
+        std::make_unique<juce::AudioParameterFloat>(
+            juce::ParameterID{"mirrorDepth", 1},
+            "Mirror Depth",
+            juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f),
+            1.0f
         )
         })
 {
+    // Cached so the audio thread never looks parameters up by name.
+    mirrorModeParameter = params.getRawParameterValue("mirrorMode");
+    mirrorDepthParameter = params.getRawParameterValue("mirrorDepth");
+
     initializeExtractors();
+
+    juce::StringArray eventFeatures;
+    for (const auto& [name, extractor] : extractors) {
+        if (extractor->emitsEvents())
+            eventFeatures.add(name);
+    }
+    similarityIndex.setIgnoredFeatures(eventFeatures);
+    session.setSimilarityIndex(&similarityIndex);
+    session.onFileFinished = [this] { triggerAsyncUpdate(); };
 }
 
-AudioDeconstructorProcessor::~AudioDeconstructorProcessor() {}
+// Session workers may still trigger an update while the members are torn
+// down; the AsyncUpdater base outlives them and drops it.
+AudioDeconstructorProcessor::~AudioDeconstructorProcessor() {
+    stopTimer();
+}
+
+void AudioDeconstructorProcessor::handleAsyncUpdate() {
+    if (liveCaptureStopped.exchange(false))
+        commitLiveCapture();
+    if (trackSelectionPending.exchange(false))
+        restoreTrackSelection();
+    // Each further edit pushes the encode back.
+    if (!hasPendingFeatureState && savedStateRevision != breakpointRevision)
+        startTimer(savedStateDelayMs);
+    updateFeatureBus();
+    enforceMemoryBudget();
+}
+
+void AudioDeconstructorProcessor::timerCallback() {
+    stopTimer();
+    updateSavedFeatureState();
+}
 
 void AudioDeconstructorProcessor::initializeExtractors() {
     extractors["Amplitude"] = FeatureExtractorFactory::createExtractor("Amplitude");
@@ -52,81 +227,634 @@ void AudioDeconstructorProcessor::initializeExtractors() {
     extractors["Spectral"] = FeatureExtractorFactory::createExtractor("Spectral");
     extractors["Pitch"] = FeatureExtractorFactory::createExtractor("Pitch");
     extractors["Transients"] = FeatureExtractorFactory::createExtractor("Transients");
+
+    for (auto& [name, extractor] : extractors)
+        extractor->profiler = &profiler;
 }
 
 bool AudioDeconstructorProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const {
     const auto& out = layouts.getMainOutputChannelSet();
-    return out == juce::AudioChannelSet::stereo();
+    if (out != juce::AudioChannelSet::stereo()) return false;
+
+    if (layouts.outputBuses.size() > 1) {
+        const auto& envelope = layouts.getChannelSet(false, 1);
+        if (!envelope.isDisabled() && envelope != juce::AudioChannelSet::mono()) return false;
+    }
+    return true;
 }
 
-void AudioDeconstructorProcessor::prepareToPlay(double, int) {}
-void AudioDeconstructorProcessor::releaseResources() {}
+void AudioDeconstructorProcessor::prepareToPlay(double sampleRate, int samplesPerBlock) {
+    stopLiveCaptureFromHost();
+    liveAnalyzer.prepare(sampleRate, getTotalNumInputChannels(), samplesPerBlock);
+    envelopePlayer.prepare(sampleRate);
+    mirror.prepare(sampleRate, samplesPerBlock);
+    freeRunningSamples = 0;
+}
+
+void AudioDeconstructorProcessor::releaseResources() {
+    stopLiveCaptureFromHost();
+    liveAnalyzer.release();
+}
 
 void AudioDeconstructorProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer&) {
     juce::ScopedNoDenormals noDenormals;
-    // Pass-through - this is an analysis plugin
+    // Pass-through unless mirror mode is on. The input is copied into the
+    // live analyzer's ring first, so captures see the unprocessed signal.
+    liveAnalyzer.pushBlock(buffer);
+
+    int numSamples = buffer.getNumSamples();
+    double startTime = getBlockStartTime(numSamples);
+
+    EnvelopeApplicator::Parameters mirrorParameters;
+    mirrorParameters.mode = static_cast<EnvelopeApplicator::Mode>(juce::roundToInt(mirrorModeParameter->load()));
+    mirrorParameters.depth = mirrorDepthParameter->load();
+
+    auto mainBus = getBusBuffer(buffer, false, 0);
+    mirror.process(mainBus, mainBus.getNumChannels(), startTime, mirrorParameters);
+
+    if (getBusCount(false) > 1) {
+        auto envelopeBus = getBusBuffer(buffer, false, 1);
+        if (envelopeBus.getNumChannels() > 0) {
+            if (!envelopePlayer.render(envelopeBus.getWritePointer(0), numSamples, startTime))
+                envelopeBus.clear();
+        }
+    }
+}
+
+double AudioDeconstructorProcessor::getBlockStartTime(int numSamples) {
+    if (auto* playHead = getPlayHead()) {
+        if (auto position = playHead->getPosition()) {
+            if (auto seconds = position->getTimeInSeconds())
+                return *seconds;
+        }
+    }
+
+    // No transport: play from when the plugin was prepared.
+    double time = static_cast<double>(freeRunningSamples) / getSampleRate();
+    freeRunningSamples += numSamples;
+    return time;
 }
 
 bool AudioDeconstructorProcessor::loadAudioFile(const juce::File& file) {
+    // Each loaded file starts a new profiling run.
+    profiler.reset();
+    AnalysisProfiler::ScopedStage stage(&profiler, "Decode");
+
     juce::AudioFormatManager formatManager;
     formatManager.registerBasicFormats();
 
     std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
     if (reader != nullptr) {
+        storeSessionFeatures();
         loadedSampleRate = reader->sampleRate;
         int numChannels = static_cast<int>(reader->numChannels);
         int numSamples = static_cast<int>(reader->lengthInSamples);
 
         loadedAudio.setSize(numChannels, numSamples);
-        reader->read(&loadedAudio, 0, numSamples, 0, true, true);
+
+        // Read in chunks so a trace shows where decoding time goes.
+        constexpr int decodeChunkSamples = 1 << 18;
+        for (int start = 0; start < numSamples; start += decodeChunkSamples) {
+            TraceRecorder::Scope chunk("decode chunk");
+            int length = juce::jmin(decodeChunkSamples, numSamples - start);
+            reader->read(&loadedAudio, start, length, start, true, true);
+        }
         loadedFileName = file.getFileNameWithoutExtension();
+        loadedFile = file;
+        sessionFeaturesPending = false;
+        stage.addFrames(numSamples);
+        stage.addBytes(static_cast<juce::int64>(numChannels) * numSamples * static_cast<juce::int64>(sizeof(float)));
 
+        invalidateAnalysis();
+        discardPendingFeatureState();
         featureBreakpoints.clear();
+        publishPlaybackTrack();
         return true;
     }
     return false;
 }
 
 void AudioDeconstructorProcessor::clearLoadedAudio() {
+    storeSessionFeatures();
     loadedAudio.setSize(0, 0);
     loadedFileName = "";
+    loadedFile = juce::File();
+    sessionFeaturesPending = false;
+    invalidateAnalysis();
+    discardPendingFeatureState();
     featureBreakpoints.clear();
+    publishPlaybackTrack();
+}
+
+int AudioDeconstructorProcessor::queueFiles(const juce::Array<juce::File>& files) {
+    int numQueued = session.addFiles(files, getAvailableFeatures(), getSettingsFromParameters(), 0);
+    if (!hasLoadedAudio() && !files.isEmpty())
+        selectSessionFile(files.getFirst());
+    return numQueued;
+}
+
+bool AudioDeconstructorProcessor::selectSessionFile(const juce::File& file) {
+    if (!loadAudioFile(file)) return false;
+
+    session.setPriorityFile(file);
+    sessionFeaturesPending = true;
+    collectSessionFeatures();
+    return true;
+}
+
+bool AudioDeconstructorProcessor::collectSessionFeatures() {
+    if (!sessionFeaturesPending || !session.isDone(loadedFile)) return false;
+
+    sessionFeaturesPending = false;
+    auto features = session.getFeatures(loadedFile);
+    if (features.empty()) return false;
+
+    // Anything extracted by hand while waiting is kept.
+    for (auto& [featureName, outputs] : features)
+        featureBreakpoints.emplace(featureName, std::move(outputs));
+    publishPlaybackTrack();
+    return true;
+}
+
+void AudioDeconstructorProcessor::storeSessionFeatures() {
+    if (loadedFile == juce::File() || session.indexOf(loadedFile) < 0) return;
+
+    ensureFeaturesRestored();
+    if (!featureBreakpoints.empty())
+        session.storeFeatures(loadedFile, featureBreakpoints);
 }
 
 void AudioDeconstructorProcessor::extractFeature(const juce::String& featureName, int channel) {
+    ensureFeaturesRestored();
     auto it = extractors.find(featureName);
     if (it == extractors.end() || !hasLoadedAudio()) return;
 
     isAnalyzing = true;
     auto& extractor = it->second;
+    AnalysisProfiler::ScopedStage extractStage(&profiler, "extract", featureName);
 
-    // Update settings from parameters
-    extractor->settings.windowSizeMs = params.getRawParameterValue("windowSize")->load();
-    extractor->settings.hopSizePct = params.getRawParameterValue("hopSize")->load();
-    extractor->settings.normalizeOutput = params.getRawParameterValue("normalize")->load() > 0.5f;
-    extractor->settings.smoothOutput = params.getRawParameterValue("smooth")->load() > 0.5f;
-    extractor->settings.smoothTimeMs = params.getRawParameterValue("smoothTime")->load();
+    extractor->settings = getSettingsFromParameters();
 
     int channelToUse = juce::jlimit(0, loadedAudio.getNumChannels() - 1,
         channel < 0 ? 0 : channel);
 
-    auto results = extractor->extract(loadedAudio, loadedSampleRate, channelToUse);
-    featureBreakpoints[featureName] = results;
+    auto& stages = featureStages[featureName];
+
+    AnalysisCache::Key cacheKey{ getLoadedAudioHash(), featureName, extractor->getVersion(),
+        AnalysisCache::hashSettings(extractor->getSettingsFor(extractor->getRawSettingsDependencies())),
+        channelToUse };
+    auto rawKey = cacheKey.getHash();
+
+    if (rawKey != stages.rawKey) {
+        bool cached;
+        {
+            AnalysisProfiler::ScopedStage stage(&profiler, "cache lookup", featureName);
+            cached = analysisCache.lookup(cacheKey, stages.raw);
+        }
+
+        if (!cached) {
+            {
+                AnalysisProfiler::ScopedStage stage(&profiler, "raw", featureName);
+                if (extractor->usesFrameStatistics())
+                    stages.raw = extractor->extractFromFrames(getFrameStatistics(extractor->settings), channelToUse);
+                else if (extractor->usesAnalysisPyramid())
+                    stages.raw = extractor->extractFromPyramid(getAnalysisPyramid(), channelToUse);
+                else
+                    stages.raw = extractor->extractRaw(loadedAudio, loadedSampleRate, channelToUse);
+                stage.addFrames(stages.raw.empty() ? 0 : static_cast<juce::int64>(stages.raw.front().size()));
+                for (const auto& output : stages.raw)
+                    stage.addBytes(AnalysisProfiler::bytesOf(output));
+            }
+
+            AnalysisProfiler::ScopedStage stage(&profiler, "cache store", featureName);
+            analysisCache.store(cacheKey, stages.raw);
+        }
+        stages.rawKey = rawKey;
+        stages.postKey = 0;
+    }
+
+    auto postKey = rawKey ^ AnalysisCache::hashSettings(
+        extractor->getSettingsFor(extractor->getPostSettingsDependencies()));
+
+    if (postKey != stages.postKey || stages.edited || !isFeatureExtracted(featureName)) {
+        auto results = stages.raw;
+        {
+            AnalysisProfiler::ScopedStage stage(&profiler, "post-process", featureName);
+            extractor->postProcess(results);
+            stage.addBreakpoints(countBreakpoints(results));
+        }
+        extractStage.addBreakpoints(countBreakpoints(results));
+        featureBreakpoints[featureName] = std::move(results);
+        editHistory.clearUndoHistory();
+        refreshPlaybackTrack(featureName);
+        stages.postKey = postKey;
+        stages.edited = false;
+    }
 
     isAnalyzing = false;
 }
 
+FeatureExtractor::Settings AudioDeconstructorProcessor::getSettingsFromParameters() const {
+    FeatureExtractor::Settings settings;
+    settings.windowSizeMs = params.getRawParameterValue("windowSize")->load();
+    settings.hopSizePct = params.getRawParameterValue("hopSize")->load();
+    settings.normalizeOutput = params.getRawParameterValue("normalize")->load() > 0.5f;
+    settings.smoothOutput = params.getRawParameterValue("smooth")->load() > 0.5f;
+    settings.smoothTimeMs = params.getRawParameterValue("smoothTime")->load();
+    settings.decimatedAnalysis = params.getRawParameterValue("decimate")->load() > 0.5f;
+    return settings;
+}
+
+bool AudioDeconstructorProcessor::startLiveCapture() {
+    stopLiveCapture();
+    clearLoadedAudio();
+
+    if (!liveAnalyzer.startCapture(getSettingsFromParameters())) return false;
+
+    loadedFileName = "Live Capture";
+    loadedSampleRate = liveAnalyzer.getSampleRate();
+    return true;
+}
+
+void AudioDeconstructorProcessor::stopLiveCapture() {
+    // Also commits a capture the host stopped, if the update hasn't yet.
+    bool hostStopped = liveCaptureStopped.exchange(false);
+    if (!liveAnalyzer.isCapturing() && !hostStopped) return;
+
+    liveAnalyzer.stopCapture();
+    commitLiveCapture();
+}
+
+void AudioDeconstructorProcessor::stopLiveCaptureFromHost() {
+    // The host's thread only stops the worker; the tracks are touched on the
+    // message thread, which picks the results up from the analyzer.
+    if (!liveAnalyzer.isCapturing()) return;
+
+    liveAnalyzer.stopCapture();
+    liveCaptureStopped = true;
+    triggerAsyncUpdate();
+}
+
+void AudioDeconstructorProcessor::commitLiveCapture() {
+    collectLiveBreakpoints();
+
+    auto settings = getSettingsFromParameters();
+    for (auto& [featureName, outputs] : featureBreakpoints) {
+        auto it = extractors.find(featureName);
+        if (it == extractors.end()) continue;
+
+        it->second->settings = settings;
+        it->second->postProcess(outputs);
+    }
+    publishPlaybackTrack();
+}
+
+bool AudioDeconstructorProcessor::collectLiveBreakpoints() {
+    std::map<juce::String, std::vector<BreakpointList>> newPoints;
+    if (!liveAnalyzer.takeNewBreakpoints(newPoints)) return false;
+
+    for (auto& [featureName, outputs] : newPoints) {
+        auto& target = featureBreakpoints[featureName];
+        target.resize(juce::jmax(target.size(), outputs.size()));
+        for (size_t i = 0; i < outputs.size(); ++i)
+            target[i].insert(target[i].end(), outputs[i].begin(), outputs[i].end());
+        editHistory.clearUndoHistory();
+        refreshPlaybackTrack(featureName);
+    }
+    return true;
+}
+
 void AudioDeconstructorProcessor::extractAllFeatures() {
     for (const auto& [featureName, extractor] : extractors) {
         extractFeature(featureName, 0);
     }
 }
 
+juce::uint64 AudioDeconstructorProcessor::getLoadedAudioHash() {
+    // Hashed on first use so loading a file never pays for it up front.
+    if (loadedAudioHash == 0 && hasLoadedAudio())
+        loadedAudioHash = AnalysisCache::hashAudio(loadedAudio, loadedSampleRate);
+    return loadedAudioHash;
+}
+
+const FrameStatistics& AudioDeconstructorProcessor::getFrameStatistics(
+    const FeatureExtractor::Settings& settings) {
+
+    auto key = getLoadedAudioHash() ^ AnalysisCache::hashSettings(
+        { settings.windowSizeMs, settings.hopSizePct });
+
+    if (frameStatistics == nullptr || key != frameStatisticsKey) {
+        AnalysisProfiler::ScopedStage stage(&profiler, "Framing");
+        frameStatistics = std::make_unique<FrameStatistics>(FrameStatistics::compute(
+            loadedAudio, loadedSampleRate, settings.windowSizeMs, settings.hopSizePct));
+        frameStatisticsKey = key;
+
+        stage.addFrames(static_cast<juce::int64>(frameStatistics->getNumFrames()));
+        auto bytes = AnalysisProfiler::bytesOf(frameStatistics->starts)
+            + AnalysisProfiler::bytesOf(frameStatistics->lengths)
+            + AnalysisProfiler::bytesOf(frameStatistics->crossProduct);
+        for (const auto& channel : frameStatistics->channels) {
+            bytes += AnalysisProfiler::bytesOf(channel.sumSquares) + AnalysisProfiler::bytesOf(channel.sumAbs)
+                + AnalysisProfiler::bytesOf(channel.peak);
+        }
+        stage.addBytes(bytes);
+    }
+    return *frameStatistics;
+}
+
+const AnalysisPyramid& AudioDeconstructorProcessor::getAnalysisPyramid() {
+    if (analysisPyramid == nullptr) {
+        AnalysisProfiler::ScopedStage stage(&profiler, "Decimation");
+        analysisPyramid = std::make_unique<AnalysisPyramid>(AnalysisPyramid::compute(loadedAudio, loadedSampleRate));
+
+        stage.addFrames(loadedAudio.getNumSamples());
+        for (const auto& level : analysisPyramid->decimated)
+            stage.addBytes(static_cast<juce::int64>(level.getNumChannels()) * level.getNumSamples()
+                * static_cast<juce::int64>(sizeof(float)));
+    }
+    return *analysisPyramid;
+}
+
+void AudioDeconstructorProcessor::invalidateAnalysis() {
+    loadedAudioHash = 0;
+    featureStages.clear();
+    frameStatistics.reset();
+    analysisPyramid.reset();
+}
+
+void AudioDeconstructorProcessor::markEdited(const juce::String& featureName, int outputIndex,
+    size_t first, size_t last) {
+
+    auto it = featureStages.find(featureName);
+    if (it != featureStages.end())
+        it->second.edited = true;
+
+    refreshPlaybackTrack(featureName, outputIndex, first, last);
+}
+
+void AudioDeconstructorProcessor::setMemoryBudget(juce::int64 bytes) {
+    params.state.setProperty("memoryBudget", juce::jmax(juce::int64(0), bytes), nullptr);
+    enforceMemoryBudget();
+}
+
+juce::int64 AudioDeconstructorProcessor::getMemoryBudget() const {
+    return static_cast<juce::int64>(params.state.getProperty("memoryBudget", MemoryBudget::defaultLimit));
+}
+
+MemoryBudget::Usage AudioDeconstructorProcessor::getMemoryUsage() const {
+    MemoryBudget::Usage usage;
+    usage.bytes[MemoryBudget::decodedAudio] = MemoryBudget::bytesOf(loadedAudio);
+    if (frameStatistics != nullptr)
+        usage.bytes[MemoryBudget::frameStatistics] = MemoryBudget::bytesOf(*frameStatistics);
+    if (analysisPyramid != nullptr)
+        usage.bytes[MemoryBudget::analysisPyramid] = MemoryBudget::bytesOf(*analysisPyramid);
+    for (const auto& [featureName, stages] : featureStages)
+        usage.bytes[MemoryBudget::rawStages] += MemoryBudget::bytesOf(stages.raw);
+    usage.bytes[MemoryBudget::tracks] = MemoryBudget::bytesOf(featureBreakpoints);
+    {
+        const juce::ScopedLock sl(savedStateLock);
+        usage.bytes[MemoryBudget::tracks] += static_cast<juce::int64>(savedFeatureState.getSize());
+    }
+    usage.bytes[MemoryBudget::playbackTracks] = envelopePlayer.getTrackBytes() + mirror.getTrackBytes();
+    for (const auto& [featureName, indexes] : trackIndexes) {
+        for (const auto& index : indexes) {
+            if (index != nullptr)
+                usage.bytes[MemoryBudget::trackIndexes] += MemoryBudget::bytesOf(*index);
+        }
+    }
+    usage.bytes[MemoryBudget::similarityIndex] = similarityIndex.getMemoryBytes();
+    // Edits report their size in bytes (see getSizeInUnits).
+    usage.bytes[MemoryBudget::undoHistory] = editHistory.getNumberOfUnitsTakenUpByStoredCommands();
+
+    // The viewed file's entry in the session is stale until it's stored
+    // back, but it's still memory.
+    usage.bytes[MemoryBudget::sessionTracks] = session.getResidentBytes();
+    usage.spilledBytes = session.getSpilledBytes();
+    usage.numSpilledFiles = session.getNumSpilledFiles();
+    return usage;
+}
+
+void AudioDeconstructorProcessor::enforceMemoryBudget() {
+    auto limit = getMemoryBudget();
+    if (limit == MemoryBudget::unlimited) return;
+
+    auto excess = getMemoryUsage().getTotal() - limit;
+    if (excess <= 0) return;
+
+    TraceRecorder::Scope trace("memory budget");
+    excess -= session.spill(excess, loadedFile);
+    if (excess <= 0) return;
+
+    // Raw stages come back from the analysis cache, or are extracted again.
+    for (auto& [featureName, stages] : featureStages) {
+        if (excess <= 0) return;
+        excess -= MemoryBudget::bytesOf(stages.raw);
+        std::vector<BreakpointList>().swap(stages.raw);
+        stages.rawKey = 0;
+    }
+
+    if (analysisPyramid != nullptr && excess > 0) {
+        excess -= MemoryBudget::bytesOf(*analysisPyramid);
+        analysisPyramid.reset();
+    }
+    if (frameStatistics != nullptr && excess > 0)
+        frameStatistics.reset();
+}
+
+bool AudioDeconstructorProcessor::setFeatureBusEnabled(bool shouldBeEnabled) {
+    if (!shouldBeEnabled) {
+        featureBus.reset();
+        return true;
+    }
+    if (featureBus != nullptr) return true;
+
+    // One bus per instance; readers find it with FeatureBus::findBuses.
+    auto bus = std::make_unique<FeatureBus::Writer>("Deconstructor-" + juce::Uuid().toString().substring(0, 8));
+    if (!bus->isOpen()) return false;
+
+    featureBus = std::move(bus);
+    featureBusRevision = breakpointRevision - 1;
+    updateFeatureBus();
+    return true;
+}
+
+void AudioDeconstructorProcessor::updateFeatureBus() {
+    if (featureBus == nullptr) return;
+
+    ensureFeaturesRestored();
+    if (featureBusRevision == breakpointRevision) return;
+
+    TraceRecorder::Scope trace("publish", featureBus->getName());
+    std::vector<FeatureBus::Source> tracks;
+    for (const auto& [featureName, outputs] : featureBreakpoints) {
+        for (size_t i = 0; i < outputs.size(); ++i)
+            tracks.push_back({ featureName, getOutputName(featureName, static_cast<int>(i)), &outputs[i] });
+    }
+
+    if (featureBus->publish(loadedFileName, loadedSampleRate, tracks))
+        featureBusRevision = breakpointRevision;
+}
+
+SimilarityIndex::SearchResult AudioDeconstructorProcessor::findSimilarRegions(double startTime,
+    double endTime, int numMatches) {
+
+    ensureFeaturesRestored();
+    if (featureBreakpoints.empty()) return {};
+
+    if (similarityFile != loadedFile || similarityRevision != breakpointRevision) {
+        TraceRecorder::Scope trace("similarity index", loadedFileName);
+        // A file that left the view stays indexed only if the session has it.
+        if (similarityFile != loadedFile && session.indexOf(similarityFile) < 0)
+            similarityIndex.removeSource(similarityFile);
+        similarityIndex.setSource(loadedFile, featureBreakpoints);
+        similarityFile = loadedFile;
+        similarityRevision = breakpointRevision;
+    }
+
+    TraceRecorder::Scope trace("similarity search");
+    return similarityIndex.findNearest(featureBreakpoints, startTime, endTime, numMatches, loadedFile);
+}
+
+void AudioDeconstructorProcessor::setPlaybackTrack(const juce::String& featureName,
+    int outputIndex, int controlInterval) {
+
+    ensureFeaturesRestored();
+    playbackFeature = featureName;
+    playbackOutput = outputIndex;
+    envelopePlayer.setControlInterval(controlInterval);
+    envelopePlayer.setTrack(makeEnvelopeTrack(playbackFeature, playbackOutput));
+
+    params.state.setProperty("playbackFeature", featureName, nullptr);
+    params.state.setProperty("playbackOutput", outputIndex, nullptr);
+    params.state.setProperty("playbackInterval", controlInterval, nullptr);
+}
+
+void AudioDeconstructorProcessor::clearPlaybackTrack() {
+    playbackFeature = {};
+    envelopePlayer.setTrack(nullptr);
+    params.state.removeProperty("playbackFeature", nullptr);
+}
+
+void AudioDeconstructorProcessor::setMirrorTrack(const juce::String& featureName, int outputIndex) {
+    ensureFeaturesRestored();
+    mirrorFeature = featureName;
+    mirrorOutput = outputIndex;
+    mirror.setTrack(makeEnvelopeTrack(mirrorFeature, mirrorOutput));
+
+    params.state.setProperty("mirrorFeature", featureName, nullptr);
+    params.state.setProperty("mirrorOutput", outputIndex, nullptr);
+}
+
+void AudioDeconstructorProcessor::clearMirrorTrack() {
+    mirrorFeature = {};
+    mirror.setTrack(nullptr);
+    params.state.removeProperty("mirrorFeature", nullptr);
+}
+
+bool AudioDeconstructorProcessor::isMirrorOn() const {
+    return static_cast<EnvelopeApplicator::Mode>(juce::roundToInt(mirrorModeParameter->load()))
+        != EnvelopeApplicator::Mode::off;
+}
+
+juce::String AudioDeconstructorProcessor::getMirrorFeature() const {
+    return params.state.getProperty("mirrorFeature").toString();
+}
+
+int AudioDeconstructorProcessor::getMirrorOutput() const {
+    return params.state.getProperty("mirrorOutput", 0);
+}
+
+void AudioDeconstructorProcessor::restoreTrackSelection() {
+    // Decodes the restored tracks if anything is to play them.
+    const auto state = params.state;
+    auto playback = state.getProperty("playbackFeature").toString();
+    if (playback.isNotEmpty())
+        setPlaybackTrack(playback, state.getProperty("playbackOutput", 0), state.getProperty("playbackInterval", 0));
+    else
+        clearPlaybackTrack();
+
+    auto mirrored = state.getProperty("mirrorFeature").toString();
+    if (mirrored.isNotEmpty() && isMirrorOn())
+        setMirrorTrack(mirrored, state.getProperty("mirrorOutput", 0));
+    else
+        clearMirrorTrack();
+}
+
+juce::Result AudioDeconstructorProcessor::makeRenderModulation(const juce::String& featureName,
+    int outputIndex, OfflineRenderer::Target target, OfflineRenderer::Modulation& modulation) {
+
+    ensureFeaturesRestored();
+    auto it = featureBreakpoints.find(featureName);
+    if (it == featureBreakpoints.end() || outputIndex < 0
+        || outputIndex >= static_cast<int>(it->second.size()))
+        return juce::Result::fail(featureName + " has not been extracted");
+
+    modulation.target = target;
+    modulation.points = it->second[static_cast<size_t>(outputIndex)];
+    modulation.depth = mirrorDepthParameter->load();
+    modulation.events = emitsEvents(featureName);
+    return juce::Result::ok();
+}
+
+std::unique_ptr<EnvelopeTrack> AudioDeconstructorProcessor::makeEnvelopeTrack(
+    const juce::String& featureName, int outputIndex) const {
+
+    auto it = featureBreakpoints.find(featureName);
+    if (it == featureBreakpoints.end() || outputIndex < 0
+        || outputIndex >= static_cast<int>(it->second.size()))
+        return nullptr;
+
+    const auto& points = it->second[static_cast<size_t>(outputIndex)];
+    return emitsEvents(featureName) ? EnvelopeTrack::fromEvents(points) : EnvelopeTrack::fromBreakpoints(points);
+}
+
+bool AudioDeconstructorProcessor::emitsEvents(const juce::String& featureName) const {
+    auto it = extractors.find(featureName);
+    return it != extractors.end() && it->second->emitsEvents();
+}
+
+void AudioDeconstructorProcessor::publishPlaybackTrack() {
+    ++breakpointRevision;
+    trackIndexes.clear();
+    editHistory.clearUndoHistory();
+    // Replaced tracks may take the plugin over its memory budget.
+    triggerAsyncUpdate();
+    if (playbackFeature.isNotEmpty())
+        envelopePlayer.setTrack(makeEnvelopeTrack(playbackFeature, playbackOutput));
+    if (mirrorFeature.isNotEmpty())
+        mirror.setTrack(makeEnvelopeTrack(mirrorFeature, mirrorOutput));
+}
+
+void AudioDeconstructorProcessor::refreshPlaybackTrack(const juce::String& featureName, int outputIndex,
+    size_t first, size_t last) {
+
+    ++breakpointRevision;
+    trackIndexes.erase(featureName);
+    // Re-encodes the saved state once the edits settle.
+    triggerAsyncUpdate();
+
+    // Players of the edited output patch the points that changed; event
+    // tracks are pulses with points of their own, so they are rebuilt.
+    auto refresh = [&](auto& player, const juce::String& playerFeature, int playerOutput) {
+        if (playerFeature != featureName || (outputIndex >= 0 && outputIndex != playerOutput)) return;
+
+        auto* points = outputIndex >= 0 && !emitsEvents(featureName) ? findTrack(featureName, outputIndex) : nullptr;
+        if (points == nullptr || !player.patchTrack(*points, first, last))
+            player.setTrack(makeEnvelopeTrack(playerFeature, playerOutput));
+    };
+    refresh(envelopePlayer, playbackFeature, playbackOutput);
+    refresh(mirror, mirrorFeature, mirrorOutput);
+}
+
 bool AudioDeconstructorProcessor::isFeatureExtracted(const juce::String& featureName) const {
+    ensureFeaturesRestored();
+
     return featureBreakpoints.find(featureName) != featureBreakpoints.end();
 }
 
 juce::StringArray AudioDeconstructorProcessor::getExtractedFeatures() const {
+    ensureFeaturesRestored();
+
     juce::StringArray features;
     for (const auto& [name, _] : featureBreakpoints) {
         features.add(name);
@@ -161,6 +889,7 @@ juce::String AudioDeconstructorProcessor::getOutputName(const juce::String& feat
 std::vector<std::pair<double, double>> AudioDeconstructorProcessor::getBreakpointsForDisplay(
     const juce::String& featureName, int outputIndex) const {
 
+    ensureFeaturesRestored();
     auto it = featureBreakpoints.find(featureName);
     if (it != featureBreakpoints.end() && outputIndex < it->second.size()) {
         return it->second[outputIndex];
@@ -168,39 +897,277 @@ std::vector<std::pair<double, double>> AudioDeconstructorProcessor::getBreakpoin
     return {};
 }
 
-void AudioDeconstructorProcessor::addBreakpoint(const juce::String& featureName,
-    int outputIndex, double time, double value) {
+const std::map<juce::String, std::vector<BreakpointList>>& AudioDeconstructorProcessor::getAllBreakpoints() const {
+    ensureFeaturesRestored();
+    return featureBreakpoints;
+}
 
+juce::uint32 AudioDeconstructorProcessor::getBreakpointRevision() const {
+    ensureFeaturesRestored();
+    return breakpointRevision;
+}
+
+const BreakpointIndex* AudioDeconstructorProcessor::getTrackIndex(const juce::String& featureName,
+    int outputIndex) const {
+
+    ensureFeaturesRestored();
     auto it = featureBreakpoints.find(featureName);
-    if (it != featureBreakpoints.end() && outputIndex < it->second.size()) {
-        it->second[outputIndex].emplace_back(time, value);
-        sortBreakpoints(featureName, outputIndex);
+    if (it == featureBreakpoints.end() || outputIndex < 0
+        || static_cast<size_t>(outputIndex) >= it->second.size())
+        return nullptr;
+
+    auto& indexes = trackIndexes[featureName];
+    indexes.resize(it->second.size());
+    auto& index = indexes[static_cast<size_t>(outputIndex)];
+    if (index == nullptr)
+        index = std::make_unique<BreakpointIndex>(it->second[static_cast<size_t>(outputIndex)]);
+    return index.get();
+}
+
+BreakpointSpan AudioDeconstructorProcessor::getBreakpointsInRange(const juce::String& featureName,
+    int outputIndex, double startTime, double endTime) const {
+
+    auto* index = getTrackIndex(featureName, outputIndex);
+    return index != nullptr ? index->getSpan(startTime, endTime) : BreakpointSpan{};
+}
+
+std::vector<AudioDeconstructorProcessor::TrackRange> AudioDeconstructorProcessor::queryRange(
+    const juce::StringArray& featureNames, double startTime, double endTime) const {
+
+    ensureFeaturesRestored();
+    std::vector<TrackRange> ranges;
+    for (const auto& [featureName, outputs] : featureBreakpoints) {
+        if (!featureNames.isEmpty() && !featureNames.contains(featureName)) continue;
+
+        for (int output = 0; output < static_cast<int>(outputs.size()); ++output) {
+            auto* index = getTrackIndex(featureName, output);
+            auto range = index->findRange(startTime, endTime);
+
+            TrackRange result;
+            result.featureName = featureName;
+            result.outputIndex = output;
+            result.points = index->getSpan(range.first, range.second);
+            result.summary = index->summarise(range.first, range.second);
+            ranges.push_back(std::move(result));
+        }
     }
+    return ranges;
+}
+
+void AudioDeconstructorProcessor::addBreakpoint(const juce::String& featureName,
+    int outputIndex, double time, double value) {
+
+    auto* points = findTrack(featureName, outputIndex);
+    if (points == nullptr) return;
+
+    auto position = std::upper_bound(points->begin(), points->end(), time,
+        [](double t, const std::pair<double, double>& point) { return t < point.first; });
+
+    if (!editGestureActive)
+        editHistory.beginNewTransaction();
+    editHistory.perform(new BreakpointEdit(*this, featureName, outputIndex, BreakpointEdit::Kind::insert,
+        0, static_cast<size_t>(position - points->begin()), {}, { time, value }));
 }
 
-void AudioDeconstructorProcessor::updateBreakpoint(const juce::String& featureName,
+size_t AudioDeconstructorProcessor::updateBreakpoint(const juce::String& featureName,
     int outputIndex, size_t pointIndex, double time, double value) {
 
-    auto it = featureBreakpoints.find(featureName);
-    if (it != featureBreakpoints.end() && outputIndex < it->second.size()) {
-        auto& points = it->second[outputIndex];
-        if (pointIndex < points.size()) {
-            points[pointIndex] = { juce::jmax(0.0, time), value };
-            sortBreakpoints(featureName, outputIndex);
-        }
+    auto* points = findTrack(featureName, outputIndex);
+    if (points == nullptr || pointIndex >= points->size()) return pointIndex;
+
+    time = juce::jmax(0.0, time);
+
+    // The point's place among the others: left of where it was if it now
+    // comes before its predecessor, otherwise at or right of it.
+    auto begin = points->begin();
+    auto current = begin + static_cast<std::ptrdiff_t>(pointIndex);
+    auto left = std::upper_bound(begin, current, time,
+        [](double t, const std::pair<double, double>& point) { return t < point.first; });
+    size_t newIndex = static_cast<size_t>(left - begin);
+    if (left == current) {
+        auto right = std::lower_bound(current + 1, points->end(), time,
+            [](const std::pair<double, double>& point, double t) { return point.first < t; });
+        newIndex = static_cast<size_t>(right - begin) - 1;
     }
+
+    if (!editGestureActive)
+        editHistory.beginNewTransaction();
+    editHistory.perform(new BreakpointEdit(*this, featureName, outputIndex, BreakpointEdit::Kind::move,
+        pointIndex, newIndex, *current, { time, value }));
+    return newIndex;
 }
 
 void AudioDeconstructorProcessor::removeBreakpoint(const juce::String& featureName,
     int outputIndex, size_t pointIndex) {
 
+    auto* points = findTrack(featureName, outputIndex);
+    if (points == nullptr || pointIndex >= points->size()) return;
+
+    if (!editGestureActive)
+        editHistory.beginNewTransaction();
+    editHistory.perform(new BreakpointEdit(*this, featureName, outputIndex, BreakpointEdit::Kind::remove,
+        pointIndex, 0, (*points)[pointIndex], {}));
+}
+
+BreakpointList* AudioDeconstructorProcessor::findTrack(const juce::String& featureName, int outputIndex) {
+    ensureFeaturesRestored();
     auto it = featureBreakpoints.find(featureName);
-    if (it != featureBreakpoints.end() && outputIndex < it->second.size()) {
-        auto& points = it->second[outputIndex];
-        if (pointIndex < points.size()) {
-            points.erase(points.begin() + pointIndex);
-        }
-    }
+    if (it == featureBreakpoints.end() || outputIndex < 0
+        || static_cast<size_t>(outputIndex) >= it->second.size())
+        return nullptr;
+    return &it->second[static_cast<size_t>(outputIndex)];
+}
+
+bool AudioDeconstructorProcessor::moveBreakpoint(const juce::String& featureName, int outputIndex,
+    size_t from, size_t to, std::pair<double, double> point) {
+
+    auto* points = findTrack(featureName, outputIndex);
+    if (points == nullptr || from >= points->size() || to >= points->size()) return false;
+
+    // Only the points between the old and new place shift.
+    auto begin = points->begin();
+    if (from < to)
+        std::rotate(begin + static_cast<std::ptrdiff_t>(from), begin + static_cast<std::ptrdiff_t>(from) + 1,
+            begin + static_cast<std::ptrdiff_t>(to) + 1);
+    else if (to < from)
+        std::rotate(begin + static_cast<std::ptrdiff_t>(to), begin + static_cast<std::ptrdiff_t>(from),
+            begin + static_cast<std::ptrdiff_t>(from) + 1);
+
+    (*points)[to] = point;
+    markEdited(featureName, outputIndex, juce::jmin(from, to), juce::jmax(from, to) + 1);
+    return true;
+}
+
+bool AudioDeconstructorProcessor::replaceRange(const juce::String& featureName, int outputIndex,
+    size_t first, size_t last, BreakpointList points) {
+
+    auto* track = findTrack(featureName, outputIndex);
+    if (track == nullptr || first > last || last > track->size()) return false;
+
+    BreakpointList removed(track->begin() + static_cast<std::ptrdiff_t>(first),
+        track->begin() + static_cast<std::ptrdiff_t>(last));
+
+    if (!editGestureActive)
+        editHistory.beginNewTransaction();
+    return editHistory.perform(new RangeEdit(*this, featureName, outputIndex, first,
+        std::move(removed), std::move(points)));
+}
+
+bool AudioDeconstructorProcessor::editRange(const juce::String& featureName, int outputIndex,
+    double startTime, double endTime, const std::function<void(BreakpointOperations::Columns&)>& operation) {
+
+    auto* index = getTrackIndex(featureName, outputIndex);
+    if (index == nullptr) return false;
+
+    auto [first, last] = index->findRange(startTime, endTime);
+    if (first == last) return false;
+
+    auto columns = BreakpointOperations::Columns::fromPoints(index->getSpan(first, last));
+    operation(columns);
+    return replaceRange(featureName, outputIndex, first, last, columns.toPoints());
+}
+
+bool AudioDeconstructorProcessor::scaleRange(const juce::String& featureName, int outputIndex,
+    double startTime, double endTime, double factor, double pivot) {
+
+    return editRange(featureName, outputIndex, startTime, endTime, [&](BreakpointOperations::Columns& columns) {
+        BreakpointOperations::scale(columns, factor, pivot);
+    });
+}
+
+bool AudioDeconstructorProcessor::offsetRange(const juce::String& featureName, int outputIndex,
+    double startTime, double endTime, double amount) {
+
+    return editRange(featureName, outputIndex, startTime, endTime, [&](BreakpointOperations::Columns& columns) {
+        BreakpointOperations::offset(columns, amount);
+    });
+}
+
+bool AudioDeconstructorProcessor::clampRange(const juce::String& featureName, int outputIndex,
+    double startTime, double endTime, double low, double high) {
+
+    return editRange(featureName, outputIndex, startTime, endTime, [&](BreakpointOperations::Columns& columns) {
+        BreakpointOperations::clamp(columns, low, high);
+    });
+}
+
+bool AudioDeconstructorProcessor::invertRange(const juce::String& featureName, int outputIndex,
+    double startTime, double endTime) {
+
+    return editRange(featureName, outputIndex, startTime, endTime, [](BreakpointOperations::Columns& columns) {
+        BreakpointOperations::invert(columns);
+    });
+}
+
+bool AudioDeconstructorProcessor::quantizeRange(const juce::String& featureName, int outputIndex,
+    double startTime, double endTime, double step) {
+
+    return editRange(featureName, outputIndex, startTime, endTime, [&](BreakpointOperations::Columns& columns) {
+        BreakpointOperations::quantize(columns, step);
+    });
+}
+
+bool AudioDeconstructorProcessor::stretchRange(const juce::String& featureName, int outputIndex,
+    double startTime, double endTime, double factor) {
+
+    auto* index = getTrackIndex(featureName, outputIndex);
+    if (index == nullptr || factor <= 0.0 || endTime <= startTime) return false;
+
+    // The range scales about its start and everything after it moves by
+    // the change in its length, so the track stays in order.
+    auto [first, last] = index->findRange(startTime, endTime);
+    size_t end = index->size();
+    if (first == end) return false;
+
+    auto columns = BreakpointOperations::Columns::fromPoints(index->getSpan(first, end));
+    BreakpointOperations::Columns tail;
+    tail.times.assign(columns.times.begin() + static_cast<std::ptrdiff_t>(last - first), columns.times.end());
+    columns.times.resize(last - first);
+
+    BreakpointOperations::stretch(columns, startTime, factor);
+    juce::FloatVectorOperations::add(tail.times.data(), (endTime - startTime) * (factor - 1.0), tail.size());
+    columns.times.insert(columns.times.end(), tail.times.begin(), tail.times.end());
+
+    return replaceRange(featureName, outputIndex, first, end, columns.toPoints());
+}
+
+bool AudioDeconstructorProcessor::resampleRange(const juce::String& featureName, int outputIndex,
+    double startTime, double endTime, int numPoints) {
+
+    auto* index = getTrackIndex(featureName, outputIndex);
+    if (index == nullptr || index->size() == 0 || numPoints < 2 || endTime <= startTime) return false;
+
+    auto [first, last] = index->findRange(startTime, endTime);
+    auto columns = BreakpointOperations::resample(*index->getPoints(), startTime, endTime, numPoints);
+    return replaceRange(featureName, outputIndex, first, last, columns.toPoints());
+}
+
+bool AudioDeconstructorProcessor::crossfadeRange(const juce::String& featureName, int outputIndex,
+    double startTime, double endTime, const juce::String& otherFeature, int otherOutput) {
+
+    auto* other = findTrack(otherFeature, otherOutput);
+    if (other == nullptr) return false;
+
+    return editRange(featureName, outputIndex, startTime, endTime, [&](BreakpointOperations::Columns& columns) {
+        BreakpointOperations::crossfade(columns, *other, startTime, endTime);
+    });
+}
+
+void AudioDeconstructorProcessor::beginEditGesture() {
+    editHistory.beginNewTransaction();
+    editGestureActive = true;
+}
+
+void AudioDeconstructorProcessor::endEditGesture() {
+    editGestureActive = false;
+}
+
+bool AudioDeconstructorProcessor::undoEdit() {
+    return editHistory.undo();
+}
+
+bool AudioDeconstructorProcessor::redoEdit() {
+    return editHistory.redo();
 }
 
 void AudioDeconstructorProcessor::sortBreakpoints(const juce::String& featureName,
@@ -215,39 +1182,35 @@ void AudioDeconstructorProcessor::sortBreakpoints(const juce::String& featureNam
 void AudioDeconstructorProcessor::saveBreakpoints(const juce::String& featureName,
     const juce::File& file) {
 
+    ensureFeaturesRestored();
     auto it = featureBreakpoints.find(featureName);
     if (it == featureBreakpoints.end()) return;
 
+    AnalysisProfiler::ScopedStage stage(&profiler, "save text", featureName);
     juce::FileOutputStream stream(file);
     if (stream.openedOk()) {
-        stream.writeText("# Audio Deconstructor Breakpoint File\n", false, false, "\n");
-        stream.writeText("# Feature: " + featureName + "\n", false, false, "\n");
-        stream.writeText("# Source: " + loadedFileName + "\n", false, false, "\n");
-        stream.writeText("# Sample Rate: " + juce::String(loadedSampleRate) + " Hz\n",
-            false, false, "\n");
-        stream.writeText("# Generated: " + juce::Time::getCurrentTime().toString(true, true) +
-            "\n", false, false, "\n");
-        stream.writeText("# Format: time(seconds) value\n\n", false, false, "\n");
+        stream.setPosition(0);
+        stream.truncate();
 
         const auto& outputs = it->second;
+        stage.addBreakpoints(countBreakpoints(outputs));
+        juce::StringArray outputNames;
+        auto extractorIt = extractors.find(featureName);
         for (size_t i = 0; i < outputs.size(); ++i) {
-            auto extractorIt = extractors.find(featureName);
-            juce::String outputName = extractorIt != extractors.end() ?
+            outputNames.add(extractorIt != extractors.end() ?
                 extractorIt->second->getOutputName(static_cast<int>(i)) :
-                "Output " + juce::String(i + 1);
-
-            stream.writeText("# " + outputName + "\n", false, false, "\n");
-
-            for (const auto& [time, value] : outputs[i]) {
-                stream.writeText(juce::String(time, 6) + "\t" +
-                    juce::String(value, 6) + "\n", false, false, "\n");
-            }
-            stream.writeText("\n", false, false, "\n");
+                "Output " + juce::String(i + 1));
         }
+
+        BreakpointFileFormat::write(stream, featureName, loadedFileName,
+            loadedSampleRate, outputNames, outputs);
+        stage.addBytes(stream.getPosition());
     }
 }
 
 void AudioDeconstructorProcessor::saveAllBreakpoints(const juce::File& directory) {
+    ensureFeaturesRestored();
+
     for (const auto& [featureName, _] : featureBreakpoints) {
         juce::File file = directory.getChildFile(loadedFileName + "_" +
             featureName + ".txt");
@@ -258,25 +1221,18 @@ void AudioDeconstructorProcessor::saveAllBreakpoints(const juce::File& directory
 void AudioDeconstructorProcessor::loadBreakpoints(const juce::String& featureName,
     int outputIndex, const juce::File& file) {
 
+    ensureFeaturesRestored();
+
+    AnalysisProfiler::ScopedStage stage(&profiler, "load text", featureName);
     juce::FileInputStream stream(file);
     if (!stream.openedOk()) return;
 
-    juce::String content = stream.readEntireStreamAsString();
-    auto lines = juce::StringArray::fromLines(content);
-
-    std::vector<std::pair<double, double>> points;
+    auto parsed = BreakpointFileFormat::read(stream);
+    if (parsed.sections.empty()) return;
 
-    for (const auto& line : lines) {
-        juce::String trimmed = line.upToFirstOccurrenceOf("#", false, false).trim();
-        if (trimmed.isEmpty()) continue;
-
-        auto tokens = juce::StringArray::fromTokens(trimmed, "\t ", "");
-        if (tokens.size() >= 2) {
-            double time = tokens[0].getDoubleValue();
-            double value = tokens[1].getDoubleValue();
-            points.emplace_back(time, value);
-        }
-    }
+    stage.addBytes(stream.getTotalLength());
+    for (const auto& section : parsed.sections)
+        stage.addBreakpoints(static_cast<juce::int64>(section.points.size()));
 
     if (featureBreakpoints.find(featureName) == featureBreakpoints.end()) {
         auto extractorIt = extractors.find(featureName);
@@ -291,25 +1247,264 @@ void AudioDeconstructorProcessor::loadBreakpoints(const juce::String& featureNam
     }
 
     auto& outputs = featureBreakpoints[featureName];
-    while (outputs.size() <= outputIndex) {
-        outputs.emplace_back();
+
+    auto assignOutput = [&](int index, BreakpointList points) {
+        while (outputs.size() <= static_cast<size_t>(index)) {
+            outputs.emplace_back();
+        }
+        outputs[index] = std::move(points);
+        sortBreakpoints(featureName, index);
+        editHistory.clearUndoHistory();
+        markEdited(featureName);
+    };
+
+    if (outputIndex >= 0) {
+        // Prefer the section named after the output; files with a single or
+        // unnamed section load into the requested output as before.
+        auto* section = parsed.findSection(getOutputName(featureName, outputIndex));
+        if (section == nullptr && parsed.sections.size() == 1)
+            section = &parsed.sections.front();
+        if (section == nullptr && static_cast<size_t>(outputIndex) < parsed.sections.size())
+            section = &parsed.sections[outputIndex];
+
+        if (section != nullptr)
+            assignOutput(outputIndex, std::move(section->points));
+        return;
+    }
+
+    for (size_t i = 0; i < parsed.sections.size(); ++i) {
+        auto& section = parsed.sections[i];
+        int index = static_cast<int>(i);
+        for (int o = 0; o < getNumOutputsForFeature(featureName); ++o) {
+            if (getOutputName(featureName, o) == section.name) {
+                index = o;
+                break;
+            }
+        }
+        assignOutput(index, std::move(section.points));
     }
+}
+
+void AudioDeconstructorProcessor::saveCompressedBreakpoints(const juce::String& featureName,
+    const juce::File& file, const BreakpointCodec::Options& options) {
+
+    ensureFeaturesRestored();
+    auto it = featureBreakpoints.find(featureName);
+    if (it == featureBreakpoints.end()) return;
 
-    outputs[outputIndex] = points;
-    sortBreakpoints(featureName, outputIndex);
+    AnalysisProfiler::ScopedStage stage(&profiler, "save compressed", featureName);
+    juce::FileOutputStream stream(file);
+    if (stream.openedOk()) {
+        stream.setPosition(0);
+        stream.truncate();
+        BreakpointCodec::writeFeature(stream, featureName, it->second, options);
+        stage.addBytes(stream.getPosition());
+        stage.addBreakpoints(countBreakpoints(it->second));
+    }
+}
+
+void AudioDeconstructorProcessor::saveControlRateBreakpoints(const juce::String& featureName,
+    const juce::File& file, ControlRateExport::Grid grid, ControlRateExport::Interpolation interpolation) {
+
+    ensureFeaturesRestored();
+    auto it = featureBreakpoints.find(featureName);
+    if (it == featureBreakpoints.end()) return;
+
+    AnalysisProfiler::ScopedStage stage(&profiler, "save control rate", featureName);
+    const auto& outputs = it->second;
+    stage.addBreakpoints(countBreakpoints(outputs));
+
+    double endTime = loadedSampleRate > 0.0 ? loadedAudio.getNumSamples() / loadedSampleRate : 0.0;
+    for (const auto& points : outputs) {
+        if (!points.empty())
+            endTime = juce::jmax(endTime, points.back().first);
+    }
+
+    ControlRateExport::File exported;
+    exported.featureName = featureName;
+    exported.sourceName = loadedFileName;
+    exported.sampleRate = loadedSampleRate;
+    double interval = grid.getInterval(loadedSampleRate);
+    if (emitsEvents(featureName))
+        interpolation = ControlRateExport::Interpolation::impulse;
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        exported.outputNames.add(getOutputName(featureName, static_cast<int>(i)));
+        exported.outputs.push_back(ControlRateExport::resample(outputs[i], interval, endTime, interpolation));
+    }
+
+    juce::FileOutputStream stream(file);
+    if (stream.openedOk()) {
+        stream.setPosition(0);
+        stream.truncate();
+        if (file.hasFileExtension("adcr"))
+            ControlRateExport::writeDense(stream, exported);
+        else
+            ControlRateExport::writeText(stream, exported);
+        stage.addBytes(stream.getPosition());
+    }
+}
+
+juce::Result AudioDeconstructorProcessor::loadCompressedBreakpoints(const juce::File& file) {
+    ensureFeaturesRestored();
+
+    AnalysisProfiler::ScopedStage stage(&profiler, "Load compressed");
+    juce::FileInputStream stream(file);
+    if (!stream.openedOk()) return juce::Result::fail("Can't read " + file.getFileName());
+
+    juce::String featureName;
+    std::vector<BreakpointList> outputs;
+    if (!BreakpointCodec::readFeature(stream, featureName, outputs))
+        return juce::Result::fail(file.getFileName() + " is not a breakpoint file");
+
+    auto extractor = extractors.find(featureName);
+    if (extractor == extractors.end())
+        return juce::Result::fail("Unknown feature: " + featureName);
+    if (outputs.size() != static_cast<size_t>(extractor->second->getNumOutputs()))
+        return juce::Result::fail(featureName + " has " + juce::String(extractor->second->getNumOutputs())
+            + " outputs, the file " + juce::String(static_cast<int>(outputs.size())));
+
+    // Everything downstream expects finite points in time order.
+    for (auto& points : outputs) {
+        for (const auto& [time, value] : points) {
+            if (!std::isfinite(time) || !std::isfinite(value))
+                return juce::Result::fail(file.getFileName() + " has points that aren't numbers");
+        }
+        std::stable_sort(points.begin(), points.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+    }
+
+    stage.addBytes(stream.getTotalLength());
+    stage.addBreakpoints(countBreakpoints(outputs));
+    featureBreakpoints[featureName] = std::move(outputs);
+    editHistory.clearUndoHistory();
+    markEdited(featureName);
+    return juce::Result::ok();
 }
 
 void AudioDeconstructorProcessor::getStateInformation(juce::MemoryBlock& destData) {
     auto state = params.copyState();
     std::unique_ptr<juce::XmlElement> xml(state.createXml());
     copyXmlToBinary(*xml, destData);
+
+    // Other threads get the tracks as of the last async update.
+    if (juce::MessageManager::existsAndIsCurrentThread())
+        updateSavedFeatureState();
+
+    // The breakpoints follow the XML block, which getXmlFromBinary ignores,
+    // so older versions still read the parameters from this state.
+    juce::MemoryOutputStream stream(destData, true);
+    const juce::ScopedLock sl(savedStateLock);
+    stream.write(savedFeatureState.getData(), savedFeatureState.getSize());
 }
 
 void AudioDeconstructorProcessor::setStateInformation(const void* data, int sizeInBytes) {
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
-    if (xmlState.get() != nullptr && xmlState->hasTagName(params.state.getType())) {
-        params.replaceState(juce::ValueTree::fromXml(*xmlState));
+    if (xmlState.get() == nullptr || !xmlState->hasTagName(params.state.getType())) return;
+
+    params.replaceState(juce::ValueTree::fromXml(*xmlState));
+    // The players pick up the saved tracks on the message thread.
+    trackSelectionPending = true;
+    triggerAsyncUpdate();
+
+    // copyXmlToBinary writes a magic number, the string length, the string
+    // and a terminating zero.
+    auto xmlSize = 9 + static_cast<int>(juce::ByteOrder::littleEndianInt(
+        juce::addBytesToPointer(data, 4)));
+    if (xmlSize <= 9 || xmlSize > sizeInBytes) return;
+
+    // A state saved without tracks restores to none rather than keeping
+    // the current ones.
+    const juce::ScopedLock sl(savedStateLock);
+    savedFeatureState.replaceAll(juce::addBytesToPointer(data, xmlSize),
+        static_cast<size_t>(sizeInBytes - xmlSize));
+    hasPendingFeatureState = true;
+}
+
+void AudioDeconstructorProcessor::writeFeatureState(juce::OutputStream& stream) const {
+    if (featureBreakpoints.empty()) return;
+
+    stream.writeInt(featureStateMagic);
+    stream.writeByte(static_cast<char>(featureStateVersion));
+    stream.writeString(loadedFileName);
+    stream.writeDouble(loadedSampleRate);
+    stream.writeCompressedInt(static_cast<int>(featureBreakpoints.size()));
+
+    for (const auto& [featureName, outputs] : featureBreakpoints)
+        BreakpointCodec::writeFeature(stream, featureName, outputs,
+            BreakpointCodec::Options::matchTextFormat());
+}
+
+bool AudioDeconstructorProcessor::readFeatureState(juce::InputStream& stream) {
+    if (stream.readInt() != featureStateMagic) return false;
+    if (stream.readByte() > featureStateVersion) return false;
+
+    auto sourceName = stream.readString();
+    auto sampleRate = stream.readDouble();
+    int numFeatures = stream.readCompressedInt();
+
+    std::map<juce::String, std::vector<std::vector<std::pair<double, double>>>> restored;
+    for (int i = 0; i < numFeatures; ++i) {
+        juce::String featureName;
+        std::vector<BreakpointList> outputs;
+        if (!BreakpointCodec::readFeature(stream, featureName, outputs)) return false;
+        if (extractors.find(featureName) != extractors.end())
+            restored[featureName] = std::move(outputs);
+    }
+
+    featureBreakpoints = std::move(restored);
+    if (!hasLoadedAudio()) {
+        loadedFileName = sourceName;
+        loadedSampleRate = sampleRate;
+    }
+    return true;
+}
+
+void AudioDeconstructorProcessor::ensureFeaturesRestored() const {
+    // Only the lazily restored breakpoints change here; the processor itself
+    // is never a const object.
+    if (hasPendingFeatureState)
+        const_cast<AudioDeconstructorProcessor*>(this)->restorePendingFeatureState();
+}
+
+void AudioDeconstructorProcessor::restorePendingFeatureState() {
+    juce::MemoryBlock state;
+    {
+        const juce::ScopedLock sl(savedStateLock);
+        if (!hasPendingFeatureState) return;
+        state = savedFeatureState;
+        hasPendingFeatureState = false;
+    }
+
+    // Until the tracks change again, the state saves as it was restored.
+    juce::MemoryInputStream stream(state, false);
+    if (state.isEmpty()) {
+        featureBreakpoints.clear();
+        publishPlaybackTrack();
+    }
+    else if (readFeatureState(stream)) {
+        publishPlaybackTrack();
+    }
+    savedStateRevision = breakpointRevision;
+}
+
+void AudioDeconstructorProcessor::discardPendingFeatureState() {
+    const juce::ScopedLock sl(savedStateLock);
+    hasPendingFeatureState = false;
+}
+
+void AudioDeconstructorProcessor::updateSavedFeatureState() {
+    if (hasPendingFeatureState || savedStateRevision == breakpointRevision) return;
+
+    juce::MemoryBlock state;
+    {
+        juce::MemoryOutputStream stream(state, false);
+        writeFeatureState(stream);
     }
+
+    const juce::ScopedLock sl(savedStateLock);
+    if (hasPendingFeatureState) return; // a state set meanwhile wins
+    savedFeatureState.swapWith(state);
+    savedStateRevision = breakpointRevision;
 }
 
 juce::AudioProcessorEditor* AudioDeconstructorProcessor::createEditor() {
@@ -4,8 +4,25 @@
 #pragma once
 #include <JuceHeader.h>
 #include "FeatureExtractors.h"
+#include "BreakpointTextIO.h"
+#include "BreakpointCodec.h"
+#include "BreakpointIndex.h"
+#include "BreakpointOperations.h"
+#include "ControlRateExport.h"
+#include "AnalysisCache.h"
+#include "AnalysisSession.h"
+#include "LiveAnalyzer.h"
+#include "BreakpointPlayer.h"
+#include "EnvelopeApplicator.h"
+#include "OfflineRenderer.h"
+#include "AnalysisProfiler.h"
+#include "FeatureBus.h"
+#include "MemoryBudget.h"
+#include "SimilarityIndex.h"
 
-class AudioDeconstructorProcessor : public juce::AudioProcessor {
+class AudioDeconstructorProcessor : public juce::AudioProcessor,
+                                    private juce::AsyncUpdater,
+                                    private juce::Timer {
 public:
     AudioDeconstructorProcessor();
     ~AudioDeconstructorProcessor() override;
@@ -40,12 +57,98 @@ public:
     const juce::AudioBuffer<float>& getLoadedAudio() const { return loadedAudio; }
     double getLoadedSampleRate() const { return loadedSampleRate; }
     juce::String getLoadedFileName() const { return loadedFileName; }
+    juce::File getLoadedFile() const { return loadedFile; }
+
+    // Session: files queued for background analysis, each keeping its own
+    // tracks. The loaded file is the one on view; loading another stores the
+    // current tracks, edits included, back into the session first. The
+    // viewed file is analysed ahead of the rest of the queue.
+    int queueFiles(const juce::Array<juce::File>& files);
+    bool selectSessionFile(const juce::File& file);
+    const AnalysisSession& getSession() const { return session; }
+    // Takes the viewed file's tracks from the session once its analysis has
+    // finished; true if it did. Message thread, polled by the editor.
+    bool collectSessionFeatures();
 
     // Feature extraction
     void extractFeature(const juce::String& featureName, int channel = 0);
     void extractAllFeatures();
     bool isFeatureExtracted(const juce::String& featureName) const;
     juce::StringArray getExtractedFeatures() const;
+    AnalysisCache& getAnalysisCache() { return analysisCache; }
+
+    // Live capture of the input bus. Starting a capture replaces the loaded
+    // audio and feature maps; breakpoints arrive as the host plays and are
+    // post-processed (normalized, smoothed) when the capture stops. A capture
+    // the host stops (prepareToPlay, releaseResources) is committed
+    // asynchronously on the message thread.
+    bool startLiveCapture();
+    void stopLiveCapture();
+    bool isLiveCapturing() const { return liveAnalyzer.isCapturing(); }
+    double getLiveCaptureSeconds() const { return liveAnalyzer.getCapturedSeconds(); }
+    // Appends breakpoints analysed since the last call; message thread only.
+    bool collectLiveBreakpoints();
+
+    // Envelope playback: renders one stored track on the "Envelope" output
+    // bus, following the host transport. A controlInterval of 0 renders every
+    // sample; otherwise the envelope is evaluated every controlInterval
+    // samples and ramped in between. The track follows later edits.
+    void setPlaybackTrack(const juce::String& featureName, int outputIndex, int controlInterval = 0);
+    void clearPlaybackTrack();
+    juce::String getPlaybackFeature() const { return playbackFeature; }
+    float getPlaybackValue() const { return envelopePlayer.getLastValue(); }
+
+    // Mirror mode: applies a stored track to the audio passing through, as
+    // gain or pan depending on the "mirrorMode" parameter. Only set while
+    // the mode is on, so a restore with mirroring off decodes nothing.
+    void setMirrorTrack(const juce::String& featureName, int outputIndex);
+    void clearMirrorTrack();
+    bool isMirrorOn() const;
+    // Both selections are saved with the plugin state.
+    juce::String getMirrorFeature() const;
+    int getMirrorOutput() const;
+
+    // Offline rendering: copies a stored track into a modulation for
+    // OfflineRenderer::render, which can then run on any thread.
+    juce::Result makeRenderModulation(const juce::String& featureName, int outputIndex,
+        OfflineRenderer::Target target, OfflineRenderer::Modulation& modulation);
+
+    // Instrumentation: wall time, frames, bytes produced and breakpoint
+    // counts per pipeline stage since the last file was loaded. Off by
+    // default; the editor times its own display copy through getProfiler().
+    void setProfilingEnabled(bool shouldBeEnabled) { profiler.setEnabled(shouldBeEnabled); }
+    bool isProfilingEnabled() const { return profiler.isEnabled(); }
+    std::vector<AnalysisProfiler::Stage> getProfileStages() const { return profiler.getStages(); }
+    juce::String getProfileSummary() const { return profiler.getSummary(); }
+    void resetProfile() { profiler.reset(); }
+    AnalysisProfiler& getProfiler() { return profiler; }
+
+    // Memory budget: decoded audio, analysis data and tracks are counted
+    // against a limit kept in the plugin state (MemoryBudget::unlimited turns
+    // it off). Going over spills the tracks of session files not on view to
+    // disk, least recently viewed first, then drops raw stages and shared
+    // analysis data, which are rebuilt on demand. The processor checks it
+    // whenever tracks are replaced or a session file finishes, editor or not;
+    // message thread.
+    void setMemoryBudget(juce::int64 bytes);
+    juce::int64 getMemoryBudget() const;
+    MemoryBudget::Usage getMemoryUsage() const;
+    void enforceMemoryBudget();
+
+    // Feature bus: shares every stored track with effector plugins and other
+    // processes on this machine through a memory-mapped file (FeatureBus.h).
+    // Every change to the tracks is republished from the async update,
+    // editor or not; message thread only.
+    bool setFeatureBusEnabled(bool shouldBeEnabled);
+    bool isFeatureBusEnabled() const { return featureBus != nullptr; }
+    juce::String getFeatureBusName() const { return featureBus != nullptr ? featureBus->getName() : juce::String(); }
+
+    // Similarity search: the regions of the session files, the viewed one
+    // included, whose tracks look most like startTime..endTime of the viewed
+    // tracks. Session files are indexed in the background as they finish, so
+    // a search only indexes the viewed file again after an edit; message
+    // thread only.
+    SimilarityIndex::SearchResult findSimilarRegions(double startTime, double endTime, int numMatches = 10);
 
     // Feature information
     juce::StringArray getAvailableFeatures() const;
@@ -56,21 +159,93 @@ public:
     // Breakpoint access 
     std::vector<std::pair<double, double>> getBreakpointsForDisplay(
         const juce::String& featureName, int outputIndex = 0) const;
+    // Every stored track, read in place on the message thread. The revision
+    // changes whenever any track does, including when a saved state is
+    // restored on first read, so check it before using earlier references.
+    const std::map<juce::String, std::vector<BreakpointList>>& getAllBreakpoints() const;
+    juce::uint32 getBreakpointRevision() const;
 
-    // Breakpoint editing 
+    // Range queries, message thread only. Each track's time index is built
+    // on first use after it changes; spans point into the stored breakpoints
+    // and are valid until the next change.
+    struct TrackRange {
+        juce::String featureName;
+        int outputIndex = 0;
+        BreakpointSpan points;
+        BreakpointIndex::Summary summary;
+    };
+    const BreakpointIndex* getTrackIndex(const juce::String& featureName, int outputIndex) const;
+    BreakpointSpan getBreakpointsInRange(const juce::String& featureName, int outputIndex,
+        double startTime, double endTime) const;
+    // Every output of the given features (all stored features if empty).
+    std::vector<TrackRange> queryRange(const juce::StringArray& featureNames,
+        double startTime, double endTime) const;
+
+    // Breakpoint editing. Points stay sorted by time; updateBreakpoint moves
+    // the point to its new place and returns its index there.
     void addBreakpoint(const juce::String& featureName, int outputIndex,
         double time, double value);
-    void updateBreakpoint(const juce::String& featureName, int outputIndex,
+    size_t updateBreakpoint(const juce::String& featureName, int outputIndex,
         size_t pointIndex, double time, double value);
     void removeBreakpoint(const juce::String& featureName, int outputIndex,
         size_t pointIndex);
 
+    // Undo history of the edits above, kept as one small delta per edit. The
+    // updates between beginEditGesture() and endEditGesture(), such as a drag,
+    // coalesce into one step. Older steps are dropped beyond undoHistoryBytes,
+    // and the history is cleared whenever tracks are replaced wholesale
+    // (extraction, loading, live capture, restoring state).
+    void beginEditGesture();
+    void endEditGesture();
+    bool undoEdit();
+    bool redoEdit();
+    bool canUndoEdit() const { return editHistory.canUndo(); }
+    bool canRedoEdit() const { return editHistory.canRedo(); }
+
+    static constexpr int undoHistoryBytes = 4 * 1024 * 1024;
+
+    // Bulk edits of the points of one output from startTime to endTime, each
+    // one undo step. stretchRange carries the points after the range along,
+    // resampleRange replaces the range with numPoints evenly spaced points and
+    // crossfadeRange fades from the track into another one across the range.
+    bool scaleRange(const juce::String& featureName, int outputIndex, double startTime, double endTime,
+        double factor, double pivot = 0.0);
+    bool offsetRange(const juce::String& featureName, int outputIndex, double startTime, double endTime,
+        double amount);
+    bool clampRange(const juce::String& featureName, int outputIndex, double startTime, double endTime,
+        double low, double high);
+    bool invertRange(const juce::String& featureName, int outputIndex, double startTime, double endTime);
+    bool quantizeRange(const juce::String& featureName, int outputIndex, double startTime, double endTime,
+        double step);
+    bool stretchRange(const juce::String& featureName, int outputIndex, double startTime, double endTime,
+        double factor);
+    bool resampleRange(const juce::String& featureName, int outputIndex, double startTime, double endTime,
+        int numPoints);
+    bool crossfadeRange(const juce::String& featureName, int outputIndex, double startTime, double endTime,
+        const juce::String& otherFeature, int otherOutput);
+
     // File I/O
     void saveBreakpoints(const juce::String& featureName, const juce::File& file);
     void saveAllBreakpoints(const juce::File& directory);
+    // Loads the "# OutputName" section matching outputIndex, or every section
+    // into its matching output when outputIndex is -1.
     void loadBreakpoints(const juce::String& featureName, int outputIndex,
         const juce::File& file);
 
+    // Compressed binary breakpoint files (.adbp). Loading replaces the
+    // feature the file names; it must have that feature's outputs and finite
+    // points, which are put in time order.
+    void saveCompressedBreakpoints(const juce::String& featureName, const juce::File& file,
+        const BreakpointCodec::Options& options = BreakpointCodec::Options::matchTextFormat());
+    juce::Result loadCompressedBreakpoints(const juce::File& file);
+
+    // Every output resampled onto a fixed control-rate grid, from 0 to the end
+    // of the audio or the last point. Dense binary for .adcr, text otherwise.
+    // Event features are always written as impulses.
+    void saveControlRateBreakpoints(const juce::String& featureName, const juce::File& file,
+        ControlRateExport::Grid grid = {},
+        ControlRateExport::Interpolation interpolation = ControlRateExport::Interpolation::linear);
+
     juce::AudioProcessorValueTreeState params;
 
 private:
@@ -78,14 +253,122 @@ private:
     double loadedSampleRate = 44100.0;
     juce::String loadedFileName;
 
+    AnalysisProfiler profiler;
+
     std::map<juce::String, std::unique_ptr<FeatureExtractor>> extractors;
     std::map<juce::String, std::vector<std::vector<std::pair<double, double>>>> featureBreakpoints;
+    // Bumped, and the feature's indexes dropped, by every path that changes
+    // featureBreakpoints; all of them republish the playback tracks.
+    juce::uint32 breakpointRevision = 0;
+    mutable std::map<juce::String, std::vector<std::unique_ptr<BreakpointIndex>>> trackIndexes;
+
+    class BreakpointEdit;
+    class RangeEdit;
+    juce::UndoManager editHistory{ undoHistoryBytes, 1 };
+    bool editGestureActive = false;
+
+    std::unique_ptr<FeatureBus::Writer> featureBus;
+    juce::uint32 featureBusRevision = 0;
+
+    // Declared before the session, whose workers add to it.
+    SimilarityIndex similarityIndex;
+    juce::File similarityFile; // the viewed file as last indexed
+    juce::uint32 similarityRevision = 0;
+
+    AnalysisCache analysisCache{ AnalysisCache::getDefaultDirectory() };
+    AnalysisSession session{ analysisCache };
+    juce::File loadedFile;
+    bool sessionFeaturesPending = false;
+    juce::uint64 loadedAudioHash = 0;
+
+    // Extraction runs as a chain of stages: audio -> shared frame statistics
+    // -> raw extractor output -> post-processed output -> edited breakpoints.
+    // Each stage remembers the key of the inputs it was built from and is
+    // only rebuilt when that key changes; edits only touch the last stage.
+    struct FeatureStages {
+        juce::uint64 rawKey = 0;
+        std::vector<BreakpointList> raw;
+        juce::uint64 postKey = 0;
+        bool edited = false;
+    };
+    std::map<juce::String, FeatureStages> featureStages;
+
+    std::unique_ptr<FrameStatistics> frameStatistics;
+    juce::uint64 frameStatisticsKey = 0;
+    std::unique_ptr<AnalysisPyramid> analysisPyramid;
+
+    LiveAnalyzer liveAnalyzer;
+
+    BreakpointPlayer envelopePlayer;
+    juce::String playbackFeature;
+    int playbackOutput = 0;
+    juce::int64 freeRunningSamples = 0;
+
+    EnvelopeApplicator mirror;
+    juce::String mirrorFeature;
+    int mirrorOutput = 0;
+    std::atomic<float>* mirrorModeParameter = nullptr;
+    std::atomic<float>* mirrorDepthParameter = nullptr;
 
     std::atomic<bool> isAnalyzing{ false };
+    std::atomic<bool> liveCaptureStopped{ false }; // by the host, not yet committed
+    std::atomic<bool> trackSelectionPending{ false }; // restored, not yet applied
     std::atomic<float> analysisProgress{ 0.0f };
 
+    // The breakpoints as getStateInformation writes them, which hosts may
+    // call from any thread. What setStateInformation gets stays encoded here
+    // until something first asks for it, so restoring a session doesn't
+    // decode every track; after that the message thread re-encodes the
+    // tracks once breakpointRevision has moved past savedStateRevision and
+    // stayed put for savedStateDelayMs, so a drag isn't encoded per move.
+    // getStateInformation on the message thread doesn't wait.
+    juce::CriticalSection savedStateLock;
+    juce::MemoryBlock savedFeatureState;
+    juce::uint32 savedStateRevision = 0;
+    std::atomic<bool> hasPendingFeatureState{ false };
+    static constexpr int savedStateDelayMs = 500;
+
+    static constexpr int featureStateMagic = 0x53464441; // "ADFS"
+    static constexpr int featureStateVersion = 1;
+
+    void handleAsyncUpdate() override;
+    void timerCallback() override;
+    void stopLiveCaptureFromHost();
+    void commitLiveCapture();
+    void restoreTrackSelection();
+    void updateFeatureBus();
     void initializeExtractors();
+    FeatureExtractor::Settings getSettingsFromParameters() const;
+    juce::uint64 getLoadedAudioHash();
+    const FrameStatistics& getFrameStatistics(const FeatureExtractor::Settings& settings);
+    const AnalysisPyramid& getAnalysisPyramid();
+    void invalidateAnalysis();
+    // An outputIndex of -1 means every output changed; otherwise only points
+    // [first, last) of it did, or all from first on if their number changed.
+    void markEdited(const juce::String& featureName, int outputIndex = -1, size_t first = 0,
+        size_t last = SIZE_MAX);
+    void storeSessionFeatures();
+    bool emitsEvents(const juce::String& featureName) const;
+    std::unique_ptr<EnvelopeTrack> makeEnvelopeTrack(const juce::String& featureName, int outputIndex) const;
+    void publishPlaybackTrack();
+    void refreshPlaybackTrack(const juce::String& featureName, int outputIndex = -1, size_t first = 0,
+        size_t last = SIZE_MAX);
+    double getBlockStartTime(int numSamples);
     void sortBreakpoints(const juce::String& featureName, int outputIndex);
+    BreakpointList* findTrack(const juce::String& featureName, int outputIndex);
+    bool moveBreakpoint(const juce::String& featureName, int outputIndex, size_t from, size_t to,
+        std::pair<double, double> point);
+    bool editRange(const juce::String& featureName, int outputIndex, double startTime, double endTime,
+        const std::function<void(BreakpointOperations::Columns&)>& operation);
+    bool replaceRange(const juce::String& featureName, int outputIndex, size_t first, size_t last,
+        BreakpointList points);
+
+    void writeFeatureState(juce::OutputStream& stream) const;
+    bool readFeatureState(juce::InputStream& stream);
+    void ensureFeaturesRestored() const;
+    void restorePendingFeatureState();
+    void discardPendingFeatureState();
+    void updateSavedFeatureState();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioDeconstructorProcessor)
 };
\ No newline at end of file
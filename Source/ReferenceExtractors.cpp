@@ -0,0 +1,319 @@
+// ReferenceExtractors.cpp
+
+#include "ReferenceExtractors.h"
+
+namespace {
+
+using Outputs = std::vector<std::vector<std::pair<double, double>>>;
+
+struct FrameSums {
+    float sumSquares = 0.0f;
+    float sumAbs = 0.0f;
+    float peak = 0.0f;
+};
+
+FrameSums sumFrame(const float* data, int start, int end) {
+    FrameSums sums;
+    for (int i = start; i < end; ++i) {
+        float sample = data[i];
+        sums.sumSquares += sample * sample;
+        float absSample = std::abs(sample);
+        sums.sumAbs += absSample;
+        if (absSample > sums.peak) sums.peak = absSample;
+    }
+    return sums;
+}
+
+void getWindowAndHop(const FeatureExtractor::Settings& settings, double sampleRate,
+    int& windowSamples, int& hopSamples) {
+
+    windowSamples = static_cast<int>(settings.windowSizeMs * sampleRate / 1000.0f);
+    hopSamples = std::max(1, static_cast<int>(windowSamples * settings.hopSizePct / 100.0f));
+    if (windowSamples == 0) windowSamples = 1;
+}
+
+} // namespace
+
+std::unique_ptr<FeatureExtractor> ReferenceExtractors::create(const juce::String& name) {
+    if (name == "Amplitude") return std::make_unique<ReferenceAmplitudeExtractor>();
+    if (name == "Panning") return std::make_unique<ReferencePanningExtractor>();
+    if (name == "Spectral") return std::make_unique<ReferenceSpectralExtractor>();
+    if (name == "Pitch") return std::make_unique<ReferencePitchExtractor>();
+    if (name == "Transients") return std::make_unique<ReferenceTransientExtractor>();
+    return nullptr;
+}
+
+Outputs ReferenceAmplitudeExtractor::extractRaw(const juce::AudioBuffer<float>& buffer,
+    double sampleRate, int channel) {
+
+    Outputs results(2);
+    if (channel < 0 || channel >= buffer.getNumChannels())
+        return results;
+
+    int windowSamples, hopSamples;
+    getWindowAndHop(settings, sampleRate, windowSamples, hopSamples);
+
+    const float* data = buffer.getReadPointer(channel);
+    int numSamples = buffer.getNumSamples();
+
+    for (int start = 0; start < numSamples; start += hopSamples) {
+        int end = std::min(start + windowSamples, numSamples);
+        auto sums = sumFrame(data, start, end);
+
+        double time = start / sampleRate;
+        results[0].push_back({ time, std::sqrt(sums.sumSquares / (end - start)) });
+        results[1].push_back({ time, sums.peak });
+    }
+    return results;
+}
+
+Outputs ReferencePanningExtractor::extractRaw(const juce::AudioBuffer<float>& buffer,
+    double sampleRate, int) {
+
+    Outputs results(3);
+
+    if (buffer.getNumChannels() < 2) {
+        for (auto& output : results)
+            output.push_back({ 0.0, 0.0 });
+        return results;
+    }
+
+    int windowSamples, hopSamples;
+    getWindowAndHop(settings, sampleRate, windowSamples, hopSamples);
+
+    const float* leftData = buffer.getReadPointer(0);
+    const float* rightData = buffer.getReadPointer(1);
+    int numSamples = buffer.getNumSamples();
+
+    for (int start = 0; start < numSamples; start += hopSamples) {
+        int end = std::min(start + windowSamples, numSamples);
+        int length = end - start;
+        double time = start / sampleRate;
+
+        auto left = sumFrame(leftData, start, end);
+        auto right = sumFrame(rightData, start, end);
+
+        float crossProduct = 0.0f;
+        for (int i = start; i < end; ++i)
+            crossProduct += leftData[i] * rightData[i];
+
+        float totalSum = left.sumAbs + right.sumAbs;
+        float pan = totalSum > 0.0f ? (right.sumAbs - left.sumAbs) / totalSum : 0.0f;
+
+        float leftRMS = std::sqrt(left.sumSquares / length);
+        float rightRMS = std::sqrt(right.sumSquares / length);
+        float denom = leftRMS * rightRMS;
+        float corr = denom > 0.0f ? crossProduct / (length * denom) : 0.0f;
+        float width = 1.0f - (corr * 0.5f + 0.5f);
+
+        float totalRMS = leftRMS + rightRMS;
+        float balance = totalRMS > 0.0f ? (rightRMS - leftRMS) / totalRMS : 0.0f;
+
+        results[0].push_back({ time, pan });
+        results[1].push_back({ time, width });
+        results[2].push_back({ time, balance });
+    }
+    return results;
+}
+
+Outputs ReferenceSpectralExtractor::extractRaw(const juce::AudioBuffer<float>& buffer,
+    double sampleRate, int channel) {
+
+    Outputs results(4);
+
+    const float* data = buffer.getReadPointer(channel);
+    int numSamples = buffer.getNumSamples();
+    int hopSamples = size / 2;
+
+    std::vector<float> fftData(size * 2, 0.0f);
+    std::vector<float> magnitudes(size / 2);
+    std::vector<float> previousMagnitudes;
+
+    for (int start = 0; start <= numSamples - size; start += hopSamples) {
+        double time = start / sampleRate;
+
+        for (int i = 0; i < size; ++i) {
+            float window = 0.5f * (1.0f - std::cos(2.0f * juce::MathConstants<float>::pi * i / size));
+            fftData[i] = data[start + i] * window;
+        }
+
+        referenceFft.performFrequencyOnlyForwardTransform(fftData.data());
+
+        for (int i = 0; i < size / 2; ++i) {
+            float real = fftData[i * 2];
+            float imag = fftData[i * 2 + 1];
+            magnitudes[i] = std::sqrt(real * real + imag * imag);
+        }
+
+        float weightedSum = 0.0f, totalSum = 0.0f;
+        for (size_t i = 0; i < magnitudes.size(); ++i) {
+            float freq = i * sampleRate / (size * 2.0f);
+            weightedSum += freq * magnitudes[i];
+            totalSum += magnitudes[i];
+        }
+        float centroid = totalSum > 0.0f ? weightedSum / totalSum : 0.0f;
+
+        float flux = 0.0f;
+        if (!previousMagnitudes.empty()) {
+            float sum = 0.0f;
+            for (size_t i = 0; i < magnitudes.size(); ++i) {
+                float diff = magnitudes[i] - previousMagnitudes[i];
+                sum += diff * diff;
+            }
+            flux = std::sqrt(sum / magnitudes.size());
+        }
+
+        float logSum = 0.0f, linearSum = 0.0f;
+        int count = 0;
+        for (auto mag : magnitudes) {
+            if (mag > 0.0f) {
+                logSum += std::log(mag);
+                linearSum += mag;
+                count++;
+            }
+        }
+        float flatness = 0.0f;
+        if (count > 0) {
+            float geometricMean = std::exp(logSum / count);
+            float arithmeticMean = linearSum / count;
+            flatness = arithmeticMean > 0.0f ? geometricMean / arithmeticMean : 0.0f;
+        }
+
+        float threshold = totalSum * 0.85f;
+        float cumulativeEnergy = 0.0f;
+        float rolloff = static_cast<float>(sampleRate / 2.0f);
+        for (size_t i = 0; i < magnitudes.size(); ++i) {
+            cumulativeEnergy += magnitudes[i];
+            if (cumulativeEnergy >= threshold) {
+                rolloff = static_cast<float>(i * sampleRate / (size * 2.0f));
+                break;
+            }
+        }
+
+        results[0].push_back({ time, centroid });
+        results[1].push_back({ time, flux });
+        results[2].push_back({ time, flatness });
+        results[3].push_back({ time, rolloff });
+
+        previousMagnitudes = magnitudes;
+    }
+    return results;
+}
+
+Outputs ReferencePitchExtractor::extractRaw(const juce::AudioBuffer<float>& buffer,
+    double sampleRate, int channel) {
+
+    Outputs results(2);
+
+    const float* data = buffer.getReadPointer(channel);
+    int numSamples = buffer.getNumSamples();
+
+    int windowSamples = static_cast<int>(0.05 * sampleRate);
+    int hopSamples = windowSamples / 2;
+    int minLag = static_cast<int>(sampleRate / 1000.0);
+    int maxLag = static_cast<int>(sampleRate / 50.0);
+
+    std::vector<float> correlation(static_cast<size_t>(maxLag - minLag));
+
+    for (int start = 0; start < numSamples - windowSamples; start += hopSamples) {
+        const float* frame = data + start;
+
+        // Plain time-domain autocorrelation over every candidate lag.
+        for (int lag = minLag; lag < maxLag; ++lag) {
+            float sum = 0.0f;
+            for (int i = 0; i < windowSamples - lag; ++i)
+                sum += frame[i] * frame[i + lag];
+            correlation[static_cast<size_t>(lag - minLag)] = sum;
+        }
+
+        auto maxIt = std::max_element(correlation.begin(), correlation.end());
+        int peakLag = static_cast<int>(std::distance(correlation.begin(), maxIt)) + minLag;
+
+        float freq = static_cast<float>(sampleRate / peakLag);
+        float confidence = *maxIt / correlation[0];
+
+        double time = start / sampleRate;
+        results[0].push_back({ time, freq });
+        results[1].push_back({ time, std::max(0.0f, std::min(1.0f, confidence)) });
+    }
+    return results;
+}
+
+Outputs ReferenceTransientExtractor::extractRaw(const juce::AudioBuffer<float>& buffer,
+    double sampleRate, int channel) {
+
+    Outputs results(1);
+
+    const float* data = buffer.getReadPointer(channel);
+    int numSamples = buffer.getNumSamples();
+
+    int order = getFftOrder(sampleRate);
+    int size = 1 << order;
+    int hop = size / 4;
+    int numBins = size / 2;
+    int numFrames = (numSamples + hop - 1) / hop;
+
+    juce::dsp::FFT transform(order);
+    std::vector<float> fftData(static_cast<size_t>(size) * 2);
+    std::vector<std::vector<float>> spectra;
+    std::vector<float> flux;
+
+    for (int frame = 0; frame < numFrames; ++frame) {
+        std::fill(fftData.begin(), fftData.end(), 0.0f);
+        for (int i = 0; i < size; ++i) {
+            int index = frame * hop - size / 2 + i;
+            if (index < 0 || index >= numSamples) continue;
+            float window = 0.5f * (1.0f - std::cos(2.0f * juce::MathConstants<float>::pi * i / size));
+            fftData[static_cast<size_t>(i)] = data[index] * window;
+        }
+        transform.performFrequencyOnlyForwardTransform(fftData.data());
+
+        std::vector<float> current(static_cast<size_t>(numBins));
+        for (int k = 0; k < numBins; ++k)
+            current[static_cast<size_t>(k)] = std::log1p(compression * 4.0f / size * fftData[static_cast<size_t>(k)]);
+
+        float total = 0.0f;
+        for (int b = 0; b < numBands; ++b) {
+            int first = b == 0 ? 0 : numBins >> (numBands - b);
+            int last = b == numBands - 1 ? numBins : numBins >> (numBands - b - 1);
+            if (last <= first) continue;
+
+            float rise = 0.0f;
+            for (int k = first; k < last; ++k) {
+                float reference = 0.0f;
+                if (frame >= fluxLag) {
+                    const auto& lagged = spectra[static_cast<size_t>(frame - fluxLag)];
+                    for (int j = std::max(0, k - 1); j <= std::min(numBins - 1, k + 1); ++j)
+                        reference = std::max(reference, lagged[static_cast<size_t>(j)]);
+                }
+                rise += std::max(0.0f, current[static_cast<size_t>(k)] - reference);
+            }
+            total += rise / (last - first);
+        }
+        flux.push_back(total / numBands);
+        spectra.push_back(current);
+    }
+
+    for (int n = 0; n < numFrames; ++n) {
+        float value = flux[static_cast<size_t>(n)];
+
+        bool isPeak = true;
+        for (int i = n - peakBefore; i <= n + peakAfter; ++i) {
+            if (i < 0 || i >= numFrames || i == n) continue;
+            float other = flux[static_cast<size_t>(i)];
+            if (i < n ? other >= value : other > value) isPeak = false;
+        }
+
+        std::vector<float> neighbours;
+        for (int i = n - medianBefore; i <= n + medianAfter; ++i) {
+            if (i >= 0 && i < numFrames)
+                neighbours.push_back(flux[static_cast<size_t>(i)]);
+        }
+        std::sort(neighbours.begin(), neighbours.end());
+        float threshold = thresholdOffset + thresholdScale * neighbours[neighbours.size() / 2];
+
+        if (isPeak && value > thresholdOffset && value > threshold)
+            results[0].push_back({ static_cast<double>(n) * hop / sampleRate, value });
+    }
+    return results;
+}
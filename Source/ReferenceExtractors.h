@@ -0,0 +1,53 @@
+// ReferenceExtractors.h
+#pragma once
+
+#include <JuceHeader.h>
+#include "FeatureExtractors.h"
+
+// Frozen scalar copies of each extractor's raw analysis, kept as the oracle
+// the production code is checked against when it is optimised. They derive
+// from the production classes only for names, outputs and post-processing;
+// extractRaw here must not change when FeatureExtractors.cpp does.
+class ReferenceExtractors {
+public:
+    // nullptr for names with no reference.
+    static std::unique_ptr<FeatureExtractor> create(const juce::String& name);
+};
+
+class ReferenceAmplitudeExtractor : public AmplitudeExtractor {
+public:
+    bool usesFrameStatistics() const override { return false; }
+    std::vector<std::vector<std::pair<double, double>>> extractRaw(const juce::AudioBuffer<float>& buffer,
+        double sampleRate, int channel = 0) override;
+};
+
+class ReferencePanningExtractor : public PanningExtractor {
+public:
+    bool usesFrameStatistics() const override { return false; }
+    std::vector<std::vector<std::pair<double, double>>> extractRaw(const juce::AudioBuffer<float>& buffer,
+        double sampleRate, int channel = 0) override;
+};
+
+class ReferenceSpectralExtractor : public SpectralExtractor {
+public:
+    std::vector<std::vector<std::pair<double, double>>> extractRaw(const juce::AudioBuffer<float>& buffer,
+        double sampleRate, int channel = 0) override;
+
+private:
+    static constexpr int order = 11;
+    static constexpr int size = 1 << order;
+    juce::dsp::FFT referenceFft{ order };
+};
+
+class ReferencePitchExtractor : public PitchExtractor {
+public:
+    bool usesAnalysisPyramid() const override { return false; }
+    std::vector<std::vector<std::pair<double, double>>> extractRaw(const juce::AudioBuffer<float>& buffer,
+        double sampleRate, int channel = 0) override;
+};
+
+class ReferenceTransientExtractor : public TransientExtractor {
+public:
+    std::vector<std::vector<std::pair<double, double>>> extractRaw(const juce::AudioBuffer<float>& buffer,
+        double sampleRate, int channel = 0) override;
+};
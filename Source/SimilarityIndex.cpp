@@ -0,0 +1,421 @@
+// SimilarityIndex.cpp
+#include "SimilarityIndex.h"
+#include "BreakpointOperations.h"
+
+bool SimilarityIndex::TrackKey::operator<(const TrackKey& other) const {
+    if (featureName != other.featureName) return featureName < other.featureName;
+    return outputIndex < other.outputIndex;
+}
+
+SimilarityIndex::SimilarityIndex()
+    : SimilarityIndex(Options()) {}
+
+SimilarityIndex::SimilarityIndex(Options o)
+    : options(o) {
+    // Windows start every half window and must begin on a piece boundary.
+    options.pointsPerTrack = juce::jmax(2 * pieceSize,
+        (options.pointsPerTrack + 2 * pieceSize - 1) / (2 * pieceSize) * (2 * pieceSize));
+}
+
+void SimilarityIndex::setIgnoredFeatures(const juce::StringArray& featureNames) {
+    const juce::ScopedLock sl(lock);
+    ignoredFeatures = featureNames;
+}
+
+std::vector<SimilarityIndex::TrackKey> SimilarityIndex::getTrackKeys(const FeatureMap& features) const {
+    std::vector<TrackKey> keys;
+    for (const auto& [featureName, outputs] : features) {
+        if (ignoredFeatures.contains(featureName)) continue;
+        for (size_t i = 0; i < outputs.size(); ++i) {
+            if (!outputs[i].empty())
+                keys.push_back({ featureName, static_cast<int>(i) });
+        }
+    }
+    return keys;
+}
+
+void SimilarityIndex::sampleTrack(const BreakpointList& points, double step, int numPoints, double startTime,
+    float* dest) {
+
+    std::vector<double> times(static_cast<size_t>(numPoints));
+    std::vector<double> values(static_cast<size_t>(numPoints));
+    for (int i = 0; i < numPoints; ++i)
+        times[static_cast<size_t>(i)] = startTime + step * i;
+
+    BreakpointOperations::sample(points, times.data(), values.data(), numPoints);
+    for (int i = 0; i < numPoints; ++i)
+        dest[i] = static_cast<float>(values[static_cast<size_t>(i)]);
+}
+
+void SimilarityIndex::setSource(const juce::File& file, const FeatureMap& features) {
+    std::vector<TrackKey> keys;
+    {
+        const juce::ScopedLock sl(lock);
+        keys = getTrackKeys(features);
+    }
+    if (keys.empty()) {
+        removeSource(file);
+        return;
+    }
+
+    double duration = 0.0;
+    for (const auto& key : keys)
+        duration = juce::jmax(duration, features.at(key.featureName)[static_cast<size_t>(key.outputIndex)].back().first);
+
+    // Sampled outside the lock; only the swap and the encoding hold it.
+    auto source = std::make_unique<Source>();
+    source->file = file;
+    int numPoints = options.pointsPerTrack;
+    for (const auto& key : keys) {
+        const auto& points = features.at(key.featureName)[static_cast<size_t>(key.outputIndex)];
+        auto& track = source->tracks[key];
+
+        for (int s = 0; s < numScales; ++s) {
+            double step = scales[s] / numPoints;
+            auto& values = track.grids[static_cast<size_t>(s)].values;
+            values.resize(static_cast<size_t>(std::floor(duration / step)) + 1);
+            sampleTrack(points, step, static_cast<int>(values.size()), 0.0, values.data());
+        }
+        for (auto value : track.grids[0].values) {
+            track.sum += value;
+            track.sumSquares += static_cast<double>(value) * value;
+        }
+        track.count = static_cast<double>(track.grids[0].values.size());
+    }
+
+    const juce::ScopedLock sl(lock);
+    for (int s = 0; s < numScales; ++s) {
+        for (auto& [key, track] : source->tracks) {
+            auto it = codebooks[static_cast<size_t>(s)].find(key);
+            if (it != codebooks[static_cast<size_t>(s)].end())
+                encode(track.grids[static_cast<size_t>(s)], it->second);
+        }
+    }
+
+    auto existing = std::find_if(sources.begin(), sources.end(),
+        [&file](const auto& other) { return other->file == file; });
+    if (existing != sources.end())
+        *existing = std::move(source);
+    else
+        sources.push_back(std::move(source));
+}
+
+void SimilarityIndex::removeSource(const juce::File& file) {
+    const juce::ScopedLock sl(lock);
+    sources.erase(std::remove_if(sources.begin(), sources.end(),
+        [&file](const auto& source) { return source->file == file; }), sources.end());
+}
+
+void SimilarityIndex::clear() {
+    const juce::ScopedLock sl(lock);
+    sources.clear();
+    for (auto& scaleCodebooks : codebooks)
+        scaleCodebooks.clear();
+}
+
+int SimilarityIndex::getNumSources() const {
+    const juce::ScopedLock sl(lock);
+    return static_cast<int>(sources.size());
+}
+
+juce::int64 SimilarityIndex::getMemoryBytes() const {
+    const juce::ScopedLock sl(lock);
+    juce::int64 bytes = 0;
+    for (const auto& source : sources) {
+        for (const auto& [key, track] : source->tracks) {
+            for (const auto& grid : track.grids)
+                bytes += static_cast<juce::int64>(grid.values.capacity() * sizeof(float) + grid.codes.capacity());
+        }
+    }
+    for (const auto& scaleCodebooks : codebooks) {
+        for (const auto& [key, codebook] : scaleCodebooks)
+            bytes += static_cast<juce::int64>(codebook.centroids.capacity() * sizeof(float));
+    }
+    return bytes;
+}
+
+int SimilarityIndex::getNumWindows(const Grid& grid) const {
+    int numPoints = options.pointsPerTrack;
+    int size = static_cast<int>(grid.values.size());
+    return size < numPoints ? 0 : (size - numPoints) / (numPoints / 2) + 1;
+}
+
+float SimilarityIndex::squaredDistance(const float* a, const float* b, int size) {
+    // Plain enough for the compiler to vectorise; FloatVectorOperations has
+    // no reduction to build it from.
+    float sum = 0.0f;
+    for (int i = 0; i < size; ++i) {
+        float difference = a[i] - b[i];
+        sum += difference * difference;
+    }
+    return sum;
+}
+
+int SimilarityIndex::nearestCentroid(const Codebook& codebook, const float* piece) {
+    int best = 0;
+    float bestDistance = std::numeric_limits<float>::max();
+    for (int c = 0; c < codebook.numCentroids; ++c) {
+        float distance = squaredDistance(piece, codebook.centroids.data() + c * pieceSize, pieceSize);
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            best = c;
+        }
+    }
+    return best;
+}
+
+void SimilarityIndex::encode(Grid& grid, const Codebook& codebook) {
+    size_t numPieces = grid.values.size() / pieceSize;
+    grid.codes.resize(numPieces);
+    for (size_t p = 0; p < numPieces; ++p)
+        grid.codes[p] = static_cast<juce::uint8>(nearestCentroid(codebook, grid.values.data() + p * pieceSize));
+}
+
+SimilarityIndex::Codebook SimilarityIndex::trainCodebook(const std::vector<float>& pieces) {
+    int numPieces = static_cast<int>(pieces.size() / pieceSize);
+    Codebook codebook;
+    codebook.numCentroids = juce::jmin(maxCentroids, numPieces);
+    codebook.centroids.resize(static_cast<size_t>(codebook.numCentroids) * pieceSize);
+    if (codebook.numCentroids == 0) return codebook;
+
+    // k-means, started from pieces spread evenly over the sample.
+    for (int c = 0; c < codebook.numCentroids; ++c) {
+        size_t piece = static_cast<size_t>(static_cast<juce::int64>(c) * numPieces / codebook.numCentroids);
+        std::copy_n(pieces.data() + piece * pieceSize, pieceSize, codebook.centroids.data() + c * pieceSize);
+    }
+
+    std::vector<float> sums(codebook.centroids.size());
+    std::vector<int> counts(static_cast<size_t>(codebook.numCentroids));
+    for (int iteration = 0; iteration < trainingIterations; ++iteration) {
+        std::fill(sums.begin(), sums.end(), 0.0f);
+        std::fill(counts.begin(), counts.end(), 0);
+        for (int p = 0; p < numPieces; ++p) {
+            const float* values = pieces.data() + static_cast<size_t>(p) * pieceSize;
+            int c = nearestCentroid(codebook, values);
+            for (int i = 0; i < pieceSize; ++i)
+                sums[static_cast<size_t>(c * pieceSize + i)] += values[i];
+            ++counts[static_cast<size_t>(c)];
+        }
+
+        // An empty cluster keeps its old centroid.
+        for (int c = 0; c < codebook.numCentroids; ++c) {
+            if (counts[static_cast<size_t>(c)] == 0) continue;
+            for (int i = 0; i < pieceSize; ++i)
+                codebook.centroids[static_cast<size_t>(c * pieceSize + i)]
+                    = sums[static_cast<size_t>(c * pieceSize + i)] / static_cast<float>(counts[static_cast<size_t>(c)]);
+        }
+    }
+    return codebook;
+}
+
+void SimilarityIndex::trainIfNeeded() {
+    if (training.exchange(true)) return;
+
+    for (int s = 0; s < numScales; ++s) {
+        // Every piece-th piece of each untrained track, copied under the lock
+        // so sources can come and go while the k-means runs.
+        std::map<TrackKey, std::vector<float>> samples;
+        {
+            const juce::ScopedLock sl(lock);
+            juce::int64 numWindows = 0;
+            std::map<TrackKey, juce::int64> numPieces;
+            for (const auto& source : sources) {
+                for (const auto& [key, track] : source->tracks) {
+                    numPieces[key] += static_cast<juce::int64>(track.grids[static_cast<size_t>(s)].values.size() / pieceSize);
+                }
+                if (!source->tracks.empty())
+                    numWindows += getNumWindows(source->tracks.begin()->second.grids[static_cast<size_t>(s)]);
+            }
+            if (numWindows < options.approximateThreshold) continue;
+
+            for (const auto& [key, total] : numPieces) {
+                if (codebooks[static_cast<size_t>(s)].count(key) > 0) continue;
+
+                auto stride = juce::jmax(juce::int64(1), total / trainingSamples);
+                auto& pieces = samples[key];
+                juce::int64 index = 0;
+                for (const auto& source : sources) {
+                    auto it = source->tracks.find(key);
+                    if (it == source->tracks.end()) continue;
+                    const auto& values = it->second.grids[static_cast<size_t>(s)].values;
+                    for (size_t p = 0; p < values.size() / pieceSize; ++p, ++index) {
+                        if (index % stride == 0)
+                            pieces.insert(pieces.end(), values.begin() + static_cast<std::ptrdiff_t>(p * pieceSize),
+                                values.begin() + static_cast<std::ptrdiff_t>((p + 1) * pieceSize));
+                    }
+                }
+            }
+        }
+
+        for (auto& [key, pieces] : samples) {
+            auto codebook = trainCodebook(pieces);
+            if (codebook.numCentroids == 0) continue;
+
+            const juce::ScopedLock sl(lock);
+            if (!codebooks[static_cast<size_t>(s)].emplace(key, std::move(codebook)).second) continue;
+            const auto& installed = codebooks[static_cast<size_t>(s)].at(key);
+            for (auto& source : sources) {
+                auto it = source->tracks.find(key);
+                if (it != source->tracks.end())
+                    encode(it->second.grids[static_cast<size_t>(s)], installed);
+            }
+        }
+    }
+    training = false;
+}
+
+SimilarityIndex::SearchResult SimilarityIndex::findNearest(const FeatureMap& features, double startTime,
+    double endTime, int numMatches, const juce::File& queryFile) const {
+
+    SearchResult result;
+    if (numMatches <= 0 || endTime <= startTime) return result;
+
+    int scale = 0;
+    for (int s = 1; s < numScales; ++s) {
+        if (std::abs(std::log((endTime - startTime) / scales[s]))
+            < std::abs(std::log((endTime - startTime) / scales[scale])))
+            scale = s;
+    }
+    double windowSeconds = scales[scale];
+    result.windowSeconds = windowSeconds;
+
+    const juce::ScopedLock sl(lock);
+
+    auto queryKeys = getTrackKeys(features);
+    std::vector<TrackKey> layout;
+    for (const auto& key : queryKeys) {
+        if (std::all_of(sources.begin(), sources.end(),
+            [&key](const auto& source) { return source->tracks.count(key) > 0; }))
+            layout.push_back(key);
+    }
+    if (layout.empty())
+        layout = queryKeys;
+    if (layout.empty()) return result;
+
+    std::vector<const Source*> searched;
+    for (const auto& source : sources) {
+        if (std::all_of(layout.begin(), layout.end(),
+            [&source](const TrackKey& key) { return source->tracks.count(key) > 0; }))
+            searched.push_back(source.get());
+        else
+            ++result.numSkipped;
+    }
+    result.numTracks = static_cast<int>(layout.size());
+    result.numSources = static_cast<int>(searched.size());
+
+    // Inverse variance of each track over everything searched.
+    int numPoints = options.pointsPerTrack;
+    std::vector<float> weights;
+    for (const auto& key : layout) {
+        double sum = 0.0, sumSquares = 0.0, count = 0.0;
+        for (const auto* source : searched) {
+            const auto& track = source->tracks.at(key);
+            sum += track.sum;
+            sumSquares += track.sumSquares;
+            count += track.count;
+        }
+        double mean = count > 0.0 ? sum / count : 0.0;
+        double variance = count > 0.0 ? sumSquares / count - mean * mean : 0.0;
+        weights.push_back(variance > 1.0e-12 ? static_cast<float>(1.0 / variance) : 1.0f);
+    }
+
+    std::vector<float> query(layout.size() * static_cast<size_t>(numPoints));
+    for (size_t t = 0; t < layout.size(); ++t) {
+        sampleTrack(features.at(layout[t].featureName)[static_cast<size_t>(layout[t].outputIndex)],
+            (endTime - startTime) / numPoints, numPoints, startTime, query.data() + t * static_cast<size_t>(numPoints));
+    }
+
+    int hop = numPoints / 2;
+    int piecesPerWindow = numPoints / pieceSize;
+    auto gridOf = [scale](const Source& source, const TrackKey& key) -> const Grid& {
+        return source.tracks.at(key).grids[static_cast<size_t>(scale)];
+    };
+    auto exactDistance = [&](const Source& source, int window) {
+        float distance = 0.0f;
+        for (size_t t = 0; t < layout.size(); ++t) {
+            distance += weights[t] * squaredDistance(query.data() + t * static_cast<size_t>(numPoints),
+                gridOf(source, layout[t]).values.data() + window * hop, numPoints);
+        }
+        return distance;
+    };
+
+    const auto& scaleCodebooks = codebooks[static_cast<size_t>(scale)];
+    result.approximate = std::all_of(layout.begin(), layout.end(),
+        [&scaleCodebooks](const TrackKey& key) { return scaleCodebooks.count(key) > 0; });
+
+    // Weighted distance from each query piece to every centroid of its track.
+    std::vector<std::vector<float>> tables;
+    if (result.approximate) {
+        for (size_t t = 0; t < layout.size(); ++t) {
+            const auto& codebook = scaleCodebooks.at(layout[t]);
+            std::vector<float> table(static_cast<size_t>(piecesPerWindow * codebook.numCentroids));
+            for (int j = 0; j < piecesPerWindow; ++j) {
+                for (int c = 0; c < codebook.numCentroids; ++c)
+                    table[static_cast<size_t>(j * codebook.numCentroids + c)] = weights[t] * squaredDistance(
+                        query.data() + t * static_cast<size_t>(numPoints) + j * pieceSize,
+                        codebook.centroids.data() + c * pieceSize, pieceSize);
+            }
+            tables.push_back(std::move(table));
+        }
+    }
+
+    struct Candidate {
+        float distance;
+        const Source* source;
+        int window;
+        bool operator<(const Candidate& other) const { return distance < other.distance; }
+    };
+    std::vector<Candidate> scored;
+    std::vector<const Grid*> grids(layout.size());
+
+    for (const auto* source : searched) {
+        for (size_t t = 0; t < layout.size(); ++t)
+            grids[t] = &gridOf(*source, layout[t]);
+
+        int numWindows = getNumWindows(*grids[0]);
+        bool isQuerySource = source->file == queryFile;
+        for (int w = 0; w < numWindows; ++w) {
+            double windowStart = w * windowSeconds / 2.0;
+            if (isQuerySource && windowStart < endTime && windowStart + windowSeconds > startTime) continue;
+
+            if (!result.approximate) {
+                scored.push_back({ exactDistance(*source, w), source, w });
+                continue;
+            }
+
+            float distance = 0.0f;
+            for (size_t t = 0; t < layout.size(); ++t) {
+                const auto* codes = grids[t]->codes.data() + w * hop / pieceSize;
+                int numCentroids = scaleCodebooks.at(layout[t]).numCentroids;
+                for (int j = 0; j < piecesPerWindow; ++j)
+                    distance += tables[t][static_cast<size_t>(j * numCentroids + codes[j])];
+            }
+            scored.push_back({ distance, source, w });
+        }
+    }
+
+    size_t numCandidates = juce::jmin(scored.size(), static_cast<size_t>(numMatches) * candidatesPerMatch);
+    if (result.approximate) {
+        // Only the closest approximate matches are measured exactly.
+        size_t numRerank = juce::jmin(scored.size(), juce::jmax(static_cast<size_t>(minRerank), numCandidates * 4));
+        std::nth_element(scored.begin(), scored.begin() + static_cast<std::ptrdiff_t>(numRerank), scored.end());
+        scored.resize(numRerank);
+        for (auto& candidate : scored)
+            candidate.distance = exactDistance(*candidate.source, candidate.window);
+    }
+    std::partial_sort(scored.begin(), scored.begin() + static_cast<std::ptrdiff_t>(numCandidates), scored.end());
+
+    // Neighbouring windows overlap and look alike; keep the best of each run.
+    for (size_t i = 0; i < numCandidates && static_cast<int>(result.matches.size()) < numMatches; ++i) {
+        const auto& candidate = scored[i];
+        double start = candidate.window * windowSeconds / 2.0;
+        bool overlaps = std::any_of(result.matches.begin(), result.matches.end(), [&](const Match& match) {
+            return match.file == candidate.source->file && std::abs(match.startTime - start) < windowSeconds;
+        });
+        if (overlaps) continue;
+
+        result.matches.push_back({ candidate.source->file, start, start + windowSeconds,
+            std::sqrt(candidate.distance / static_cast<float>(layout.size() * static_cast<size_t>(numPoints))) });
+    }
+    return result;
+}
@@ -0,0 +1,138 @@
+// SimilarityIndex.h
+#pragma once
+
+#include <JuceHeader.h>
+#include "FeatureExtractors.h"
+#include <array>
+
+// Finds the regions of analysed files whose tracks look like a given region.
+//
+// Each source is kept as its tracks sampled on uniform grids, one per fixed
+// window length (scale): pointsPerTrack grid points span a window and a
+// window starts every half window. A window's vector is a run of the grid of
+// every track the query compares, so sources are indexed one at a time,
+// don't keep their tracks, and any set of tracks can be queried. Tracks are
+// weighted by the inverse of their variance over the index so loud and quiet
+// features count the same; the mean drops out of a difference, so adding a
+// source only adds to running sums.
+//
+// A query uses the scale nearest its length and scans the windows with a
+// squared-distance kernel. Once a scale holds approximateThreshold windows,
+// trainIfNeeded also product-quantises its grids: each track's grid is cut
+// into 4-point pieces, each replaced by the nearest of up to 256 k-means
+// centroids trained for that track. A query then sums per-piece distances
+// from a small table for every window and measures only the closest few
+// hundred exactly.
+//
+// Thread safe: sources are added by the analysis workers as files finish.
+class SimilarityIndex {
+public:
+    using FeatureMap = std::map<juce::String, std::vector<BreakpointList>>;
+
+    struct Options {
+        int pointsPerTrack = 16;
+        int approximateThreshold = 50000;
+    };
+
+    struct Match {
+        juce::File file;
+        double startTime = 0.0;
+        double endTime = 0.0;
+        float distance = 0.0f;
+    };
+
+    struct SearchResult {
+        std::vector<Match> matches;
+        double windowSeconds = 0.0; // the scale searched, which every match spans
+        int numTracks = 0;          // tracks compared
+        int numSources = 0;         // files searched
+        int numSkipped = 0;         // files lacking one of those tracks
+        bool approximate = false;
+    };
+
+    static constexpr int numScales = 5;
+    static constexpr double scales[numScales] = { 0.5, 1.0, 2.0, 4.0, 8.0 };
+
+    SimilarityIndex();
+    explicit SimilarityIndex(Options options);
+
+    // Outputs of these features are never indexed, e.g. event tracks, whose
+    // sparse points say little when sampled at fixed times.
+    void setIgnoredFeatures(const juce::StringArray& featureNames);
+
+    // Samples the tracks of a file, replacing what was indexed for it.
+    void setSource(const juce::File& file, const FeatureMap& features);
+    void removeSource(const juce::File& file);
+    void clear();
+    // Trains the quantiser of every track at every scale that has grown past
+    // approximateThreshold windows. Slow, so meant for a background thread;
+    // searches carry on meanwhile.
+    void trainIfNeeded();
+
+    int getNumSources() const;
+    juce::int64 getMemoryBytes() const;
+
+    // The numMatches windows closest to [startTime, endTime] of the given
+    // tracks, best first. The query's tracks that every source has are
+    // compared; if there are none, all of the query's are, and the sources
+    // lacking one are skipped. Windows overlapping the query itself in
+    // queryFile, or one another, are left out.
+    SearchResult findNearest(const FeatureMap& features, double startTime, double endTime,
+        int numMatches, const juce::File& queryFile) const;
+
+private:
+    struct TrackKey {
+        juce::String featureName;
+        int outputIndex = 0;
+
+        bool operator<(const TrackKey& other) const;
+    };
+
+    struct Grid {
+        std::vector<float> values;      // the track every window / pointsPerTrack seconds
+        std::vector<juce::uint8> codes; // one per piece once the scale's track is quantised
+    };
+
+    struct SourceTrack {
+        std::array<Grid, numScales> grids;
+        double sum = 0.0; // over the finest grid, for the weights
+        double sumSquares = 0.0;
+        double count = 0.0;
+    };
+
+    struct Source {
+        juce::File file;
+        std::map<TrackKey, SourceTrack> tracks;
+    };
+
+    struct Codebook {
+        int numCentroids = 0;
+        std::vector<float> centroids; // numCentroids x pieceSize
+    };
+
+    static constexpr int pieceSize = 4;
+    static constexpr int maxCentroids = 256;
+    static constexpr int trainingSamples = 8192;
+    static constexpr int trainingIterations = 6;
+    static constexpr int candidatesPerMatch = 8;
+    static constexpr int minRerank = 256;
+
+    Options options;
+
+    mutable juce::CriticalSection lock;
+    juce::StringArray ignoredFeatures;
+    std::vector<std::unique_ptr<Source>> sources;
+    std::array<std::map<TrackKey, Codebook>, numScales> codebooks;
+    std::atomic<bool> training{ false };
+
+    int getNumWindows(const Grid& grid) const;
+    std::vector<TrackKey> getTrackKeys(const FeatureMap& features) const;
+    static void sampleTrack(const BreakpointList& points, double step, int numPoints, double startTime,
+        float* dest);
+    static void encode(Grid& grid, const Codebook& codebook);
+    static int nearestCentroid(const Codebook& codebook, const float* piece);
+    static Codebook trainCodebook(const std::vector<float>& pieces);
+    static float squaredDistance(const float* a, const float* b, int size);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SimilarityIndex)
+};
@@ -0,0 +1,121 @@
+// TestSignals.cpp
+
+#include "TestSignals.h"
+
+namespace {
+
+TestSignal makeSignal(const juce::String& name, double sampleRate, double seconds, int numChannels) {
+    TestSignal signal;
+    signal.name = name;
+    signal.sampleRate = sampleRate;
+    signal.audio.setSize(juce::jmax(1, numChannels),
+        juce::jmax(1, static_cast<int>(sampleRate * seconds)));
+    signal.audio.clear();
+    return signal;
+}
+
+} // namespace
+
+TestSignal TestSignals::sineSweep(double sampleRate, double seconds, int numChannels,
+    double startHz, double endHz) {
+
+    auto signal = makeSignal("sweep", sampleRate, seconds, numChannels);
+    int numSamples = signal.audio.getNumSamples();
+
+    endHz = juce::jmin(endHz, sampleRate * 0.45);
+    double rate = std::log(endHz / startHz) / numSamples;
+    double phase = 0.0;
+
+    float* data = signal.audio.getWritePointer(0);
+    for (int i = 0; i < numSamples; ++i) {
+        data[i] = 0.5f * static_cast<float>(std::sin(phase));
+        phase += juce::MathConstants<double>::twoPi * startHz * std::exp(rate * i) / sampleRate;
+    }
+
+    for (int ch = 1; ch < signal.audio.getNumChannels(); ++ch)
+        signal.audio.copyFrom(ch, 0, signal.audio, 0, 0, numSamples);
+    return signal;
+}
+
+TestSignal TestSignals::whiteNoise(double sampleRate, double seconds, int numChannels, juce::int64 seed) {
+    auto signal = makeSignal("noise", sampleRate, seconds, numChannels);
+    juce::Random random(seed);
+
+    for (int ch = 0; ch < signal.audio.getNumChannels(); ++ch) {
+        float* data = signal.audio.getWritePointer(ch);
+        for (int i = 0; i < signal.audio.getNumSamples(); ++i)
+            data[i] = random.nextFloat() - 0.5f;
+    }
+    return signal;
+}
+
+TestSignal TestSignals::impulseTrain(double sampleRate, double seconds, int numChannels,
+    double ratePerSecond) {
+
+    auto signal = makeSignal("impulses", sampleRate, seconds, numChannels);
+    int numSamples = signal.audio.getNumSamples();
+    int period = juce::jmax(1, static_cast<int>(sampleRate / ratePerSecond));
+    float decay = static_cast<float>(std::exp(-1.0 / (0.005 * sampleRate)));
+
+    float* data = signal.audio.getWritePointer(0);
+    float tail = 0.0f;
+    for (int i = 0; i < numSamples; ++i) {
+        if (i % period == 0)
+            tail = 0.9f;
+        data[i] = tail;
+        tail = -tail * decay;
+    }
+
+    for (int ch = 1; ch < signal.audio.getNumChannels(); ++ch)
+        signal.audio.copyFrom(ch, 0, signal.audio, 0, 0, numSamples);
+    return signal;
+}
+
+TestSignal TestSignals::decorrelatedStereo(double sampleRate, double seconds, juce::int64 seed) {
+    auto signal = makeSignal("stereo", sampleRate, seconds, 2);
+    int numSamples = signal.audio.getNumSamples();
+    juce::Random random(seed);
+
+    float* left = signal.audio.getWritePointer(0);
+    float* right = signal.audio.getWritePointer(1);
+    double twoPi = juce::MathConstants<double>::twoPi;
+
+    for (int i = 0; i < numSamples; ++i) {
+        double t = i / sampleRate;
+        float shared = random.nextFloat() - 0.5f;
+        float independent = random.nextFloat() - 0.5f;
+
+        // Correlation moves between 1 and 0, the tone pans side to side.
+        float correlation = static_cast<float>(0.5 + 0.5 * std::sin(twoPi * 0.13 * t));
+        float pan = static_cast<float>(0.5 + 0.5 * std::sin(twoPi * 0.29 * t));
+        float tone = 0.3f * static_cast<float>(std::sin(twoPi * 440.0 * t));
+
+        left[i] = 0.3f * shared + tone * (1.0f - pan);
+        right[i] = 0.3f * (correlation * shared + (1.0f - correlation) * independent) + tone * pan;
+    }
+    return signal;
+}
+
+std::vector<TestSignal> TestSignals::makeStandardSet(double sampleRate, double seconds, juce::int64 seed) {
+    std::vector<TestSignal> signals;
+    signals.push_back(sineSweep(sampleRate, seconds, 2));
+    signals.push_back(whiteNoise(sampleRate, seconds, 2, seed));
+    signals.push_back(impulseTrain(sampleRate, seconds, 2, 8.0));
+    signals.push_back(decorrelatedStereo(sampleRate, seconds, seed + 1));
+    return signals;
+}
+
+bool TestSignals::loadFile(const juce::File& file, TestSignal& dest) {
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr || reader->lengthInSamples > std::numeric_limits<int>::max())
+        return false;
+
+    int numSamples = static_cast<int>(reader->lengthInSamples);
+    dest.name = file.getFileNameWithoutExtension();
+    dest.sampleRate = reader->sampleRate;
+    dest.audio.setSize(static_cast<int>(reader->numChannels), numSamples);
+    return reader->read(&dest.audio, 0, numSamples, 0, true, true);
+}
@@ -0,0 +1,35 @@
+// TestSignals.h
+#pragma once
+
+#include <JuceHeader.h>
+
+// Deterministic synthetic material for measuring and checking extractors.
+// The same seed always gives the same samples, so results can be compared
+// between builds and machines.
+struct TestSignal {
+    juce::String name;
+    juce::AudioBuffer<float> audio;
+    double sampleRate = 44100.0;
+};
+
+class TestSignals {
+public:
+    // Exponential sweep between two frequencies, the same on every channel.
+    static TestSignal sineSweep(double sampleRate, double seconds, int numChannels,
+        double startHz = 20.0, double endHz = 20000.0);
+
+    // Uniform white noise, independent per channel.
+    static TestSignal whiteNoise(double sampleRate, double seconds, int numChannels, juce::int64 seed);
+
+    // Single-sample clicks at a fixed rate with decaying tails.
+    static TestSignal impulseTrain(double sampleRate, double seconds, int numChannels, double ratePerSecond);
+
+    // Stereo noise whose inter-channel correlation and balance drift slowly,
+    // with a tone wandering across the image.
+    static TestSignal decorrelatedStereo(double sampleRate, double seconds, juce::int64 seed);
+
+    // One of each of the above.
+    static std::vector<TestSignal> makeStandardSet(double sampleRate, double seconds, juce::int64 seed);
+
+    static bool loadFile(const juce::File& file, TestSignal& dest);
+};
@@ -0,0 +1,180 @@
+// TraceRecorder.cpp
+
+#include "TraceRecorder.h"
+
+std::atomic<bool> TraceRecorder::recording{ false };
+std::atomic<int> TraceRecorder::generation{ 0 };
+std::atomic<juce::int64> TraceRecorder::startTicks{ 0 };
+
+TraceRecorder::Registry& TraceRecorder::getRegistry() {
+    static Registry registry;
+    return registry;
+}
+
+TraceRecorder::ThreadSlot::~ThreadSlot() {
+    if (buffer != nullptr)
+        buffer->inUse.store(false, std::memory_order_release);
+}
+
+void TraceRecorder::start() {
+    startTicks.store(juce::Time::getHighResolutionTicks());
+    generation.fetch_add(1);
+    recording.store(true);
+}
+
+void TraceRecorder::stop() {
+    recording.store(false);
+}
+
+TraceRecorder::ThreadBuffer* TraceRecorder::getBufferForThisThread() {
+    thread_local ThreadSlot slot;
+    if (slot.buffer != nullptr)
+        return slot.buffer;
+
+    // First event on this thread: the only time recording locks or allocates.
+    auto& registry = getRegistry();
+    const juce::ScopedLock sl(registry.lock);
+    int current = generation.load();
+
+    for (auto& buffer : registry.buffers) {
+        if (!buffer->inUse.load(std::memory_order_acquire) && buffer->generation != current) {
+            slot.buffer = buffer.get();
+            break;
+        }
+    }
+
+    if (slot.buffer == nullptr) {
+        registry.buffers.push_back(std::make_unique<ThreadBuffer>());
+        slot.buffer = registry.buffers.back().get();
+        slot.buffer->events.reset(new Event[eventsPerThread]);
+    }
+
+    auto* buffer = slot.buffer;
+    buffer->inUse.store(true);
+    buffer->threadIndex = registry.nextThreadIndex++;
+
+    if (auto* thread = juce::Thread::getCurrentThread())
+        buffer->threadName = thread->getThreadName();
+    else if (juce::MessageManager::existsAndIsCurrentThread())
+        buffer->threadName = "Message Thread";
+    else
+        buffer->threadName = "Thread " + juce::String(buffer->threadIndex);
+
+    return buffer;
+}
+
+bool TraceRecorder::record(ThreadBuffer& buffer, const char* name, const juce::String& detail, char phase) {
+    auto ticks = juce::Time::getHighResolutionTicks();
+    int index = buffer.count.load(std::memory_order_relaxed);
+
+    // A begin also needs room for its own end and those of the scopes
+    // already open.
+    int needed = phase == 'B' ? buffer.openScopes + 2 : 1;
+    if (index + needed > eventsPerThread) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    auto& event = buffer.events[index];
+    event.name = name;
+    event.detail = detail;
+    event.ticks = ticks;
+    event.phase = phase;
+    buffer.openScopes += phase == 'B' ? 1 : -1;
+    buffer.count.store(index + 1, std::memory_order_release);
+    return true;
+}
+
+int TraceRecorder::begin(const char* name, const juce::String& detail) {
+    auto* buffer = getBufferForThisThread();
+
+    // Only the owning thread writes to its buffer, so it clears out the
+    // previous recording itself.
+    int current = generation.load(std::memory_order_acquire);
+    if (buffer->generation.load(std::memory_order_relaxed) != current) {
+        buffer->count.store(0, std::memory_order_relaxed);
+        buffer->dropped.store(0, std::memory_order_relaxed);
+        buffer->openScopes = 0;
+        buffer->generation.store(current, std::memory_order_release);
+    }
+    return record(*buffer, name, detail, 'B') ? current : notRecorded;
+}
+
+void TraceRecorder::end(const char* name, int token) {
+    if (token == notRecorded || generation.load(std::memory_order_acquire) != token) return;
+
+    auto* buffer = getBufferForThisThread();
+    if (buffer->generation.load(std::memory_order_relaxed) == token && buffer->openScopes > 0)
+        record(*buffer, name, {}, 'E');
+}
+
+juce::int64 TraceRecorder::getNumDroppedEvents() {
+    auto& registry = getRegistry();
+    const juce::ScopedLock sl(registry.lock);
+
+    juce::int64 dropped = 0;
+    for (auto& buffer : registry.buffers) {
+        if (buffer->generation == generation.load())
+            dropped += buffer->dropped.load();
+    }
+    return dropped;
+}
+
+juce::Result TraceRecorder::writeTo(const juce::File& file) {
+    juce::FileOutputStream stream(file);
+    if (!stream.openedOk())
+        return juce::Result::fail("Can't write " + file.getFullPathName());
+
+    stream.setPosition(0);
+    stream.truncate();
+
+    auto& registry = getRegistry();
+    const juce::ScopedLock sl(registry.lock);
+
+    int current = generation.load();
+    double microsecondsPerTick = 1.0e6 / static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+    auto origin = startTicks.load();
+    bool first = true;
+
+    auto separator = [&] {
+        stream << (first ? "\n" : ",\n");
+        first = false;
+    };
+
+    stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    for (auto& buffer : registry.buffers) {
+        if (buffer->generation != current) continue;
+
+        int count = buffer->count.load(std::memory_order_acquire);
+        juce::String tid(buffer->threadIndex);
+
+        separator();
+        stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+            << ",\"args\":{\"name\":" << juce::JSON::toString(juce::var(buffer->threadName)) << "}}";
+
+        for (int i = 0; i < count; ++i) {
+            const auto& event = buffer->events[i];
+            auto ts = juce::String(static_cast<double>(event.ticks - origin) * microsecondsPerTick, 3);
+
+            separator();
+            if (event.phase == 'B') {
+                juce::String name = event.detail.isEmpty() ? juce::String(event.name)
+                    : event.detail + ": " + event.name;
+                stream << "{\"name\":" << juce::JSON::toString(juce::var(name))
+                    << ",\"cat\":\"analysis\",\"ph\":\"B\",\"ts\":" << ts
+                    << ",\"pid\":1,\"tid\":" << tid << "}";
+            }
+            else {
+                stream << "{\"ph\":\"E\",\"ts\":" << ts << ",\"pid\":1,\"tid\":" << tid << "}";
+            }
+        }
+    }
+
+    stream << "\n]}\n";
+    stream.flush();
+
+    if (stream.getStatus().failed())
+        return stream.getStatus();
+    return juce::Result::ok();
+}
@@ -0,0 +1,94 @@
+// TraceRecorder.h
+#pragma once
+
+#include <JuceHeader.h>
+
+// Records begin/end events from any thread and writes them in the Trace
+// Event Format that chrome://tracing and Perfetto open.
+//
+// Each thread appends to its own fixed-size buffer, allocated the first
+// time that thread records anything; appending is a store and a release of
+// the count, with no lock or allocation, so tracing barely moves the timings
+// it shows. A full buffer drops further begin events and counts them; each
+// begin that was kept holds a slot for its end, so every recorded scope
+// closes. Recording is process-wide, since threads (batch workers, the live
+// analyzer) outlive any one owner.
+class TraceRecorder {
+public:
+    static void start();
+    static void stop();
+    static bool isRecording() { return recording.load(std::memory_order_relaxed); }
+
+    // Call after stop(). Threads keep their buffers until the next start().
+    static juce::Result writeTo(const juce::File& file);
+    static juce::int64 getNumDroppedEvents();
+
+    // name must be a string literal or otherwise outlive the recording.
+    // begin returns a token for the matching end, which is only recorded if
+    // the begin was, into the same recording; a scope that outlives stop()
+    // still closes unless a new recording has started.
+    static int begin(const char* name, const juce::String& detail = {});
+    static void end(const char* name, int token);
+
+    static constexpr int notRecorded = -1;
+
+    class Scope {
+    public:
+        Scope(const char* n, const juce::String& detail = {}) : name(n) {
+            if (isRecording()) token = begin(name, detail);
+        }
+        ~Scope() {
+            end(name, token);
+        }
+
+    private:
+        const char* name;
+        int token = notRecorded;
+
+        JUCE_DECLARE_NON_COPYABLE(Scope)
+    };
+
+private:
+    struct Event {
+        const char* name = nullptr;
+        juce::String detail;
+        juce::int64 ticks = 0;
+        char phase = 'B';
+    };
+
+    struct ThreadBuffer {
+        int threadIndex = 0;
+        juce::String threadName;
+        std::unique_ptr<Event[]> events;
+        std::atomic<int> count{ 0 };
+        std::atomic<juce::int64> dropped{ 0 };
+        std::atomic<int> generation{ -1 }; // read by writeTo on other threads
+        int openScopes = 0;                // begins awaiting their end; owning thread only
+        std::atomic<bool> inUse{ true };
+    };
+
+    // Buffers are never freed, so events of threads that have already
+    // exited (a finished thread pool) are still written out. A buffer whose
+    // thread has gone is reused by a new thread in a later recording.
+    struct Registry {
+        juce::CriticalSection lock;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+        int nextThreadIndex = 1;
+    };
+
+    // Hands the buffer back when its thread exits.
+    struct ThreadSlot {
+        ThreadBuffer* buffer = nullptr;
+        ~ThreadSlot();
+    };
+
+    static constexpr int eventsPerThread = 1 << 16;
+
+    static std::atomic<bool> recording;
+    static std::atomic<int> generation;
+    static std::atomic<juce::int64> startTicks;
+
+    static Registry& getRegistry();
+    static ThreadBuffer* getBufferForThisThread();
+    static bool record(ThreadBuffer& buffer, const char* name, const juce::String& detail, char phase);
+};
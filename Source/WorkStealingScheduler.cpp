@@ -0,0 +1,104 @@
+// WorkStealingScheduler.cpp
+
+#include "WorkStealingScheduler.h"
+
+namespace {
+
+// Which scheduler and queue the calling thread works for, if any.
+thread_local const WorkStealingScheduler* currentScheduler = nullptr;
+thread_local size_t currentQueue = 0;
+
+} // namespace
+
+WorkStealingScheduler::WorkStealingScheduler(int numThreads) {
+    if (numThreads <= 0)
+        numThreads = juce::SystemStats::getNumCpus();
+
+    for (int i = 0; i < numThreads; ++i)
+        queues.push_back(std::make_unique<Queue>());
+
+    for (size_t i = 0; i < queues.size(); ++i) {
+        workers.push_back(std::make_unique<Worker>(*this, i));
+        workers.back()->startThread();
+    }
+}
+
+WorkStealingScheduler::~WorkStealingScheduler() {
+    shutdown();
+}
+
+void WorkStealingScheduler::shutdown() {
+    for (auto& worker : workers)
+        worker->signalThreadShouldExit();
+    for (auto& worker : workers) {
+        workAvailable.signal();
+        worker->stopThread(-1);
+    }
+}
+
+void WorkStealingScheduler::submit(Task task) {
+    size_t index = currentScheduler == this
+        ? currentQueue
+        : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+
+    pendingTasks.fetch_add(1);
+    {
+        const juce::ScopedLock sl(queues[index]->lock);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    workAvailable.signal();
+}
+
+void WorkStealingScheduler::waitUntilIdle() {
+    while (pendingTasks.load() > 0)
+        allDone.wait(idleWaitMs);
+}
+
+bool WorkStealingScheduler::popLocal(size_t index, Task& task) {
+    auto& queue = *queues[index];
+    const juce::ScopedLock sl(queue.lock);
+    if (queue.tasks.empty()) return false;
+
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingScheduler::steal(size_t thiefIndex, Task& task) {
+    // Start with the next worker along so thieves spread over the victims.
+    for (size_t offset = 1; offset < queues.size(); ++offset) {
+        auto& queue = *queues[(thiefIndex + offset) % queues.size()];
+        const juce::ScopedTryLock sl(queue.lock);
+        if (!sl.isLocked() || queue.tasks.empty()) continue;
+
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingScheduler::runTask(Task& task) {
+    task();
+    task = nullptr;
+
+    if (pendingTasks.fetch_sub(1) == 1)
+        allDone.signal();
+}
+
+WorkStealingScheduler::Worker::Worker(WorkStealingScheduler& o, size_t i)
+    : juce::Thread("Work Stealing Worker " + juce::String(static_cast<int>(i))), owner(o), index(i) {}
+
+void WorkStealingScheduler::Worker::run() {
+    currentScheduler = &owner;
+    currentQueue = index;
+
+    Task task;
+    while (!threadShouldExit()) {
+        if (owner.popLocal(index, task) || owner.steal(index, task)) {
+            owner.runTask(task);
+            continue;
+        }
+        owner.workAvailable.wait(idleWaitMs);
+    }
+}
@@ -0,0 +1,69 @@
+// WorkStealingScheduler.h
+#pragma once
+
+#include <JuceHeader.h>
+#include <deque>
+#include <functional>
+
+// Fixed set of worker threads, each with its own task queue.
+//
+// A worker runs its own queue newest first, so the tasks a task spawns run
+// next on the same thread while their inputs are still in cache. A worker
+// whose queue is empty steals the oldest task from another, which keeps every
+// core busy when tasks differ wildly in cost without a shared queue that all
+// threads contend on.
+class WorkStealingScheduler {
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkStealingScheduler(int numThreads = 0); // 0 uses every core
+    ~WorkStealingScheduler();
+
+    // Any thread. A task submitted from one of this scheduler's workers goes
+    // onto that worker's own queue; anything else is spread round-robin.
+    void submit(Task task);
+
+    // Blocks until every submitted task, including those submitted by other
+    // tasks while waiting, has finished.
+    void waitUntilIdle();
+
+    // Stops and joins the workers once their running tasks end; tasks still
+    // queued are dropped. Safe to call more than once, and the destructor
+    // calls it. The scheduler stays valid, so a task still running when it's
+    // called can submit without crashing.
+    void shutdown();
+
+    int getNumThreads() const { return static_cast<int>(workers.size()); }
+
+private:
+    struct Queue {
+        juce::CriticalSection lock;
+        std::deque<Task> tasks;
+    };
+
+    class Worker : public juce::Thread {
+    public:
+        Worker(WorkStealingScheduler& owner, size_t index);
+        void run() override;
+
+    private:
+        WorkStealingScheduler& owner;
+        size_t index;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::atomic<size_t> nextQueue{ 0 };
+    std::atomic<int> pendingTasks{ 0 };
+    juce::WaitableEvent workAvailable;
+    juce::WaitableEvent allDone;
+
+    static constexpr int idleWaitMs = 10;
+
+    bool popLocal(size_t index, Task& task);
+    bool steal(size_t thiefIndex, Task& task);
+    void runTask(Task& task);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WorkStealingScheduler)
+};